@@ -0,0 +1,187 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef AVL_MAP_H
+#define AVL_MAP_H
+
+#include <functional>
+#include "AVL_tree.h"
+
+/* Map from Key to Value, stored as an AVL_tree of entries ordered by key only.
+ *
+ * Entries are found by key through the tree's transparent lookups, so no entry has to be
+ * built to search for one. Iterators return the entries by reference and the value of an
+ * entry may be modified in place (the key may not). */
+template <typename Key, typename Value, typename Compare = std::less<Key>, template <typename> class Allocator = Node_pool>
+class AVL_map {
+    public:
+        class Entry {
+            public:
+                Key key;
+                mutable Value value;    // Not part of the order, so it can be changed through an iterator.
+
+                Entry( Key const & = Key(), Value const & = Value() );
+        };
+
+    private:
+        // Orders entries by their keys, and compares entries with bare keys directly.
+        class Entry_compare {
+            private:
+                Compare key_compare;
+
+            public:
+                typedef void is_transparent;
+
+                Entry_compare( Compare const & = Compare() );
+
+                bool operator()( Entry const &lhs, Entry const &rhs ) const;
+                bool operator()( Entry const &lhs, Key const &rhs ) const;
+                bool operator()( Key const &lhs, Entry const &rhs ) const;
+        };
+
+        AVL_tree<Entry, Entry_compare, Allocator> entries;
+
+    public:
+        typedef typename AVL_tree<Entry, Entry_compare, Allocator>::Iterator Iterator;
+
+        AVL_map();
+        explicit AVL_map( Compare const & );
+
+        bool empty() const;
+        int size() const;
+
+        Iterator begin();
+        Iterator end();
+        Iterator find( Key const & );
+        Iterator lower_bound( Key const & );
+        Iterator upper_bound( Key const & );
+        bool member( Key const & );
+
+        Value &operator[]( Key const & );
+
+        void clear();
+        bool insert( Key const &, Value const & );
+        bool erase( Key const & );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                    Map Public Member Functions                   //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+AVL_map<Key, Value, Compare, Allocator>::AVL_map():
+entries() {
+    // does nothing
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+AVL_map<Key, Value, Compare, Allocator>::AVL_map( Compare const &key_compare ):
+entries( Entry_compare( key_compare ) ) {
+    // does nothing
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::empty() const {
+    return entries.empty();
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+int AVL_map<Key, Value, Compare, Allocator>::size() const {
+    return entries.size();
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+typename AVL_map<Key, Value, Compare, Allocator>::Iterator AVL_map<Key, Value, Compare, Allocator>::begin() {
+    return entries.begin();
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+typename AVL_map<Key, Value, Compare, Allocator>::Iterator AVL_map<Key, Value, Compare, Allocator>::end() {
+    return entries.end();
+}
+
+// Returns an iterator to the entry with the given key, or end() if there is none.
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+typename AVL_map<Key, Value, Compare, Allocator>::Iterator AVL_map<Key, Value, Compare, Allocator>::find( Key const &key ) {
+    return entries.find( key );
+}
+
+// Returns an iterator to the first entry whose key is not lower than key, or end().
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+typename AVL_map<Key, Value, Compare, Allocator>::Iterator AVL_map<Key, Value, Compare, Allocator>::lower_bound( Key const &key ) {
+    return entries.lower_bound( key );
+}
+
+// Returns an iterator to the first entry whose key is higher than key, or end().
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+typename AVL_map<Key, Value, Compare, Allocator>::Iterator AVL_map<Key, Value, Compare, Allocator>::upper_bound( Key const &key ) {
+    return entries.upper_bound( key );
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::member( Key const &key ) {
+    return ( entries.find( key ) != entries.end() );
+}
+
+/* Returns the value stored under key, inserting a default value first if there is none.
+ * The tree is descended once; the entry is only built on a miss. */
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+Value &AVL_map<Key, Value, Compare, Allocator>::operator[]( Key const &key ) {
+    return entries.find_or_emplace( key, key )->value;
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+void AVL_map<Key, Value, Compare, Allocator>::clear() {
+    entries.clear();
+}
+
+// Inserts the entry ( key, value ). If the key already exists it returns false and the map is unchanged.
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::insert( Key const &key, Value const &value ) {
+    return entries.insert( Entry( key, value ) );
+}
+
+// Erases the entry with the given key. If there is none it returns false.
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::erase( Key const &key ) {
+    return entries.erase( key );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                              Entry                               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+AVL_map<Key, Value, Compare, Allocator>::Entry::Entry( Key const &entry_key, Value const &entry_value ):
+key( entry_key ),
+value( entry_value ) {
+    // does nothing
+}
+
+//////////////////////////////////////////////////////////////////////
+//                          Entry_compare                           //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+AVL_map<Key, Value, Compare, Allocator>::Entry_compare::Entry_compare( Compare const &comparator ):
+key_compare( comparator ) {
+    // does nothing
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::Entry_compare::operator()( Entry const &lhs, Entry const &rhs ) const {
+    return key_compare( lhs.key, rhs.key );
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::Entry_compare::operator()( Entry const &lhs, Key const &rhs ) const {
+    return key_compare( lhs.key, rhs );
+}
+
+template <typename Key, typename Value, typename Compare, template <typename> class Allocator>
+bool AVL_map<Key, Value, Compare, Allocator>::Entry_compare::operator()( Key const &lhs, Entry const &rhs ) const {
+    return key_compare( lhs, rhs.key );
+}
+
+#endif
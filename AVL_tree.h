@@ -4,9 +4,36 @@
  
  // Signature type methods provided by Douglas W. Harder https://ece.uwaterloo.ca/~dwharder/
 
+#ifndef AVL_TREE_H
+#define AVL_TREE_H
+
 #include <cassert>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include "Node_pool.h"
+#include "Tree_balance.h"
+#include "Eytzinger_index.h"
+#include "Profiling_hooks.h"
+
+// Transparent_key<Compare, Key>::type is Key if Compare defines is_transparent, and doesn't exist otherwise.
+template <typename Compare, typename Key, typename = void>
+struct Transparent_key {
+};
 
-template <typename Type>
+template <typename Compare, typename Key>
+struct Transparent_key<Compare, Key, typename std::conditional<true, void, typename Compare::is_transparent>::type> {
+    typedef Key type;
+};
+
+/* Values are ordered by Compare, a strict weak ordering as in std::set: two values are
+ * equal when neither is lower than the other. If Compare defines is_transparent, the
+ * lookups also accept any key that Compare can compare with Type.
+ * Allocator is a node allocator as described in Node_pool.h.
+ * Balance is a balancing policy as described in Tree_balance.h (strict AVL by default). */
+template <typename Type, typename Compare = std::less<Type>, template <typename> class Allocator = Node_pool,
+          typename Balance = AVL_balance>
 class AVL_tree {
 public:
     class Iterator;
@@ -16,6 +43,7 @@ private:
     public:
         Type node_value;
         int tree_height;
+        int subtree_size;           // Number of nodes in the sub-tree rooted at this node.
         
         // The left and right sub-trees
         Node *left_tree;
@@ -27,19 +55,22 @@ private:
         Node *next_node;
         
         // Member functions
-        Node( Type const & = Type() );
+        // The value is constructed in place from the arguments.
+        template <typename... Args>
+        explicit Node( Args &&... args );
+        
+        // Nodes live in the tree's allocator instead of being created with new/delete.
+        template <typename... Args>
+        static Node *create( Allocator<Node> &allocator, Args &&... args );
+        void destroy( Allocator<Node> &allocator );
         
         void update_height();
+        void update_size();
         
-        int height() const;
+        static int height( Node const *node );  // The height of an empty sub-tree is -1.
         bool is_leaf() const;
         Node *front();
         Node *back();
-        Node *find( Type const &obj );
-        
-        void clear();
-        bool insert( Type const &obj, Node *&to_this );
-        bool erase( Type const &obj, Node *&to_this );
         
         // Added this member functions for tree balancing purposes.
         bool check_balance( Node *&root );      // This method checks if a node is balanced.
@@ -51,16 +82,89 @@ private:
         void case_2_right(Node *&root);
         
         //friend function
-        void print( std::ostream &out, int tabs = 0);
+        static void print( Node const *node, std::ostream &out, int tabs = 0 );
     };
     
     Node *root_node;
     int tree_size;
+    Compare compare;
+    Allocator<Node> node_allocator;
     
     // Hint as to how to start your linked list of the nodes in order
     Node *front_sentinel;
     Node *back_sentinel;
     
+    // Bound on the height of any AVL or WAVL tree with fewer than 2^31 nodes (2 log2 n for
+    // WAVL), used to size the search path that insert and erase record on their way down.
+    static const int MAX_HEIGHT = 64;
+    
+    // Where a new value goes: the links followed from the root down to the empty link
+    // that will point to it, and its previous and next nodes. If an equal value is met
+    // instead, the search stops at its node.
+    struct Search_path {
+        Node **links[MAX_HEIGHT];
+        int depth;
+        Node *previous;
+        Node *next;
+        Node *found;
+    };
+    
+    // Lookups are templates so that the transparent overloads can share them.
+    template <typename Key>
+    Node *find_node( Key const & ) const;
+    template <typename Key>
+    Node *bound( Key const &, bool ) const;
+    template <typename Key>
+    int count_lower( Key const &, bool ) const;
+    template <typename Key>
+    Node *unlink_node( Key const & );
+    
+    template <typename Key>
+    bool find_position( Key const &, Search_path & );
+    void link_node( Node *, Search_path & );
+    void link_sentinels( Node *first, Node *last );
+    
+    // Helpers for the bulk operations. They work on sub-trees and leave the
+    // previous and next nodes untouched.
+    static Node *build_balanced( Node *&chain, int n );
+    static Node *join_nodes( Node *lower, Node *middle, Node *higher );
+    static Node *detach_front( Node *&root );
+    void split_nodes( Node *root, Type const &key, Node *&lower, Node *&higher ) const;
+    
+    // Enables the overloads that take any key when Compare is transparent.
+    template <typename Key>
+    using If_transparent = typename Transparent_key<Compare, Key>::type;
+    
+    enum Set_operation { SET_UNION, SET_INTERSECTION, SET_DIFFERENCE };
+    
+    /* Produces the values of a set operation between two trees in increasing order, as an
+     * input iterator that build_from_sorted can consume without an intermediate buffer.
+     * It walks both threaded lists in lockstep, or walks the smaller tree and searches
+     * the larger one when that is cheaper. */
+    class Set_walk {
+    private:
+        AVL_tree const *lhs_tree;
+        AVL_tree const *rhs_tree;
+        Set_operation operation;
+        bool probe;                 // Search the larger tree instead of walking it.
+        bool swapped;               // The trees were swapped so that the smaller one is walked.
+        Node *lhs_node;
+        Node *rhs_node;
+        Node *current_node;         // The value produced, or nullptr once the walk is over.
+        
+        void advance();
+        
+    public:
+        Set_walk();                 // The end of any walk.
+        Set_walk( AVL_tree const &lhs, AVL_tree const &rhs, Set_operation );
+        
+        Type const &operator*() const;
+        Set_walk &operator++();
+        bool operator!=( Set_walk const &rhs ) const;
+    };
+    
+    static void build_set_operation( AVL_tree const &lhs, AVL_tree const &rhs, AVL_tree &result, Set_operation );
+    
 public:
     class Iterator {
     private:
@@ -72,8 +176,10 @@ public:
         Iterator( AVL_tree *tree, Node *starting_node );
         
     public:
-        // DO NOT CHANGE THE SIGNATURES FOR ANY OF THESE
-        Type operator*() const;
+        // The value is returned by reference, so it is never copied. It must not be
+        // modified in a way that changes its order.
+        Type const &operator*() const;
+        Type const *operator->() const;
         Iterator &operator++();
         Iterator &operator--();
         bool operator==( Iterator const &rhs ) const;
@@ -83,16 +189,43 @@ public:
         friend class AVL_tree;
     };
     
+    /* Owns a node taken out of a tree by extract(), so that it can be inserted again (into
+     * the same or another tree) without destroying and reconstructing its value. The handle
+     * keeps a copy of the allocator, so it stays valid after the tree is destroyed. */
+    class Node_handle {
+    private:
+        Node *extracted_node;
+        Allocator<Node> node_allocator;
+        
+        Node_handle( Node *node, Allocator<Node> const &allocator );
+        
+    public:
+        Node_handle();
+        Node_handle( Node_handle && );
+        Node_handle &operator=( Node_handle && );
+        ~Node_handle();
+        
+        Node_handle( Node_handle const & ) = delete;
+        Node_handle &operator=( Node_handle const & ) = delete;
+        
+        bool empty() const;
+        Type &value() const;        // The value may be changed before it is inserted again.
+        
+        friend class AVL_tree;
+    };
+    
     // DO NOT CHANGE THE SIGNATURES FOR ANY OF THESE
     AVL_tree();
     ~AVL_tree();
     
+    explicit AVL_tree( Compare const & );
+    
     bool empty() const;
     int size() const;
     int height() const;
     
-    Type front() const;
-    Type back() const;
+    Type const &front() const;
+    Type const &back() const;
     
     Iterator begin();
     Iterator end();
@@ -100,56 +233,124 @@ public:
     Iterator rend();
     Iterator find( Type const & );
     
+    // Order statistics
+    Iterator select( int );
+    int rank( Type const & ) const;
+    
+    // Range queries over the closed interval [lo, hi]
+    Iterator lower_bound( Type const & );
+    Iterator upper_bound( Type const & );
+    template <typename Function>
+    int range( Type const &lo, Type const &hi, Function visit );
+    int count_range( Type const &lo, Type const &hi ) const;
+    
     void clear();
     bool insert( Type const & );
     bool erase( Type const & );
     
+    // Insertion without copying
+    bool insert( Type && );
+    template <typename... Args>
+    bool emplace( Args &&... args );
+    template <typename Key, typename... Args>
+    Iterator find_or_emplace( Key const &, Args &&... args );
+    
+    // Moving nodes between trees
+    Node_handle extract( Type const & );
+    bool insert( Node_handle && );
+    
+    // Heterogeneous lookups, only available if Compare is transparent
+    template <typename Key>
+    Iterator find( Key const &, If_transparent<Key> * = nullptr );
+    template <typename Key>
+    Iterator lower_bound( Key const &, If_transparent<Key> * = nullptr );
+    template <typename Key>
+    Iterator upper_bound( Key const &, If_transparent<Key> * = nullptr );
+    template <typename Key>
+    int rank( Key const &, If_transparent<Key> * = nullptr ) const;
+    template <typename Key>
+    bool erase( Key const &, If_transparent<Key> * = nullptr );
+    template <typename Key>
+    Node_handle extract( Key const &, If_transparent<Key> * = nullptr );
+    
+    // Bulk operations
+    template <typename Input_iterator>
+    void build_from_sorted( Input_iterator first, Input_iterator last );
+    void join( AVL_tree & );
+    void split( Type const &, AVL_tree & );
+    void merge( AVL_tree & );
+    
+    // Read-mostly phases
+    void freeze( Eytzinger_index<Type, Compare> & );
+    
     // Friends
     
-    template <typename T>
-    friend std::ostream &operator<<( std::ostream &, AVL_tree<T> const & );
+    template <typename T, typename C, template <typename> class A, typename B>
+    friend std::ostream &operator<<( std::ostream &, AVL_tree<T, C, A, B> const & );
+    
+    template <typename T, typename C, template <typename> class A, typename B>
+    friend void set_union( AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> & );
+    template <typename T, typename C, template <typename> class A, typename B>
+    friend void set_intersection( AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> & );
+    template <typename T, typename C, template <typename> class A, typename B>
+    friend void set_difference( AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> const &, AVL_tree<T, C, A, B> & );
 };
 
 //////////////////////////////////////////////////////////////////////
 //                Search Tree Public Member Functions               //
 //////////////////////////////////////////////////////////////////////
 
-template <typename Type>
-AVL_tree<Type>::AVL_tree():
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::AVL_tree():
 root_node( nullptr ),
 tree_size( 0 ),
+compare(),
 front_sentinel( new AVL_tree::Node( Type() ) ),
 back_sentinel( new AVL_tree::Node( Type() ) ) {
+    PROFILE_ALLOCATIONS( 2 );
     front_sentinel->next_node = back_sentinel;
     back_sentinel->previous_node = front_sentinel;
 }
 
-template <typename Type>
-AVL_tree<Type>::~AVL_tree() {
+// Creates an empty tree ordered by a given comparison object.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::AVL_tree( Compare const &comparator ):
+root_node( nullptr ),
+tree_size( 0 ),
+compare( comparator ),
+front_sentinel( new AVL_tree::Node( Type() ) ),
+back_sentinel( new AVL_tree::Node( Type() ) ) {
+    PROFILE_ALLOCATIONS( 2 );
+    front_sentinel->next_node = back_sentinel;
+    back_sentinel->previous_node = front_sentinel;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::~AVL_tree() {
     clear();  // might as well use it...
     delete front_sentinel;
     delete back_sentinel;
 }
 
-template <typename Type>
-bool AVL_tree<Type>::empty() const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::empty() const {
     return ( root_node == nullptr );
 }
 
-template <typename Type>
-int AVL_tree<Type>::size() const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::size() const {
     return tree_size;
 }
 
-template <typename Type>
-int AVL_tree<Type>::height() const {
-    return root_node->height();
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::height() const {
+    return Node::height( root_node );
 }
 
 /* Returns the value of the front node in the linked list.
  * (i.e. The left most node in the tree.) */
-template <typename Type>
-Type AVL_tree<Type>::front() const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type const &AVL_tree<Type, Compare, Allocator, Balance>::front() const {
     if ( empty() ) {
         throw underflow();
     }
@@ -158,8 +359,8 @@ Type AVL_tree<Type>::front() const {
 }
 /* Returns the value of the back node in the linked list.
  * (i.e. The right most node in the tree.) */
-template <typename Type>
-Type AVL_tree<Type>::back() const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type const &AVL_tree<Type, Compare, Allocator, Balance>::back() const {
     if ( empty() ) {
         throw underflow();
     }
@@ -169,51 +370,125 @@ Type AVL_tree<Type>::back() const {
 
 /* This method returns an iterator whose tree is the current serach_tree and
  * the current node is the smallest node.*/
-template <typename Type>
-typename AVL_tree<Type>::Iterator AVL_tree<Type>::begin() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::begin() {
     return empty() ? Iterator( this, back_sentinel ) : Iterator( this, root_node->front() );
 }
 
 /* This method returns an iterator whose tree is the current serach_tree and
  * the current node is the back_sentinel node.*/
-template <typename Type>
-typename AVL_tree<Type>::Iterator AVL_tree<Type>::end() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::end() {
     return Iterator( this, back_sentinel );
 }
 
 /* This method returns an iterator whose tree is the current serach_tree and
  * the current node is the highest node.*/
-template <typename Type>
-typename AVL_tree<Type>::Iterator AVL_tree<Type>::rbegin() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::rbegin() {
     return empty() ? Iterator( this, front_sentinel ) : Iterator( this, root_node->back() );
 }
 
 /* This method returns an iterator whose tree is the current serach_tree and
 * the current node is the front_sentinel node.*/
-template <typename Type>
-typename AVL_tree<Type>::Iterator AVL_tree<Type>::rend() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::rend() {
     return Iterator( this, front_sentinel );
 }
 
-template <typename Type>
-typename AVL_tree<Type>::Iterator AVL_tree<Type>::find( Type const &obj ) {
-    if ( empty() ) {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::find( Type const &obj ) {
+    PROFILE_OPERATION( AVL_FIND );
+    return Iterator( this, find_node( obj ) );
+}
+
+/* This method returns an iterator to the k-th smallest value (counting from 0), or end()
+ * if there are not that many values. It descends the tree once using the sub-tree sizes. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::select( int k ) {
+    if ( k < 0 || k >= size() ) {
         return Iterator( this, back_sentinel );
     }
     
-    typename AVL_tree<Type>::Node *search_result = root_node->find( obj );
+    Node *current_node = root_node;
     
-    if ( search_result == nullptr ) {
-        return Iterator( this, back_sentinel );
-    } else {
-        return Iterator( this, search_result );
+    while ( true ) {
+        int left_size = ( current_node->left_tree == nullptr ) ? 0 : current_node->left_tree->subtree_size;
+        
+        if ( k < left_size ) {
+            current_node = current_node->left_tree;
+        } else if ( k > left_size ) {
+            // Skip the left sub-tree and the current node.
+            k -= left_size + 1;
+            current_node = current_node->right_tree;
+        } else {
+            return Iterator( this, current_node );
+        }
+    }
+}
+
+// This method returns the number of values in the tree that are lower than obj.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::rank( Type const &obj ) const {
+    return count_lower( obj, false );
+}
+
+// This method returns an iterator to the first value not lower than obj, or end().
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::lower_bound( Type const &obj ) {
+    return Iterator( this, bound( obj, false ) );
+}
+
+// This method returns an iterator to the first value higher than obj, or end().
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::upper_bound( Type const &obj ) {
+    return Iterator( this, bound( obj, true ) );
+}
+
+/* This method calls visit( value ) for every value in [lo, hi] in increasing order and
+ * returns how many values were visited. The tree is descended once to find lo, the
+ * rest of the values are streamed along the next_node links. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Function>
+int AVL_tree<Type, Compare, Allocator, Balance>::range( Type const &lo, Type const &hi, Function visit ) {
+    int visited = 0;
+    
+    for ( Node *current_node = bound( lo, false );
+          current_node != back_sentinel && !compare( hi, current_node->node_value );
+          current_node = current_node->next_node ) {
+        visit( current_node->node_value );
+        ++visited;
     }
+    
+    return visited;
+}
+
+// This method returns the number of values in [lo, hi] in O(log n) using the sub-tree sizes.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::count_range( Type const &lo, Type const &hi ) const {
+    if ( compare( hi, lo ) ) {
+        return 0;
+    }
+    
+    return count_lower( hi, true ) - count_lower( lo, false );
 }
 
-template <typename Type>
-void AVL_tree<Type>::clear() {
+/* This method deletes every node. The nodes are visited along the linked list,
+ * so no recursion (and no stack space) is needed however tall the tree is. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::clear() {
     if ( !empty() ) {
-        root_node->clear();
+        // A pool can drop all of its slabs at once, so the nodes only have to be
+        // visited when their values have destructors to run.
+        if ( !std::is_trivially_destructible<Type>::value || !node_allocator.release() ) {
+            Node *current_node = front_sentinel->next_node;
+            
+            while ( current_node != back_sentinel ) {
+                Node *garbage_node = current_node;
+                current_node = current_node->next_node;
+                garbage_node->destroy( node_allocator );
+            }
+        }
         root_node = nullptr;
         tree_size = 0;
     }
@@ -223,291 +498,769 @@ void AVL_tree<Type>::clear() {
     back_sentinel->previous_node = front_sentinel;
 }
 
-// This method inserts a node in a tree. If the node already exists it returns false.
-template <typename Type>
-bool AVL_tree<Type>::insert( Type const &obj ) {
-    if ( empty() ) {
-        root_node = new AVL_tree::Node( obj );
-        tree_size = 1;
-        // Added this code to update next and previous nodes.
-        root_node->previous_node = front_sentinel;
-        root_node->next_node = back_sentinel;
-        front_sentinel->next_node = root_node;
-        back_sentinel->previous_node = root_node;
-        
-        return true;
-    } else if ( root_node->insert( obj, root_node ) ) {
-        ++tree_size;
-        return true;
-    } else {
+// This method inserts a copy of obj in the tree. If the value already exists it returns false.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::insert( Type const &obj ) {
+    PROFILE_OPERATION( AVL_INSERT );
+    Search_path path;
+    
+    if ( !find_position( obj, path ) ) {
         return false;
     }
+    
+    link_node( Node::create( node_allocator, obj ), path );
+    
+    return true;
 }
 
-// This method erases a node in a tree. If the node doesn't exist it returns false.
-template <typename Type>
-bool AVL_tree<Type>::erase( Type const &obj ) {
-    if ( !empty() && root_node->erase( obj, root_node ) ) {
-        --tree_size;
-        return true;
-    } else {
+// This method moves obj into the tree. If the value already exists it returns false and obj is left untouched.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::insert( Type &&obj ) {
+    PROFILE_OPERATION( AVL_INSERT );
+    Search_path path;
+    
+    if ( !find_position( obj, path ) ) {
         return false;
     }
+    
+    link_node( Node::create( node_allocator, std::move( obj ) ), path );
+    
+    return true;
 }
 
-//////////////////////////////////////////////////////////////////////
-//                   Node Public Member Functions                   //
-//////////////////////////////////////////////////////////////////////
-
-template <typename Type>
-AVL_tree<Type>::Node::Node( Type const &obj ):
-node_value( obj ),
-left_tree( nullptr ),
-right_tree( nullptr ),
-next_node( nullptr ),
-previous_node( nullptr ),
-tree_height( 0 ) {
-    // does nothing
+/* This method constructs a value in place from args and inserts it. The value has to exist
+ * before it can be compared, so the node is created first and destroyed again if the value
+ * is already in the tree (in which case it returns false). */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename... Args>
+bool AVL_tree<Type, Compare, Allocator, Balance>::emplace( Args &&... args ) {
+    PROFILE_OPERATION( AVL_INSERT );
+    Node *new_node = Node::create( node_allocator, std::forward<Args>( args )... );
+    Search_path path;
+    
+    if ( !find_position( new_node->node_value, path ) ) {
+        new_node->destroy( node_allocator );
+        return false;
+    }
+    
+    link_node( new_node, path );
+    
+    return true;
 }
 
-/* This method updates the height of a node by adding 1 to the highest height between the
- * left and right trees. */
-template <typename Type>
-void AVL_tree<Type>::Node::update_height() {
-    tree_height = std::max( left_tree->height(), right_tree->height() ) + 1;
+/* This method returns an iterator to the value equal to key, constructing one from args and
+ * inserting it first if there is none, with a single descent either way. The value built
+ * from args must be equal to key. Key is Type, or any key if Compare is transparent. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key, typename... Args>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::find_or_emplace( Key const &key, Args &&... args ) {
+    PROFILE_OPERATION( AVL_INSERT );
+    Search_path path;
+    
+    if ( !find_position( key, path ) ) {
+        return Iterator( this, path.found );
+    }
+    
+    Node *new_node = Node::create( node_allocator, std::forward<Args>( args )... );
+    assert( !compare( new_node->node_value, key ) && !compare( key, new_node->node_value ) );
+    link_node( new_node, path );
+    
+    return Iterator( this, new_node );
 }
 
-// This method returns the height of a node.
-template <typename Type>
-int AVL_tree<Type>::Node::height() const {
-    return ( this == nullptr ) ? -1 : tree_height;
+// This method erases a node in a tree. If the node doesn't exist it returns false.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::erase( Type const &obj ) {
+    PROFILE_OPERATION( AVL_ERASE );
+    Node *garbage_node = unlink_node( obj );
+    
+    if ( garbage_node == nullptr ) {
+        return false;
+    }
+    
+    garbage_node->destroy( node_allocator );
+    
+    return true;
 }
 
-// Return true if the current node is a leaf node, false otherwise
-template <typename Type>
-bool AVL_tree<Type>::Node::is_leaf() const {
-    return ( (left_tree == nullptr) && (right_tree == nullptr) );
+/* This method takes the node holding obj out of the tree without destroying it. The handle
+ * is empty if there is no such node. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node_handle AVL_tree<Type, Compare, Allocator, Balance>::extract( Type const &obj ) {
+    Node *node = unlink_node( obj );
+    
+    return ( node == nullptr ) ? Node_handle() : Node_handle( node, node_allocator );
 }
 
-/* Return a pointer to the front node.
- * Recursive method that finds the left-most node in the tree. */
-template <typename Type>
-typename AVL_tree<Type>::Node *AVL_tree<Type>::Node::front() {
-    return ( left_tree == nullptr ) ? this : left_tree->front();
+/* This method inserts the node owned by the handle, which is left empty. If the value already
+ * exists it returns false and the handle keeps the node. If the node comes from an allocator
+ * that cannot share nodes with this tree's, its value is moved into a new node instead. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::insert( Node_handle &&handle ) {
+    PROFILE_OPERATION( AVL_INSERT );
+    
+    if ( handle.empty() ) {
+        return false;
+    }
+    
+    Search_path path;
+    
+    if ( !find_position( handle.extracted_node->node_value, path ) ) {
+        return false;
+    }
+    
+    Node *new_node = handle.extracted_node;
+    
+    if ( !node_allocator.shares( handle.node_allocator ) ) {
+        new_node = Node::create( node_allocator, std::move( handle.extracted_node->node_value ) );
+        handle.extracted_node->destroy( handle.node_allocator );
+    }
+    
+    handle.extracted_node = nullptr;
+    link_node( new_node, path );
+    
+    return true;
 }
 
-/* Return a pointer to the back node
- * Recursive method that finds the right-most node in the tree. */
-template <typename Type>
-typename AVL_tree<Type>::Node *AVL_tree<Type>::Node::back() {
-    return ( right_tree == nullptr ) ? this : right_tree->back();
+/* This method replaces the contents of the tree with the values in [first, last), which
+ * must be strictly increasing. The nodes are created and threaded in order and then
+ * arranged into a perfectly balanced tree, in O(n) without any rotation. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Input_iterator>
+void AVL_tree<Type, Compare, Allocator, Balance>::build_from_sorted( Input_iterator first, Input_iterator last ) {
+    clear();
+    
+    Node *last_node = front_sentinel;
+    int n = 0;
+    
+    for ( ; first != last; ++first ) {
+        Node *new_node = Node::create( node_allocator, *first );
+        assert( last_node == front_sentinel || compare( last_node->node_value, new_node->node_value ) );
+        
+        // Appending the node to the linked list.
+        last_node->next_node = new_node;
+        new_node->previous_node = last_node;
+        last_node = new_node;
+        ++n;
+    }
+    
+    last_node->next_node = back_sentinel;
+    back_sentinel->previous_node = last_node;
+    
+    Node *chain = front_sentinel->next_node;
+    root_node = build_balanced( chain, n );
+    tree_size = n;
 }
 
-template <typename Type>
-typename AVL_tree<Type>::Node *AVL_tree<Type>::Node::find( Type const &obj ) {
-    if ( obj == node_value ) {
-        return this;
-    } else if ( obj < node_value ) {
-        return (left_tree == nullptr) ? nullptr : left_tree->find( obj );
+/* This method moves all the values of tree into this tree. The values of the two trees
+ * must not overlap (either tree may hold the lower values), otherwise illegal_argument
+ * is thrown. The nodes are relinked in O(log n) by joining the two trees around the
+ * front node of the higher one. If the nodes cannot be shared between the allocators of
+ * the two trees, or the balancing policy is not height based, the values are merged in
+ * linear time instead. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::join( AVL_tree &tree ) {
+    if ( &tree == this || tree.empty() ) {
+        return;
+    }
+    
+    Node *lower = root_node;
+    Node *higher = tree.root_node;
+    Node *lower_front = front_sentinel->next_node;
+    Node *lower_back = back_sentinel->previous_node;
+    Node *higher_front = tree.front_sentinel->next_node;
+    Node *higher_back = tree.back_sentinel->previous_node;
+    
+    if ( !empty() && !compare( lower_back->node_value, higher_front->node_value ) ) {
+        if ( !compare( tree.back_sentinel->previous_node->node_value, front_sentinel->next_node->node_value ) ) {
+            throw illegal_argument();
+        }
+        
+        std::swap( lower, higher );
+        std::swap( lower_front, higher_front );
+        std::swap( lower_back, higher_back );
+    }
+    
+    // Joining relies on AVL heights, so other balancing policies merge in linear time.
+    if ( !Balance::HEIGHT_BALANCED || !node_allocator.absorb( tree.node_allocator ) ) {
+        merge( tree );
+        return;
+    }
+    
+    if ( empty() ) {
+        root_node = tree.root_node;
+        link_sentinels( higher_front, higher_back );
     } else {
-        return ( right_tree == nullptr ) ? nullptr : right_tree->find( obj );
+        // Chaining both linked lists together.
+        lower_back->next_node = higher_front;
+        higher_front->previous_node = lower_back;
+        link_sentinels( lower_front, higher_back );
+        
+        Node *middle = detach_front( higher );
+        root_node = join_nodes( lower, middle, higher );
     }
+    
+    tree_size += tree.tree_size;
+    
+    tree.root_node = nullptr;
+    tree.tree_size = 0;
+    tree.link_sentinels( nullptr, nullptr );
 }
 
-// Recursively clear the tree
-template <typename Type>
-void AVL_tree<Type>::Node::clear() {
-    if ( left_tree != nullptr ) {
-        left_tree->clear();
+/* This method moves all the values not lower than key into tree, which is cleared first.
+ * The tree is cut along the search path for key in O(log n) (in O(n) if the balancing
+ * policy is not height based). Both trees share the allocator afterwards. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::split( Type const &key, AVL_tree &tree ) {
+    assert( &tree != this );
+    tree.clear();
+    
+    if ( !node_allocator.shares( tree.node_allocator ) ) {
+        tree.node_allocator = node_allocator;
     }
     
-    if ( right_tree != nullptr ) {
-        right_tree->clear();
+    Node *higher_front = bound( key, false );
+    
+    if ( higher_front == back_sentinel ) {
+        return;
     }
     
-    delete this;
+    Node *lower_back = higher_front->previous_node;
+    Node *higher_back = back_sentinel->previous_node;
+    Node *lower;
+    Node *higher;
+    
+    if ( Balance::HEIGHT_BALANCED ) {
+        split_nodes( root_node, key, lower, higher );
+    } else {
+        // Other balancing policies rebuild both halves from the linked list, in O(n).
+        int lower_size = count_lower( key, false );
+        Node *chain = front_sentinel->next_node;
+        lower = build_balanced( chain, lower_size );
+        higher = build_balanced( chain, tree_size - lower_size );
+    }
+    
+    // Cutting the linked list between lower_back and higher_front.
+    root_node = lower;
+    tree_size = ( lower == nullptr ) ? 0 : lower->subtree_size;
+    link_sentinels( front_sentinel->next_node == higher_front ? nullptr : front_sentinel->next_node, lower_back );
+    
+    tree.root_node = higher;
+    tree.tree_size = higher->subtree_size;
+    tree.link_sentinels( higher_front, higher_back );
 }
 
-template <typename Type>
-bool AVL_tree<Type>::Node::insert( Type const &obj, AVL_tree<Type>::Node *&to_this) {
-    // Go to left side if the node_value is lower than the current node
-    if ( obj < node_value ) {
-        if ( left_tree == nullptr ) {
-            left_tree = new AVL_tree<Type>::Node( obj );
-            
-            // Updating previous and next nodes.
-            previous_node->next_node = left_tree;
-            left_tree->previous_node = previous_node;
-            left_tree->next_node = to_this;
-            previous_node = left_tree;
-            
-            int prev_height = height();
-            update_height();
+/* This method moves all the values of tree into this tree (set union). Values already in
+ * this tree are dropped from tree. Both linked lists are merged in lockstep and the merged
+ * list is rearranged into a balanced tree, in O(n + m). */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::merge( AVL_tree &tree ) {
+    if ( &tree == this ) {
+        return;
+    }
+    
+    // If the nodes cannot move between the trees, the values of tree are copied instead.
+    bool relink = node_allocator.absorb( tree.node_allocator );
+    
+    Node *last_node = front_sentinel;
+    Node *mine = front_sentinel->next_node;
+    Node *theirs = tree.front_sentinel->next_node;
+    int n = 0;
+    
+    while ( mine != back_sentinel || theirs != tree.back_sentinel ) {
+        Node *next;
+        
+        if ( theirs == tree.back_sentinel || ( mine != back_sentinel && compare( mine->node_value, theirs->node_value ) ) ) {
+            next = mine;
+            mine = mine->next_node;
+        } else {
+            Node *their_node = theirs;
+            theirs = theirs->next_node;
             
-            // Checking whether we need to check if the tree is unbalanced.
-            if(prev_height != height()){
-                check_balance(to_this);
-            }
-            return true;
-        }
-        else {
-            if ( left_tree->insert( obj, left_tree ) ) {
-                
-                int prev_height = height();
-                update_height();
-                
-                // Checking whether we need to check if the tree is unbalanced.
-                if(prev_height != height()){
-                    check_balance(to_this);
-                }
-                return true;
-            }
-            else {
-                return false;
+            if ( mine != back_sentinel && !compare( their_node->node_value, mine->node_value ) ) {
+                // Duplicate values are dropped.
+                their_node->destroy( relink ? node_allocator : tree.node_allocator );
+                continue;
+            } else if ( relink ) {
+                next = their_node;
+            } else {
+                next = Node::create( node_allocator, std::move( their_node->node_value ) );
+                their_node->destroy( tree.node_allocator );
             }
         }
+        
+        // Appending the node to the merged linked list.
+        last_node->next_node = next;
+        next->previous_node = last_node;
+        last_node = next;
+        ++n;
     }
-    // Go to right side if the node_value is higher than the current node
-    else if ( obj > node_value ) {
-        if ( right_tree == nullptr ) {
-            right_tree = new AVL_tree<Type>::Node( obj );
-            
-            // Updating previous and next nodes.
-            next_node->previous_node = right_tree;
-            right_tree->next_node = next_node;
-            right_tree->previous_node = to_this;
-            next_node = right_tree;
-            
-            int prev_height = height();
-            update_height();
-            
-            // Checking whether we need to check if the tree is unbalanced.
-            if(prev_height != height()){
-                check_balance(to_this);
-            }
-            return true;
-            
+    
+    last_node->next_node = back_sentinel;
+    back_sentinel->previous_node = last_node;
+    
+    Node *chain = front_sentinel->next_node;
+    root_node = build_balanced( chain, n );
+    tree_size = n;
+    
+    tree.root_node = nullptr;
+    tree.tree_size = 0;
+    tree.link_sentinels( nullptr, nullptr );
+}
+
+/* This method exports the values, in order along the linked list, into an immutable
+ * Eytzinger layout that answers find and lower_bound without chasing pointers. The index
+ * does not follow later writes; calling freeze again rebuilds it in place. The index takes
+ * a copy of the tree's comparison object, so a stateful Compare orders both alike. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::freeze( Eytzinger_index<Type, Compare> &index ) {
+    index.assign( begin(), size(), compare );
+}
+
+// The same as find( Type const & ), for a key that Compare can compare with the values.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::find( Key const &key, If_transparent<Key> * ) {
+    PROFILE_OPERATION( AVL_FIND );
+    return Iterator( this, find_node( key ) );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::lower_bound( Key const &key, If_transparent<Key> * ) {
+    return Iterator( this, bound( key, false ) );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator AVL_tree<Type, Compare, Allocator, Balance>::upper_bound( Key const &key, If_transparent<Key> * ) {
+    return Iterator( this, bound( key, true ) );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+int AVL_tree<Type, Compare, Allocator, Balance>::rank( Key const &key, If_transparent<Key> * ) const {
+    return count_lower( key, false );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+bool AVL_tree<Type, Compare, Allocator, Balance>::erase( Key const &key, If_transparent<Key> * ) {
+    PROFILE_OPERATION( AVL_ERASE );
+    Node *garbage_node = unlink_node( key );
+    
+    if ( garbage_node == nullptr ) {
+        return false;
+    }
+    
+    garbage_node->destroy( node_allocator );
+    
+    return true;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node_handle AVL_tree<Type, Compare, Allocator, Balance>::extract( Key const &key, If_transparent<Key> * ) {
+    Node *node = unlink_node( key );
+    
+    return ( node == nullptr ) ? Node_handle() : Node_handle( node, node_allocator );
+}
+
+//////////////////////////////////////////////////////////////////////
+//              Search Tree Private Member Functions                //
+//////////////////////////////////////////////////////////////////////
+
+// Returns the node holding a value equal to key, or the back_sentinel if there is none.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::find_node( Key const &key ) const {
+    Node *current_node = root_node;
+    
+    while ( current_node != nullptr ) {
+        if ( compare( key, current_node->node_value ) ) {
+            current_node = current_node->left_tree;
+        } else if ( compare( current_node->node_value, key ) ) {
+            current_node = current_node->right_tree;
         } else {
-            if ( right_tree->insert( obj, right_tree ) ) {
-                int prev_height = height();
-                update_height();
-                
-                // Checking whether we need to check if the tree is unbalanced.
-                if(prev_height != height()){
-                    check_balance(to_this);
-                }
-                return true;
-            }
-            else {
-                return false;
-            }
+            return current_node;
         }
     }
-    // (obj == node_value)
-    else {
-        // The node that was going to be inserted already exists.
-        return false;
+    
+    return back_sentinel;
+}
+
+/* Returns the first node whose value is higher than key (if inclusive) or not lower
+ * than key (otherwise). Returns the back_sentinel if there is no such node. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::bound( Key const &key, bool inclusive ) const {
+    Node *candidate = back_sentinel;
+    Node *current_node = root_node;
+    
+    while ( current_node != nullptr ) {
+        if ( inclusive ? compare( key, current_node->node_value ) : !compare( current_node->node_value, key ) ) {
+            // The current node qualifies, but there may be a lower one on the left.
+            candidate = current_node;
+            current_node = current_node->left_tree;
+        } else {
+            current_node = current_node->right_tree;
+        }
     }
+    
+    return candidate;
 }
 
-/* This method erases a node in the tree. */
-template <typename Type>
-bool AVL_tree<Type>::Node::erase( Type const &obj, AVL_tree<Type>::Node *&to_this ) {
-    if ( obj < node_value ) {
-        if ( left_tree == nullptr ) {
-            return false;
+/* Returns the number of values lower than key, also counting a value equal to key if inclusive.
+ * Every time the search moves right, the left sub-tree and the current node are counted. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+int AVL_tree<Type, Compare, Allocator, Balance>::count_lower( Key const &key, bool inclusive ) const {
+    int lower_values = 0;
+    Node *current_node = root_node;
+    
+    while ( current_node != nullptr ) {
+        if ( inclusive ? !compare( key, current_node->node_value ) : compare( current_node->node_value, key ) ) {
+            lower_values += 1 + ( (current_node->left_tree == nullptr) ? 0 : current_node->left_tree->subtree_size );
+            current_node = current_node->right_tree;
         } else {
-            if ( left_tree->erase( obj, left_tree ) ) {
-                update_height();
-                
-                // Checking whether the tree is balanced at this node.
-                check_balance(to_this);
-                
-                return true;
-            }
-            return false;
+            current_node = current_node->left_tree;
         }
-    } else if ( obj > node_value ) {
-        if ( right_tree == nullptr ) {
-            return false;
+    }
+    
+    return lower_values;
+}
+
+/* Takes the node holding a value equal to key out of the tree and returns it, or returns
+ * nullptr if there is none. A node with two children is replaced by the closest node on its
+ * taller side: that node (which has at most one child) is unlinked from its place and then
+ * relinked where the removed node was, so no value is copied or moved. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::unlink_node( Key const &key ) {
+    Node **path[MAX_HEIGHT];
+    int depth = 0;
+    
+    Node **link = &root_node;
+    
+    while ( *link != nullptr ) {
+        if ( compare( key, (*link)->node_value ) ) {
+            path[depth++] = link;
+            link = &(*link)->left_tree;
+        } else if ( compare( (*link)->node_value, key ) ) {
+            path[depth++] = link;
+            link = &(*link)->right_tree;
         } else {
-            if ( right_tree->erase( obj, right_tree ) ) {
-                update_height();
-                
-                // Checking whether the tree is balanced at this node.
-                check_balance(to_this);
-                
-                return true;
-            }
-            return false;
+            break;
         }
+    }
+    
+    if ( *link == nullptr ) {
+        return nullptr;
+    }
+    
+    Node *garbage_node = *link;
+    
+    // Updating the previous and next nodes
+    garbage_node->previous_node->next_node = garbage_node->next_node;
+    garbage_node->next_node->previous_node = garbage_node->previous_node;
+    
+    if ( garbage_node->left_tree == nullptr || garbage_node->right_tree == nullptr ) {
+        // Replacing the node by its only sub-tree (if any).
+        *link = ( garbage_node->left_tree != nullptr ) ? garbage_node->left_tree : garbage_node->right_tree;
+        path[depth] = link;
     } else {
-        assert( obj == node_value );
+        Node **garbage_link = link;
+        int garbage_depth = depth;
+        path[depth++] = link;
         
-        if ( is_leaf() ) {
-            // Updating the previous and next nodes
-            previous_node->next_node = next_node;
-            next_node->previous_node = previous_node;
-            
-            // Deleting the node
-            to_this = nullptr;
-            delete this;
-        }
-        else if ( left_tree == nullptr ) {
-            // Updating the previous and next nodes
-            previous_node->next_node = next_node;
-            next_node->previous_node = previous_node;
-            
-            // Deleting the node
-            to_this = right_tree;
-            delete this;
-        }
-        else if ( right_tree == nullptr ) {
-            // Updating the previous and next nodes
-            previous_node->next_node = next_node;
-            next_node->previous_node = previous_node;
-            
-            // Deleting the node
-            to_this = left_tree;
-            delete this;
-        }
-        /* Set the current node to be the next highest node and delete that
-         * node from the right hand side of the tree (since that's where the
-         * next highest node is) */
-        else {
-            // Before we take the lower or higher node we check whether the left_tree is
-            // higher than the right_tree
-            int diff = height_difference();
-            if (diff > 0) {
-                node_value = left_tree->back()->node_value;
-                left_tree->erase(node_value, left_tree);
-                update_height();
+        Node **replacement_link;
+        
+        if ( garbage_node->height_difference() > 0 ) {
+            // The previous node is the right-most node of the left sub-tree.
+            replacement_link = &garbage_node->left_tree;
+            while ( (*replacement_link)->right_tree != nullptr ) {
+                path[depth++] = replacement_link;
+                replacement_link = &(*replacement_link)->right_tree;
             }
-            else{
-                node_value = right_tree->front()->node_value;
-                right_tree->erase( node_value, right_tree );
-                update_height();
+        } else {
+            // The next node is the left-most node of the right sub-tree.
+            replacement_link = &garbage_node->right_tree;
+            while ( (*replacement_link)->left_tree != nullptr ) {
+                path[depth++] = replacement_link;
+                replacement_link = &(*replacement_link)->left_tree;
             }
-            
-            // Checking whether the tree is balanced at this node.
-            check_balance(to_this);
         }
-        return true;
+        
+        // Unlinking the replacement from its place, then putting it in the removed node's place.
+        Node *replacement = *replacement_link;
+        *replacement_link = ( replacement->left_tree != nullptr ) ? replacement->left_tree : replacement->right_tree;
+        
+        replacement->left_tree = garbage_node->left_tree;
+        replacement->right_tree = garbage_node->right_tree;
+        replacement->tree_height = garbage_node->tree_height;
+        *garbage_link = replacement;
+        path[depth] = replacement_link;
+        
+        // The path (or the emptied link at its end) may go through a link of the removed
+        // node, which now belongs to the replacement.
+        path[garbage_depth + 1] = ( path[garbage_depth + 1] == &garbage_node->left_tree ) ?
+                                  &replacement->left_tree : &replacement->right_tree;
+    }
+    
+    --tree_size;
+    Balance::after_erase( path, depth );
+    
+    // The node leaves the tree as a single node.
+    garbage_node->left_tree = nullptr;
+    garbage_node->right_tree = nullptr;
+    garbage_node->previous_node = nullptr;
+    garbage_node->next_node = nullptr;
+    garbage_node->update_height();
+    
+    return garbage_node;
+}
+
+/* Searches for obj and records the links followed from the root, and the last nodes where
+ * the search turned right and left (the previous and next nodes of obj). Returns false if
+ * obj already exists. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename Key>
+bool AVL_tree<Type, Compare, Allocator, Balance>::find_position( Key const &obj, Search_path &path ) {
+    Node **link = &root_node;
+    path.depth = 0;
+    path.previous = front_sentinel;
+    path.next = back_sentinel;
+    path.found = nullptr;
+    
+    while ( *link != nullptr ) {
+        Node *current_node = *link;
+        
+        if ( compare( obj, current_node->node_value ) ) {
+            path.next = current_node;
+            path.links[path.depth++] = link;
+            link = &current_node->left_tree;
+        } else if ( compare( current_node->node_value, obj ) ) {
+            path.previous = current_node;
+            path.links[path.depth++] = link;
+            link = &current_node->right_tree;
+        } else {
+            // The node that was going to be inserted already exists.
+            path.found = current_node;
+            return false;
+        }
     }
+    
+    // The empty link is kept past the end of the path.
+    path.links[path.depth] = link;
+    
+    return true;
+}
+
+/* Links a single node at the position found by find_position() and has the balancing
+ * policy rebalance the tree bottom-up, without recursion. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::link_node( Node *new_node, Search_path &path ) {
+    *path.links[path.depth] = new_node;
+    
+    // Updating previous and next nodes.
+    new_node->previous_node = path.previous;
+    new_node->next_node = path.next;
+    path.previous->next_node = new_node;
+    path.next->previous_node = new_node;
+    
+    ++tree_size;
+    Balance::after_insert( path.links, path.depth );
+}
+
+/* Links the first and last nodes of the linked list to the sentinels.
+ * If first is nullptr the list is empty. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::link_sentinels( Node *first, Node *last ) {
+    if ( first == nullptr ) {
+        front_sentinel->next_node = back_sentinel;
+        back_sentinel->previous_node = front_sentinel;
+    } else {
+        front_sentinel->next_node = first;
+        first->previous_node = front_sentinel;
+        last->next_node = back_sentinel;
+        back_sentinel->previous_node = last;
+    }
+}
+
+/* Arranges the next n nodes of the chain (linked through next_node) into a perfectly
+ * balanced tree and advances chain past them. The nodes are visited in order. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::build_balanced( Node *&chain, int n ) {
+    if ( n == 0 ) {
+        return nullptr;
+    }
+    
+    Node *lower = build_balanced( chain, n/2 );
+    Node *root = chain;
+    chain = chain->next_node;
+    
+    root->left_tree = lower;
+    root->right_tree = build_balanced( chain, n - n/2 - 1 );
+    root->update_height();
+    
+    return root;
+}
+
+/* Returns a balanced tree with the values of lower, then middle, then higher. The middle
+ * node is hung from the spine of the taller tree at the height of the shorter one and the
+ * spine is rebalanced on the way back up, in O(height difference). */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::join_nodes( Node *lower, Node *middle, Node *higher ) {
+    if ( Node::height( lower ) > Node::height( higher ) + 1 ) {
+        lower->right_tree = join_nodes( lower->right_tree, middle, higher );
+        lower->update_height();
+        lower->check_balance( lower );
+        return lower;
+    } else if ( Node::height( higher ) > Node::height( lower ) + 1 ) {
+        higher->left_tree = join_nodes( lower, middle, higher->left_tree );
+        higher->update_height();
+        higher->check_balance( higher );
+        return higher;
+    }
+    
+    middle->left_tree = lower;
+    middle->right_tree = higher;
+    middle->update_height();
+    
+    return middle;
+}
+
+// Removes the left-most node from the tree rooted at root (rebalancing it) and returns it.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::detach_front( Node *&root ) {
+    if ( root->left_tree == nullptr ) {
+        Node *front = root;
+        root = root->right_tree;
+        front->right_tree = nullptr;
+        front->update_height();
+        return front;
+    }
+    
+    Node *front = detach_front( root->left_tree );
+    root->update_height();
+    root->check_balance( root );
+    
+    return front;
+}
+
+/* Splits the tree rooted at root into the values lower than key and the rest. Every
+ * node on the search path is joined back into one of the two sides. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::split_nodes( Node *root, Type const &key, Node *&lower, Node *&higher ) const {
+    if ( root == nullptr ) {
+        lower = nullptr;
+        higher = nullptr;
+    } else if ( compare( root->node_value, key ) ) {
+        Node *right_lower;
+        split_nodes( root->right_tree, key, right_lower, higher );
+        lower = join_nodes( root->left_tree, root, right_lower );
+    } else {
+        Node *left_higher;
+        split_nodes( root->left_tree, key, lower, left_higher );
+        higher = join_nodes( left_higher, root, root->right_tree );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Node Public Member Functions                   //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename... Args>
+AVL_tree<Type, Compare, Allocator, Balance>::Node::Node( Args &&... args ):
+node_value( std::forward<Args>( args )... ),
+tree_height( 0 ),
+subtree_size( 1 ),
+left_tree( nullptr ),
+right_tree( nullptr ),
+previous_node( nullptr ),
+next_node( nullptr ) {
+    // does nothing
+}
+
+// Constructs a node in storage obtained from the allocator.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+template <typename... Args>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::Node::create( Allocator<Node> &allocator, Args &&... args ) {
+    return new ( allocator.allocate() ) Node( std::forward<Args>( args )... );
+}
+
+// Destroys the node and returns its storage to the allocator.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::destroy( Allocator<Node> &allocator ) {
+    this->~Node();
+    allocator.deallocate( this );
+}
+
+/* This method updates the height of a node by adding 1 to the highest height between the
+ * left and right trees. The sub-tree size changes at exactly the same places, so it is
+ * refreshed here as well. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::update_height() {
+    tree_height = std::max( height( left_tree ), height( right_tree ) ) + 1;
+    update_size();
+}
+
+// This method updates the sub-tree size alone, for policies that keep ranks instead of heights.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::update_size() {
+    subtree_size = 1 + ( (left_tree == nullptr) ? 0 : left_tree->subtree_size )
+                     + ( (right_tree == nullptr) ? 0 : right_tree->subtree_size );
+}
+
+// This method returns the height of a node.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::Node::height( Node const *node ) {
+    return ( node == nullptr ) ? -1 : node->tree_height;
+}
+
+// Return true if the current node is a leaf node, false otherwise
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Node::is_leaf() const {
+    return ( (left_tree == nullptr) && (right_tree == nullptr) );
+}
+
+// Return a pointer to the front node (i.e. the left-most node in the tree).
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::Node::front() {
+    Node *current_node = this;
+    
+    while ( current_node->left_tree != nullptr ) {
+        current_node = current_node->left_tree;
+    }
+    
+    return current_node;
+}
+
+// Return a pointer to the back node (i.e. the right-most node in the tree).
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node *AVL_tree<Type, Compare, Allocator, Balance>::Node::back() {
+    Node *current_node = this;
+    
+    while ( current_node->right_tree != nullptr ) {
+        current_node = current_node->right_tree;
+    }
+    
+    return current_node;
 }
 
 // Helper functions
 
 /* This method checks whether the tree is balanced or not. If the tree is indeed unbalanced,
  * this method balances it according to the type of unbalancement. */
-template <typename Type>
-bool AVL_tree<Type>::Node::check_balance( AVL_tree<Type>::Node *&root ) {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Node::check_balance( AVL_tree<Type, Compare, Allocator, Balance>::Node *&root ) {
     int diff = height_difference();
     
     // The left_tree is higher than the right_tree
     if (diff > 1) {
         // Case 1
-        if(left_tree->height_difference() > 0){
+        if(left_tree->height_difference() >= 0){
             case_1_left(root);
         }
         // Case 2
@@ -520,7 +1273,7 @@ bool AVL_tree<Type>::Node::check_balance( AVL_tree<Type>::Node *&root ) {
     else if (diff < -1){
         
         // Case 1
-        if(right_tree->height_difference() < 0){
+        if(right_tree->height_difference() <= 0){
             case_1_right(root);
         }
         // Case 2
@@ -533,8 +1286,8 @@ bool AVL_tree<Type>::Node::check_balance( AVL_tree<Type>::Node *&root ) {
 }
 
 // This method returns the height difference between the right and left tree of a given node,
-template <typename Type>
-int AVL_tree<Type>::Node::height_difference(){
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+int AVL_tree<Type, Compare, Allocator, Balance>::Node::height_difference(){
     int a = -1;
     int b = -1;
     if(left_tree != nullptr){
@@ -547,8 +1300,10 @@ int AVL_tree<Type>::Node::height_difference(){
 }
 
 
-template <typename Type>
-void AVL_tree<Type>::Node::case_1_left( AVL_tree<Type>::Node *&root ){
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::case_1_left( AVL_tree<Type, Compare, Allocator, Balance>::Node *&root ){
+    
+    COUNT_ROTATIONS( 1 );
     
     // Doing the node rotation
     Node *temp = left_tree;
@@ -567,8 +1322,10 @@ void AVL_tree<Type>::Node::case_1_left( AVL_tree<Type>::Node *&root ){
     delete temp;
 }
 
-template <typename Type>
-void AVL_tree<Type>::Node::case_1_right( AVL_tree<Type>::Node *&root ){
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::case_1_right( AVL_tree<Type, Compare, Allocator, Balance>::Node *&root ){
+    
+    COUNT_ROTATIONS( 1 );
     
     // Doing the node rotation
     Node *temp = right_tree;
@@ -587,8 +1344,10 @@ void AVL_tree<Type>::Node::case_1_right( AVL_tree<Type>::Node *&root ){
     delete temp;
 }
 
-template <typename Type>
-void AVL_tree<Type>::Node::case_2_left( AVL_tree<Type>::Node *&root ){
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::case_2_left( AVL_tree<Type, Compare, Allocator, Balance>::Node *&root ){
+    
+    COUNT_ROTATIONS( 2 );
     
     // Doing the node rotation
     Node *temp = left_tree->right_tree;
@@ -609,8 +1368,10 @@ void AVL_tree<Type>::Node::case_2_left( AVL_tree<Type>::Node *&root ){
     delete temp;
 }
 
-template <typename Type>
-void AVL_tree<Type>::Node::case_2_right( AVL_tree<Type>::Node *&root ){
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::case_2_right( AVL_tree<Type, Compare, Allocator, Balance>::Node *&root ){
+    
+    COUNT_ROTATIONS( 2 );
     
     // Doing the node rotation
     Node *temp = right_tree->left_tree;
@@ -631,12 +1392,73 @@ void AVL_tree<Type>::Node::case_2_right( AVL_tree<Type>::Node *&root ){
     delete temp;
 }
 
+//////////////////////////////////////////////////////////////////////
+//                Node_handle Public Member Functions               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::Node_handle():
+extracted_node( nullptr ) {
+    // does nothing
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::Node_handle( Node *node, Allocator<Node> const &allocator ):
+extracted_node( node ),
+node_allocator( allocator ) {
+    // does nothing
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::Node_handle( Node_handle &&handle ):
+extracted_node( handle.extracted_node ),
+node_allocator( handle.node_allocator ) {
+    handle.extracted_node = nullptr;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Node_handle &AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::operator=( Node_handle &&rhs ) {
+    if ( this != &rhs ) {
+        if ( extracted_node != nullptr ) {
+            extracted_node->destroy( node_allocator );
+        }
+        
+        extracted_node = rhs.extracted_node;
+        node_allocator = rhs.node_allocator;
+        rhs.extracted_node = nullptr;
+    }
+    
+    return *this;
+}
+
+// A node that was never inserted again is destroyed with the handle.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::~Node_handle() {
+    if ( extracted_node != nullptr ) {
+        extracted_node->destroy( node_allocator );
+    }
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::empty() const {
+    return ( extracted_node == nullptr );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type &AVL_tree<Type, Compare, Allocator, Balance>::Node_handle::value() const {
+    if ( empty() ) {
+        throw underflow();
+    }
+    
+    return extracted_node->node_value;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                   Iterator Private Constructor                   //
 //////////////////////////////////////////////////////////////////////
 
-template <typename Type>
-AVL_tree<Type>::Iterator::Iterator( AVL_tree<Type> *tree, typename AVL_tree<Type>::Node *starting_node ):
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Iterator::Iterator( AVL_tree<Type, Compare, Allocator, Balance> *tree, typename AVL_tree<Type, Compare, Allocator, Balance>::Node *starting_node ):
 containing_tree( tree ),
 current_node( starting_node ) {
 
@@ -646,14 +1468,18 @@ current_node( starting_node ) {
 //                 Iterator Public Member Functions                 //
 //////////////////////////////////////////////////////////////////////
 
-template <typename Type>
-Type AVL_tree<Type>::Iterator::operator*() const {
-    // This is done for you...
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type const &AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator*() const {
     return current_node->node_value;
 }
 
-template <typename Type>
-typename AVL_tree<Type>::Iterator &AVL_tree<Type>::Iterator::operator++() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type const *AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator->() const {
+    return &current_node->node_value;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator &AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator++() {
     // Update the current node to the node containing the next higher value
     // If we are already at end do nothing
     
@@ -664,8 +1490,8 @@ typename AVL_tree<Type>::Iterator &AVL_tree<Type>::Iterator::operator++() {
     return *this;
 }
 
-template <typename Type>
-typename AVL_tree<Type>::Iterator &AVL_tree<Type>::Iterator::operator--() {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator &AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator--() {
     // Update the current node to the node containing the next smaller value
     // If we are already at either rend, do nothing
     
@@ -677,39 +1503,219 @@ typename AVL_tree<Type>::Iterator &AVL_tree<Type>::Iterator::operator--() {
     return *this;
 }
 
-template <typename Type>
-bool AVL_tree<Type>::Iterator::operator==( typename AVL_tree<Type>::Iterator const &rhs ) const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator==( typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator const &rhs ) const {
     return ( current_node == rhs.current_node );
 }
 
-template <typename Type>
-bool AVL_tree<Type>::Iterator::operator!=( typename AVL_tree<Type>::Iterator const &rhs ) const {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Iterator::operator!=( typename AVL_tree<Type, Compare, Allocator, Balance>::Iterator const &rhs ) const {
     return ( current_node != rhs.current_node );
 }
 
 //////////////////////////////////////////////////////////////////////
 //                            Friends                               //
 //////////////////////////////////////////////////////////////////////
-template <typename Type>
-void AVL_tree<Type>::Node::print( std::ostream &out, int tabs ) {
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Node::print( Node const *node, std::ostream &out, int tabs ) {
     for(int i = 0; i < tabs; i++){
         out << " ";
     }
     out << (tabs ? "`==" : "");
-    if(this == nullptr){
+    if(node == nullptr){
         out << "xx";
         out << " h=-1" << std::endl;
     } else {
-        out << node_value;
-        out << " h=" << height() << std::endl;
-        left_tree->print(out, tabs+1);
-        right_tree->print(out, tabs+1);
+        out << node->node_value;
+        out << " h=" << height( node ) << std::endl;
+        print(node->left_tree, out, tabs+1);
+        print(node->right_tree, out, tabs+1);
     }
 }
 
-template <typename T>
-std::ostream &operator<<( std::ostream &out, AVL_tree<T> const &list ) {
-    list.root_node->print(out);
+template <typename T, typename C, template <typename> class A, typename B>
+std::ostream &operator<<( std::ostream &out, AVL_tree<T, C, A, B> const &list ) {
+    AVL_tree<T, C, A, B>::Node::print( list.root_node, out );
     return out;
 }
 
+//////////////////////////////////////////////////////////////////////
+//                          Set Operations                          //
+//////////////////////////////////////////////////////////////////////
+
+/* These functions replace the contents of result with the values that are in lhs or rhs,
+ * in both, or in lhs but not in rhs. A value in both trees is taken from lhs. The result
+ * is built balanced in one pass (build_from_sorted) while the two trees are walked along
+ * their threaded lists in O(n + m). When one tree is much smaller than the other, the
+ * intersection (and the difference, if lhs is the smaller one) searches the larger tree
+ * for each value of the smaller one instead, in O(m log n). result must be a third tree,
+ * otherwise illegal_argument is thrown. */
+template <typename T, typename C, template <typename> class A, typename B>
+void set_union( AVL_tree<T, C, A, B> const &lhs, AVL_tree<T, C, A, B> const &rhs, AVL_tree<T, C, A, B> &result ) {
+    AVL_tree<T, C, A, B>::build_set_operation( lhs, rhs, result, AVL_tree<T, C, A, B>::SET_UNION );
+}
+
+template <typename T, typename C, template <typename> class A, typename B>
+void set_intersection( AVL_tree<T, C, A, B> const &lhs, AVL_tree<T, C, A, B> const &rhs, AVL_tree<T, C, A, B> &result ) {
+    AVL_tree<T, C, A, B>::build_set_operation( lhs, rhs, result, AVL_tree<T, C, A, B>::SET_INTERSECTION );
+}
+
+template <typename T, typename C, template <typename> class A, typename B>
+void set_difference( AVL_tree<T, C, A, B> const &lhs, AVL_tree<T, C, A, B> const &rhs, AVL_tree<T, C, A, B> &result ) {
+    AVL_tree<T, C, A, B>::build_set_operation( lhs, rhs, result, AVL_tree<T, C, A, B>::SET_DIFFERENCE );
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::build_set_operation( AVL_tree const &lhs, AVL_tree const &rhs, AVL_tree &result, Set_operation operation ) {
+    if ( &result == &lhs || &result == &rhs ) {
+        throw illegal_argument();
+    }
+    
+    result.build_from_sorted( Set_walk( lhs, rhs, operation ), Set_walk() );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                             Set_walk                             //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::Set_walk():
+lhs_tree( nullptr ),
+rhs_tree( nullptr ),
+operation( SET_UNION ),
+probe( false ),
+swapped( false ),
+lhs_node( nullptr ),
+rhs_node( nullptr ),
+current_node( nullptr ) {
+    // does nothing
+}
+
+/* Searching the larger tree costs about log2 of its size per value of the smaller one, so
+ * it is used when that adds up to less than walking both trees. A union always produces
+ * every value, so it always walks. */
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::Set_walk( AVL_tree const &lhs, AVL_tree const &rhs, Set_operation set_operation ):
+lhs_tree( &lhs ),
+rhs_tree( &rhs ),
+operation( set_operation ),
+probe( false ),
+swapped( false ),
+lhs_node( lhs.front_sentinel->next_node ),
+rhs_node( rhs.front_sentinel->next_node ),
+current_node( nullptr ) {
+    int smaller = ( lhs.size() < rhs.size() ) ? lhs.size() : rhs.size();
+    int larger = ( lhs.size() < rhs.size() ) ? rhs.size() : lhs.size();
+    int search_cost = 1;
+    
+    while ( ( 1 << search_cost ) < larger && search_cost < 31 ) {
+        ++search_cost;
+    }
+    
+    bool cheaper = ( static_cast<long long>( smaller )*search_cost < static_cast<long long>( larger ) );
+    
+    if ( operation == SET_INTERSECTION ) {
+        probe = cheaper;
+        
+        // The smaller tree is walked and the larger one searched.
+        if ( probe && rhs.size() < lhs.size() ) {
+            std::swap( lhs_tree, rhs_tree );
+            std::swap( lhs_node, rhs_node );
+            swapped = true;
+        }
+    } else if ( operation == SET_DIFFERENCE ) {
+        probe = cheaper && lhs.size() <= rhs.size();
+    }
+    
+    advance();
+}
+
+// Moves current_node to the next value produced, or to nullptr.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+void AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::advance() {
+    Node *lhs_end = lhs_tree->back_sentinel;
+    Node *rhs_end = rhs_tree->back_sentinel;
+    Compare const &compare = lhs_tree->compare;
+    
+    if ( probe ) {
+        while ( lhs_node != lhs_end ) {
+            Node *walked = lhs_node;
+            Node *found = rhs_tree->find_node( walked->node_value );
+            lhs_node = lhs_node->next_node;
+            
+            if ( operation == SET_DIFFERENCE && found == rhs_end ) {
+                current_node = walked;
+                return;
+            }
+            
+            // Equal values are taken from the first tree, which is the searched one if swapped.
+            if ( operation == SET_INTERSECTION && found != rhs_end ) {
+                current_node = swapped ? found : walked;
+                return;
+            }
+        }
+        
+        current_node = nullptr;
+        return;
+    }
+    
+    while ( lhs_node != lhs_end || rhs_node != rhs_end ) {
+        bool lhs_lower = ( rhs_node == rhs_end ) || ( lhs_node != lhs_end && compare( lhs_node->node_value, rhs_node->node_value ) );
+        bool rhs_lower = !lhs_lower && ( ( lhs_node == lhs_end ) || compare( rhs_node->node_value, lhs_node->node_value ) );
+        
+        if ( lhs_lower ) {
+            Node *walked = lhs_node;
+            lhs_node = lhs_node->next_node;
+            
+            if ( operation != SET_INTERSECTION ) {
+                current_node = walked;
+                return;
+            }
+        } else if ( rhs_lower ) {
+            Node *walked = rhs_node;
+            rhs_node = rhs_node->next_node;
+            
+            if ( operation == SET_UNION ) {
+                current_node = walked;
+                return;
+            }
+        } else {
+            // The value is in both trees.
+            Node *walked = lhs_node;
+            lhs_node = lhs_node->next_node;
+            rhs_node = rhs_node->next_node;
+            
+            if ( operation != SET_DIFFERENCE ) {
+                current_node = walked;
+                return;
+            }
+        }
+        
+        // Nothing more can come out of a difference once lhs is done, or of an intersection once either is.
+        if ( ( operation != SET_UNION && lhs_node == lhs_end ) || ( operation == SET_INTERSECTION && rhs_node == rhs_end ) ) {
+            break;
+        }
+    }
+    
+    current_node = nullptr;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+Type const &AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::operator*() const {
+    return current_node->node_value;
+}
+
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+typename AVL_tree<Type, Compare, Allocator, Balance>::Set_walk &AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::operator++() {
+    advance();
+    return *this;
+}
+
+// Two walks only differ while one of them is still producing values.
+template <typename Type, typename Compare, template <typename> class Allocator, typename Balance>
+bool AVL_tree<Type, Compare, Allocator, Balance>::Set_walk::operator!=( Set_walk const &rhs ) const {
+    return ( current_node != rhs.current_node );
+}
+
+#endif
+
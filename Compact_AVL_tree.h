@@ -0,0 +1,533 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef COMPACT_AVL_TREE_H
+#define COMPACT_AVL_TREE_H
+
+#include <cstdint>
+#include <vector>
+
+/* AVL tree with a compact node layout, for large trees where the memory per value matters.
+ *
+ * Compared to AVL_tree:
+ *  - Nodes live in one contiguous pool and refer to each other through 32-bit indices.
+ *  - Each node stores a 2-bit balance factor instead of its height, packed in the
+ *    same word as the index of its left sub-tree (so the tree holds up to 2^30 - 1 nodes).
+ *  - There are no previous/next links. Iterators keep the path from the root instead.
+ * That is 8 bytes per node on top of the value, against 40 or more for AVL_tree.
+ *
+ * Inserting or erasing may move the pool and invalidates every iterator. */
+template <typename Type>
+class Compact_AVL_tree {
+    public:
+        class Iterator;
+
+    private:
+        static const std::uint32_t NIL = ( 1u << 30 ) - 1;     // The empty sub-tree.
+        static const std::uint32_t INDEX_MASK = ( 1u << 30 ) - 1;
+        static const int MAX_HEIGHT = 64;
+
+        // Balance factors are stored as height( right ) - height( left ) + 1.
+        enum { LEFT_HEAVY = 0, BALANCED = 1, RIGHT_HEAVY = 2 };
+
+        class Node {
+            public:
+                Type node_value;
+                std::uint32_t left_and_balance;     // Balance factor in the 2 high bits.
+                std::uint32_t right_tree;           // Also links the free nodes together.
+
+                Node( Type const & );
+        };
+
+        std::vector<Node> node_pool;
+        std::uint32_t root_node;
+        std::uint32_t free_list;                   // Nodes erased and available for reuse.
+        int tree_size;
+
+        std::uint32_t left( std::uint32_t n ) const;
+        std::uint32_t right( std::uint32_t n ) const;
+        int balance( std::uint32_t n ) const;
+        void set_left( std::uint32_t n, std::uint32_t l );
+        void set_right( std::uint32_t n, std::uint32_t r );
+        void set_balance( std::uint32_t n, int b );
+
+        std::uint32_t create_node( Type const & );
+        void free_node( std::uint32_t );
+        std::uint32_t rotate( std::uint32_t, bool right_heavy, bool &height_changed );
+        void replace_child( std::uint32_t path[], bool went_right[], int depth, std::uint32_t );
+
+    public:
+        class Iterator {
+            private:
+                Compact_AVL_tree const *containing_tree;
+                std::uint32_t path[MAX_HEIGHT];     // Nodes from the root to the current node.
+                int depth;                          // The iterator is at end() when depth is 0.
+
+                Iterator( Compact_AVL_tree const *tree );
+
+            public:
+                Type const &operator*() const;
+                Iterator &operator++();
+                Iterator &operator--();
+                bool operator==( Iterator const &rhs ) const;
+                bool operator!=( Iterator const &rhs ) const;
+
+                friend class Compact_AVL_tree;
+        };
+
+        Compact_AVL_tree();
+
+        bool empty() const;
+        int size() const;
+        int height() const;
+
+        Type front() const;
+        Type back() const;
+
+        Iterator begin() const;
+        Iterator end() const;
+        Iterator find( Type const & ) const;
+
+        void reserve( int );
+        void clear();
+        bool insert( Type const & );
+        bool erase( Type const & );
+
+    // Lets tests/Compact_AVL_tree_test.cpp check the balance factors and the free list.
+    friend class Compact_AVL_tree_tester;
+};
+
+//////////////////////////////////////////////////////////////////////
+//                Search Tree Public Member Functions               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Compact_AVL_tree<Type>::Compact_AVL_tree():
+root_node( NIL ),
+free_list( NIL ),
+tree_size( 0 ) {
+    // does nothing
+}
+
+template <typename Type>
+bool Compact_AVL_tree<Type>::empty() const {
+    return ( root_node == NIL );
+}
+
+template <typename Type>
+int Compact_AVL_tree<Type>::size() const {
+    return tree_size;
+}
+
+/* Returns the height of the tree. Without stored heights the height is found by always
+ * following the taller sub-tree, which the balance factors point to. */
+template <typename Type>
+int Compact_AVL_tree<Type>::height() const {
+    int tree_height = -1;
+
+    for ( std::uint32_t n = root_node; n != NIL; n = ( balance( n ) == RIGHT_HEAVY ) ? right( n ) : left( n ) ) {
+        ++tree_height;
+    }
+
+    return tree_height;
+}
+
+// Returns the value of the left-most node.
+template <typename Type>
+Type Compact_AVL_tree<Type>::front() const {
+    if ( empty() ) {
+        throw underflow();
+    }
+
+    return *begin();
+}
+
+// Returns the value of the right-most node.
+template <typename Type>
+Type Compact_AVL_tree<Type>::back() const {
+    if ( empty() ) {
+        throw underflow();
+    }
+
+    std::uint32_t n = root_node;
+    while ( right( n ) != NIL ) {
+        n = right( n );
+    }
+
+    return node_pool[n].node_value;
+}
+
+template <typename Type>
+typename Compact_AVL_tree<Type>::Iterator Compact_AVL_tree<Type>::begin() const {
+    Iterator itr( this );
+
+    for ( std::uint32_t n = root_node; n != NIL; n = left( n ) ) {
+        itr.path[itr.depth++] = n;
+    }
+
+    return itr;
+}
+
+template <typename Type>
+typename Compact_AVL_tree<Type>::Iterator Compact_AVL_tree<Type>::end() const {
+    return Iterator( this );
+}
+
+// Returns an iterator to obj, or end() if obj is not in the tree.
+template <typename Type>
+typename Compact_AVL_tree<Type>::Iterator Compact_AVL_tree<Type>::find( Type const &obj ) const {
+    Iterator itr( this );
+
+    for ( std::uint32_t n = root_node; n != NIL; n = ( obj < node_pool[n].node_value ) ? left( n ) : right( n ) ) {
+        itr.path[itr.depth++] = n;
+
+        if ( obj == node_pool[n].node_value ) {
+            return itr;
+        }
+    }
+
+    return end();
+}
+
+// Reserves room for n nodes so that the pool is not moved while the tree grows.
+template <typename Type>
+void Compact_AVL_tree<Type>::reserve( int n ) {
+    node_pool.reserve( n );
+}
+
+template <typename Type>
+void Compact_AVL_tree<Type>::clear() {
+    node_pool.clear();
+    root_node = NIL;
+    free_list = NIL;
+    tree_size = 0;
+}
+
+/* This method inserts a value in the tree. If the value already exists it returns false.
+ * The balance factors are updated bottom-up along the search path until a sub-tree keeps
+ * its height; at most one rotation is needed. */
+template <typename Type>
+bool Compact_AVL_tree<Type>::insert( Type const &obj ) {
+    std::uint32_t path[MAX_HEIGHT];
+    bool went_right[MAX_HEIGHT];
+    int depth = 0;
+
+    for ( std::uint32_t n = root_node; n != NIL; ) {
+        if ( obj == node_pool[n].node_value ) {
+            return false;
+        }
+
+        path[depth] = n;
+        went_right[depth] = !( obj < node_pool[n].node_value );
+        n = went_right[depth] ? right( n ) : left( n );
+        ++depth;
+    }
+
+    std::uint32_t new_node = create_node( obj );
+    replace_child( path, went_right, depth, new_node );
+    ++tree_size;
+
+    // Each step up, the sub-tree we came from is one level taller.
+    while ( depth > 0 ) {
+        std::uint32_t n = path[--depth];
+        int new_balance = balance( n ) + ( went_right[depth] ? 1 : -1 );
+
+        if ( new_balance == BALANCED ) {
+            set_balance( n, BALANCED );
+            break;
+        } else if ( new_balance == LEFT_HEAVY || new_balance == RIGHT_HEAVY ) {
+            set_balance( n, new_balance );
+        } else {
+            // A rotation after an insertion always restores the previous height.
+            bool height_changed;
+            replace_child( path, went_right, depth, rotate( n, went_right[depth], height_changed ) );
+            break;
+        }
+    }
+
+    return true;
+}
+
+/* This method erases a value from the tree. If the value doesn't exist it returns false.
+ * A node with two children takes the value of the next node, which is removed instead.
+ * The balance factors are updated bottom-up until a sub-tree keeps its height. */
+template <typename Type>
+bool Compact_AVL_tree<Type>::erase( Type const &obj ) {
+    std::uint32_t path[MAX_HEIGHT];
+    bool went_right[MAX_HEIGHT];
+    int depth = 0;
+
+    std::uint32_t n = root_node;
+
+    while ( n != NIL && !( obj == node_pool[n].node_value ) ) {
+        path[depth] = n;
+        went_right[depth] = !( obj < node_pool[n].node_value );
+        n = went_right[depth] ? right( n ) : left( n );
+        ++depth;
+    }
+
+    if ( n == NIL ) {
+        return false;
+    }
+
+    if ( left( n ) != NIL && right( n ) != NIL ) {
+        // The next node is the left-most node of the right sub-tree.
+        std::uint32_t target = n;
+        path[depth] = n;
+        went_right[depth] = true;
+        ++depth;
+
+        for ( n = right( n ); left( n ) != NIL; n = left( n ) ) {
+            path[depth] = n;
+            went_right[depth] = false;
+            ++depth;
+        }
+
+        node_pool[target].node_value = node_pool[n].node_value;
+    }
+
+    replace_child( path, went_right, depth, ( left( n ) != NIL ) ? left( n ) : right( n ) );
+    free_node( n );
+    --tree_size;
+
+    // Each step up, the sub-tree we came from is one level shorter.
+    while ( depth > 0 ) {
+        std::uint32_t p = path[--depth];
+        int new_balance = balance( p ) + ( went_right[depth] ? -1 : 1 );
+
+        if ( new_balance == LEFT_HEAVY || new_balance == RIGHT_HEAVY ) {
+            // The sub-tree was balanced and keeps its height.
+            set_balance( p, new_balance );
+            break;
+        } else if ( new_balance == BALANCED ) {
+            set_balance( p, BALANCED );
+        } else {
+            // The sub-tree on the other side is now two levels taller.
+            bool height_changed;
+            replace_child( path, went_right, depth, rotate( p, !went_right[depth], height_changed ) );
+
+            if ( !height_changed ) {
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+//              Search Tree Private Member Functions                //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+std::uint32_t Compact_AVL_tree<Type>::left( std::uint32_t n ) const {
+    return node_pool[n].left_and_balance & INDEX_MASK;
+}
+
+template <typename Type>
+std::uint32_t Compact_AVL_tree<Type>::right( std::uint32_t n ) const {
+    return node_pool[n].right_tree;
+}
+
+template <typename Type>
+int Compact_AVL_tree<Type>::balance( std::uint32_t n ) const {
+    return static_cast<int>( node_pool[n].left_and_balance >> 30 );
+}
+
+template <typename Type>
+void Compact_AVL_tree<Type>::set_left( std::uint32_t n, std::uint32_t l ) {
+    node_pool[n].left_and_balance = ( node_pool[n].left_and_balance & ~INDEX_MASK ) | l;
+}
+
+template <typename Type>
+void Compact_AVL_tree<Type>::set_right( std::uint32_t n, std::uint32_t r ) {
+    node_pool[n].right_tree = r;
+}
+
+template <typename Type>
+void Compact_AVL_tree<Type>::set_balance( std::uint32_t n, int b ) {
+    node_pool[n].left_and_balance = ( node_pool[n].left_and_balance & INDEX_MASK ) | ( static_cast<std::uint32_t>( b & 3 ) << 30 );
+}
+
+// Returns the index of a new leaf, reusing an erased node if there is one.
+template <typename Type>
+std::uint32_t Compact_AVL_tree<Type>::create_node( Type const &obj ) {
+    std::uint32_t n;
+
+    if ( free_list != NIL ) {
+        n = free_list;
+        free_list = node_pool[n].right_tree;
+        node_pool[n].node_value = obj;
+    } else {
+        if ( node_pool.size() >= NIL ) {
+            throw overflow();
+        }
+
+        n = static_cast<std::uint32_t>( node_pool.size() );
+        node_pool.push_back( Node( obj ) );
+    }
+
+    node_pool[n].left_and_balance = NIL | ( static_cast<std::uint32_t>( BALANCED ) << 30 );
+    node_pool[n].right_tree = NIL;
+
+    return n;
+}
+
+// Puts a node on the free list. Its value is reset so that its resources are released.
+template <typename Type>
+void Compact_AVL_tree<Type>::free_node( std::uint32_t n ) {
+    node_pool[n].node_value = Type();
+    node_pool[n].right_tree = free_list;
+    free_list = n;
+}
+
+/* Rotates the sub-tree rooted at n, whose right (if right_heavy) or left sub-tree is two
+ * levels taller than the other one, and returns the new root of the sub-tree. A balance
+ * factor of +2 or -2 does not fit in 2 bits, so it is never stored. height_changed is set
+ * to false only if the sub-tree keeps its height (a single rotation around a balanced
+ * child, which can only happen after an erase). */
+template <typename Type>
+std::uint32_t Compact_AVL_tree<Type>::rotate( std::uint32_t n, bool right_heavy, bool &height_changed ) {
+    int heavy = right_heavy ? RIGHT_HEAVY : LEFT_HEAVY;
+    int light = right_heavy ? LEFT_HEAVY : RIGHT_HEAVY;
+    std::uint32_t child = right_heavy ? right( n ) : left( n );
+    int child_balance = balance( child );
+
+    if ( child_balance != light ) {
+        // Single rotation
+        if ( right_heavy ) {
+            set_right( n, left( child ) );
+            set_left( child, n );
+        } else {
+            set_left( n, right( child ) );
+            set_right( child, n );
+        }
+
+        height_changed = ( child_balance == heavy );
+        set_balance( n, height_changed ? BALANCED : heavy );
+        set_balance( child, height_changed ? BALANCED : light );
+
+        return child;
+    }
+
+    // Double rotation: the grandchild on the inner side becomes the root.
+    std::uint32_t grandchild = right_heavy ? left( child ) : right( child );
+    int grandchild_balance = balance( grandchild );
+
+    if ( right_heavy ) {
+        set_right( n, left( grandchild ) );
+        set_left( child, right( grandchild ) );
+        set_left( grandchild, n );
+        set_right( grandchild, child );
+    } else {
+        set_left( n, right( grandchild ) );
+        set_right( child, left( grandchild ) );
+        set_right( grandchild, n );
+        set_left( grandchild, child );
+    }
+
+    set_balance( n, ( grandchild_balance == heavy ) ? light : BALANCED );
+    set_balance( child, ( grandchild_balance == light ) ? heavy : BALANCED );
+    set_balance( grandchild, BALANCED );
+    height_changed = true;
+
+    return grandchild;
+}
+
+// Makes the node at path[depth - 1] (or the root if depth is 0) point to child.
+template <typename Type>
+void Compact_AVL_tree<Type>::replace_child( std::uint32_t path[], bool went_right[], int depth, std::uint32_t child ) {
+    if ( depth == 0 ) {
+        root_node = child;
+    } else if ( went_right[depth - 1] ) {
+        set_right( path[depth - 1], child );
+    } else {
+        set_left( path[depth - 1], child );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Node Public Member Functions                   //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Compact_AVL_tree<Type>::Node::Node( Type const &obj ):
+node_value( obj ),
+left_and_balance( NIL | ( static_cast<std::uint32_t>( BALANCED ) << 30 ) ),
+right_tree( NIL ) {
+    // does nothing
+}
+
+//////////////////////////////////////////////////////////////////////
+//                 Iterator Public Member Functions                 //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Compact_AVL_tree<Type>::Iterator::Iterator( Compact_AVL_tree const *tree ):
+containing_tree( tree ),
+depth( 0 ) {
+    // does nothing
+}
+
+template <typename Type>
+Type const &Compact_AVL_tree<Type>::Iterator::operator*() const {
+    return containing_tree->node_pool[path[depth - 1]].node_value;
+}
+
+/* Moves to the next value. If the current node has a right sub-tree, the next node is its
+ * left-most node. Otherwise it is the first ancestor reached from a left sub-tree. */
+template <typename Type>
+typename Compact_AVL_tree<Type>::Iterator &Compact_AVL_tree<Type>::Iterator::operator++() {
+    if ( depth == 0 ) {
+        return *this;
+    }
+
+    std::uint32_t n = path[depth - 1];
+
+    if ( containing_tree->right( n ) != NIL ) {
+        for ( n = containing_tree->right( n ); n != NIL; n = containing_tree->left( n ) ) {
+            path[depth++] = n;
+        }
+    } else {
+        do {
+            n = path[--depth];
+        } while ( depth > 0 && containing_tree->right( path[depth - 1] ) == n );
+    }
+
+    return *this;
+}
+
+// Moves to the previous value. From end() it moves to the right-most node.
+template <typename Type>
+typename Compact_AVL_tree<Type>::Iterator &Compact_AVL_tree<Type>::Iterator::operator--() {
+    std::uint32_t n;
+
+    if ( depth == 0 ) {
+        for ( n = containing_tree->root_node; n != NIL; n = containing_tree->right( n ) ) {
+            path[depth++] = n;
+        }
+    } else if ( containing_tree->left( path[depth - 1] ) != NIL ) {
+        for ( n = containing_tree->left( path[depth - 1] ); n != NIL; n = containing_tree->right( n ) ) {
+            path[depth++] = n;
+        }
+    } else {
+        do {
+            n = path[--depth];
+        } while ( depth > 0 && containing_tree->left( path[depth - 1] ) == n );
+    }
+
+    return *this;
+}
+
+template <typename Type>
+bool Compact_AVL_tree<Type>::Iterator::operator==( Iterator const &rhs ) const {
+    return ( depth == rhs.depth ) && ( depth == 0 || path[depth - 1] == rhs.path[depth - 1] );
+}
+
+template <typename Type>
+bool Compact_AVL_tree<Type>::Iterator::operator!=( Iterator const &rhs ) const {
+    return !( *this == rhs );
+}
+
+#endif
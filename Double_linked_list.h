@@ -5,24 +5,40 @@
  // Signature type methods provided by Douglas W. Harder https://ece.uwaterloo.ca/~dwharder/
  
 #include <iostream>
-
-template <typename Type>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Node_pool.h"
+
+// Allocator is a node allocator as described in Node_pool.h. Every node of the list comes
+// from it, so a list in steady state never touches the heap. The two sentinels are members
+// of the list and hold no value, so moving a list allocates nothing.
+template <typename Type, template <typename> class Allocator = Node_pool>
 class Double_linked_list {
 	public:
 		class Double_node {
 			public:
-				Double_node( Type const & = Type(), Double_node * = nullptr, Double_node * = nullptr );
+				Double_node();     // A sentinel: no value is constructed.
+				template <typename... Args>
+				Double_node( Double_node *, Double_node *, Args &&... );
+				~Double_node();    // The list destroys the value, as sentinels have none.
 
-				Type value() const;
+				Type &value();
+				Type const &value() const;
 				Double_node *previous() const;
 				Double_node *next() const;
 
-				Type         node_value;
+				union {
+					Type     node_value;
+				};
 				Double_node *previous_node;
 				Double_node *next_node;
 		};
 
+		typedef Allocator<Double_node> Node_allocator;
+
 		Double_linked_list();
+		explicit Double_linked_list( Node_allocator const & );   // Lists built with copies of one pool share its nodes.
 		Double_linked_list( Double_linked_list const & );
 		Double_linked_list( Double_linked_list && );
 		~Double_linked_list();
@@ -32,8 +48,10 @@ class Double_linked_list {
 		int size() const;
 		bool empty() const;
 
-		Type front() const;
-		Type back() const;
+		Type &front();
+		Type const &front() const;
+		Type &back();
+		Type const &back() const;
 
 		Double_node *begin() const;
 		Double_node *end() const;
@@ -46,28 +64,55 @@ class Double_linked_list {
 		// Mutators
 
 		void swap( Double_linked_list & );
-		Double_linked_list &operator=( Double_linked_list );
+		Double_linked_list &operator=( Double_linked_list const & );
 		Double_linked_list &operator=( Double_linked_list && );
 
 		void push_front( Type const & );
+		void push_front( Type && );
 		void push_back( Type const & );
+		void push_back( Type && );
+
+		template <typename... Args>
+		void emplace_front( Args &&... );
+		template <typename... Args>
+		void emplace_back( Args &&... );
 
 		void pop_front();
 		void pop_back();
 
 		int erase( Type const & );
 
+		// Positional operations (a position is a node of the list, or end())
+
+		Double_node *insert_before( Double_node *, Type const & );
+		Double_node *erase( Double_node * );
+
+		void splice( Double_node *, Double_linked_list & );
+		void splice( Double_node *, Double_linked_list &, Double_node * );
+		void splice( Double_node *, Double_linked_list &, Double_node *, Double_node * );
+
+		void merge( Double_linked_list & );
+		void sort();
+
 	private:
-		Double_node *list_head;
-		Double_node *list_tail;
+		Node_allocator node_allocator;
+		mutable Double_node list_head;    // Mutable because the const accessors hand the
+		mutable Double_node list_tail;    // sentinels out as positions.
 		int list_size;
 
 	// Friends
 
-	template <typename T>
-	friend std::ostream &operator<<( std::ostream &, Double_linked_list<T> const & );
+	template <typename T, template <typename> class A>
+	friend std::ostream &operator<<( std::ostream &, Double_linked_list<T, A> const & );
     
     void initialize_list();
+    void link_chain( Double_node *, Double_node * );
+    template <typename... Args>
+    Double_node *create_node( Double_node *, Double_node *, Args &&... );
+    void destroy_node( Double_node * );
+    void share_nodes( Double_linked_list & );
+    static void link_before( Double_node *, Double_node *, Double_node * );
+    static void unlink( Double_node *, Double_node * );
 };
 
 /////////////////////////////////////////////////////////////////////////
@@ -75,27 +120,43 @@ class Double_linked_list {
 /////////////////////////////////////////////////////////////////////////
 
 ////////////////////// Default Constructor ///////////////////////////////////////
-template <typename Type>
-Double_linked_list<Type>::Double_linked_list():
-list_head( new Double_node() ),
-list_tail( new Double_node() ),
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_linked_list():
+node_allocator(),
+list_head(),
+list_tail(),
+list_size( 0 )
+{
+    initialize_list();
+}
+
+////////////////////// Allocator Constructor ///////////////////////////////////////
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_linked_list( Node_allocator const &allocator ):
+node_allocator( allocator ),
+list_head(),
+list_tail(),
 list_size( 0 )
 {
     initialize_list();
 }
 
 ////////////////////// Copy Constructor ///////////////////////////////////////
-template <typename Type>
-Double_linked_list<Type>::Double_linked_list( Double_linked_list<Type> const &list ):
-list_head( new Double_node() ),
-list_tail( new Double_node() ),
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_linked_list( Double_linked_list<Type, Allocator> const &list ):
+node_allocator(),
+list_head(),
+list_tail(),
 list_size( 0 )
 {
     // Initializing sentinels for new list
     initialize_list();
     
+    // All the nodes are carved out of one block, next to each other in list order.
+    node_allocator.reserve(list.size());
+    
     // Copy of the first node of the argument Linked List.
-    Double_node* arg_current_node = list.list_head->next()->next();
+    Double_node* arg_current_node = list.begin();
     
     // Copying node by node into the new Linked List.
     while(arg_current_node->next() != nullptr)
@@ -106,48 +167,46 @@ list_size( 0 )
 }
 
 ////////////////////// Move Constructor ///////////////////////////////////////
-template <typename Type>
-Double_linked_list<Type>::Double_linked_list( Double_linked_list<Type> &&list ):
-list_head( new Double_node() ),
-list_tail( new Double_node() ),
+// Nothing is allocated: the new list swaps its empty allocator (a pool only allocates once
+// used) for list's, and its nodes, so it owns them alone and list is left empty.
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_linked_list( Double_linked_list<Type, Allocator> &&list ):
+node_allocator(),
+list_head(),
+list_tail(),
 list_size( 0 )
 {
     initialize_list();
     swap(list);
 }
 ///////////////////////// Destructor //////////////////////////////////////////
-template <typename Type>
-Double_linked_list<Type>::~Double_linked_list()
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::~Double_linked_list()
 {
-    // Deleting all nodes first.
+    // A pool used by this list alone drops all of its slabs at once, so the nodes
+    // only have to be visited when their values have destructors to run.
+    if ( std::is_trivially_destructible<Type>::value && node_allocator.release() )
+    {
+        return;
+    }
+    
+    // Deleting all nodes. The sentinels are members and go with the list.
     while (!empty())
     {
         pop_front();
     }
-    
-    // Deleting sentinels.
-    list_head->next_node->next_node = nullptr;
-    list_tail->next_node->previous_node = nullptr;
-    delete list_head->next();
-    delete list_tail->next();
-    
-    // Deleting head an tail nodes.
-    list_head->next_node = nullptr;
-    list_tail->next_node = nullptr;
-    delete list_head;
-    delete list_tail;
 }
 
 // Returns the size of the Linked List.
-template <typename Type>
-int Double_linked_list<Type>::size() const
+template <typename Type, template <typename> class Allocator>
+int Double_linked_list<Type, Allocator>::size() const
 {
 	return list_size;
 }
 
 // Returns true if list is empty.
-template <typename Type>
-bool Double_linked_list<Type>::empty() const
+template <typename Type, template <typename> class Allocator>
+bool Double_linked_list<Type, Allocator>::empty() const
 {
     if(list_size == 0){
         return true;
@@ -155,59 +214,77 @@ bool Double_linked_list<Type>::empty() const
     return false;
 }
 
-// This method returns the value of the first node in the Linked List.
-template <typename Type>
-Type Double_linked_list<Type>::front() const
+// This method returns a reference to the value of the first node in the Linked List.
+template <typename Type, template <typename> class Allocator>
+Type &Double_linked_list<Type, Allocator>::front()
 {
     // Throw exception if Linked List is empty.
     if(empty()){
         throw underflow();
     }
     // If non-empty, return the value of the first node.
-	return list_head->next()->next()->value();
+	return list_head.next()->value();
 }
 
-// This method returns the value of the last node in the Linked List.
-template <typename Type>
-Type Double_linked_list<Type>::back() const
+template <typename Type, template <typename> class Allocator>
+Type const &Double_linked_list<Type, Allocator>::front() const
+{
+    if(empty()){
+        throw underflow();
+    }
+	return list_head.next()->value();
+}
+
+// This method returns a reference to the value of the last node in the Linked List.
+template <typename Type, template <typename> class Allocator>
+Type &Double_linked_list<Type, Allocator>::back()
 {
     // Throw exception if Linked List is empty.
     if(empty()){
         throw underflow();
     }
     // If non-empty, return the value of the last node.
-	return list_tail->next()->previous()->value();
+	return list_tail.previous()->value();
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::begin() const
+template <typename Type, template <typename> class Allocator>
+Type const &Double_linked_list<Type, Allocator>::back() const
 {
-	return list_head->next()->next();
+    if(empty()){
+        throw underflow();
+    }
+	return list_tail.previous()->value();
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::end() const
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::begin() const
 {
-	return list_tail->next();
+	return list_head.next();
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::rbegin() const
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::end() const
 {
-	return list_tail->next()->previous();
+	return &list_tail;
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::rend() const
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::rbegin() const
 {
-	return list_head->next();
+	return list_tail.previous();
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::rend() const
+{
+	return &list_head;
 }
 
 // This method returns the address of the first node whose value equals "obj".
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::find( Type const &obj ) const
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::find( Type const &obj ) const
 {
-    Double_node* current_node = list_head->next()->next();
+    Double_node* current_node = begin();
     while (current_node->next() != nullptr)
     {
         if(current_node->value() == obj)
@@ -221,11 +298,11 @@ typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::find(
 }
 
 // This method returns the number of nodes in the Linked List whose value equals to "obj".
-template <typename Type>
-int Double_linked_list<Type>::count( Type const &obj ) const
+template <typename Type, template <typename> class Allocator>
+int Double_linked_list<Type, Allocator>::count( Type const &obj ) const
 {
     int total_matches = 0;
-    Double_node* current_node = list_head->next()->next();
+    Double_node* current_node = begin();
     
     while(current_node->next() != nullptr)
     {
@@ -238,24 +315,32 @@ int Double_linked_list<Type>::count( Type const &obj ) const
 	return total_matches;
 }
 
-template <typename Type>
-void Double_linked_list<Type>::swap( Double_linked_list<Type> &list ) {
-	// This is done for you
-	std::swap( list_head, list.list_head );
-	std::swap( list_tail, list.list_tail );
+// The sentinels stay with their lists, so the two chains of nodes are relinked to them in O(1).
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::swap( Double_linked_list<Type, Allocator> &list ) {
+	Double_node *first = empty() ? nullptr : begin();
+	Double_node *last = empty() ? nullptr : rbegin();
+	Double_node *list_first = list.empty() ? nullptr : list.begin();
+	Double_node *list_last = list.empty() ? nullptr : list.rbegin();
+
+	link_chain( list_first, list_last );
+	list.link_chain( first, last );
+
+	std::swap( node_allocator, list.node_allocator );
     std::swap( list_size, list.list_size );
 }
 
-template <typename Type>
-Double_linked_list<Type> &Double_linked_list<Type>::operator=( Double_linked_list<Type> rhs ) {
-	// This is done for you
-	swap( rhs );
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator> &Double_linked_list<Type, Allocator>::operator=( Double_linked_list<Type, Allocator> const &rhs ) {
+	// Taking rhs by const reference keeps an rvalue from matching both assignments.
+	Double_linked_list<Type, Allocator> copy( rhs );
+	swap( copy );
     
 	return *this;
 }
 
-template <typename Type>
-Double_linked_list<Type> &Double_linked_list<Type>::operator=( Double_linked_list<Type> &&rhs ) {
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator> &Double_linked_list<Type, Allocator>::operator=( Double_linked_list<Type, Allocator> &&rhs ) {
 	// This is done for you
 	swap( rhs );
 
@@ -263,34 +348,60 @@ Double_linked_list<Type> &Double_linked_list<Type>::operator=( Double_linked_lis
 }
 
 // This method adds a number to the front of the Linked List.
-template <typename Type>
-void Double_linked_list<Type>::push_front( Type const &obj ) {
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::push_front( Type const &obj ) {
+    emplace_front(obj);
+}
+
+// This method moves obj to the front of the Linked List.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::push_front( Type &&obj ) {
+    emplace_front(std::move(obj));
+}
+
+// This method adds a number to the back of the Linked List.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::push_back( Type const &obj ) {
+    emplace_back(obj);
+}
+
+// This method moves obj to the back of the Linked List.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::push_back( Type &&obj ) {
+    emplace_back(std::move(obj));
+}
+
+// This method constructs a value in place, from args, at the front of the Linked List.
+template <typename Type, template <typename> class Allocator>
+template <typename... Args>
+void Double_linked_list<Type, Allocator>::emplace_front( Args &&...args ) {
     
     // Creating the new node and conecting it to the Linked List.
-    Double_node* new_node = new Double_node(obj, list_head->next(), list_head->next()->next());
-    list_head->next_node->next_node->previous_node = new_node;
-    list_head->next_node->next_node = new_node;
+    Double_node* new_node = create_node(&list_head, list_head.next(), std::forward<Args>(args)...);
+    list_head.next_node->previous_node = new_node;
+    list_head.next_node = new_node;
     
     // Updating Linked List's fields.
     list_size++;
 }
 
-// This method adds a number to the back of the Linked List.
-template <typename Type>
-void Double_linked_list<Type>::push_back( Type const &obj ) {
+// This method constructs a value in place, from args, at the back of the Linked List.
+template <typename Type, template <typename> class Allocator>
+template <typename... Args>
+void Double_linked_list<Type, Allocator>::emplace_back( Args &&...args ) {
     
     // Creating the new node and conecting it to the Linked List.
-    Double_node* new_node = new Double_node(obj, list_tail->next()->previous(), list_tail->next());
-    list_tail->next_node->previous_node->next_node = new_node;
-    list_tail->next_node->previous_node = new_node;
+    Double_node* new_node = create_node(list_tail.previous(), &list_tail, std::forward<Args>(args)...);
+    list_tail.previous_node->next_node = new_node;
+    list_tail.previous_node = new_node;
     
     // Updating Linked List's fields.
     list_size++;
 }
 
 // This method removes the Linked List's first node.
-template <typename Type>
-void Double_linked_list<Type>::pop_front()
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::pop_front()
 {
     // Throw exception if Linked List is empty.
     if(empty()){
@@ -298,20 +409,20 @@ void Double_linked_list<Type>::pop_front()
         return;
     }
     
-    Double_node* deleted_node = list_head->next()->next();
+    Double_node* deleted_node = list_head.next();
     
     // Disconnecting the node from the Linked List and deleting it.
-    list_head->next_node->next_node = deleted_node->next();
-    deleted_node->next_node->previous_node = list_head->next();
-    delete deleted_node;
+    list_head.next_node = deleted_node->next();
+    deleted_node->next_node->previous_node = &list_head;
+    destroy_node( deleted_node );
     
     // Updating Linked List's fields.
     list_size--;
 }
 
 // This method removes the Linked List's last node.
-template <typename Type>
-void Double_linked_list<Type>::pop_back()
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::pop_back()
 {
     // Throw exception if Linked List is empty.
     if(empty()){
@@ -319,23 +430,23 @@ void Double_linked_list<Type>::pop_back()
         return;
     }
     
-    Double_node* garbage_node = list_tail->next()->previous();
+    Double_node* garbage_node = list_tail.previous();
     
     // Disconnecting the node from the Linked List and deleting it.
-    list_tail->next_node->previous_node = garbage_node->previous();
-    garbage_node->previous_node->next_node = list_tail->next();
-    delete garbage_node;
+    list_tail.previous_node = garbage_node->previous();
+    garbage_node->previous_node->next_node = &list_tail;
+    destroy_node( garbage_node );
     
     // Updating Linked List's fields.
     list_size--;
 }
 
 // This method deletes all Nodes whose value equals to "obj"
-template <typename Type>
-int Double_linked_list<Type>::erase( Type const &obj )
+template <typename Type, template <typename> class Allocator>
+int Double_linked_list<Type, Allocator>::erase( Type const &obj )
 {
     // Getting the first node
-    Double_node* current_node = list_head->next()->next();
+    Double_node* current_node = begin();
     
     int deleted_nodes = 0;
     while (current_node->next() != nullptr)
@@ -348,7 +459,7 @@ int Double_linked_list<Type>::erase( Type const &obj )
             
             Double_node* garbage_node = current_node;
             current_node = current_node->next();
-            delete garbage_node;
+            destroy_node( garbage_node );
             
             // Updating Linked list fields
             deleted_nodes++;
@@ -363,39 +474,274 @@ int Double_linked_list<Type>::erase( Type const &obj )
 	return deleted_nodes;
 }
 
+// This method inserts obj before the given node (or at the back if it is end()) and returns the new node.
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::insert_before( Double_node *position, Type const &obj )
+{
+    Double_node* new_node = create_node(position->previous(), position, obj);
+    position->previous_node->next_node = new_node;
+    position->previous_node = new_node;
+    
+    list_size++;
+    
+    return new_node;
+}
+
+// This method deletes the given node in O(1) and returns the node that followed it.
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::erase( Double_node *node )
+{
+    // Sentinels cannot be erased.
+    if(node->previous() == nullptr || node->next() == nullptr){
+        throw illegal_argument();
+    }
+    
+    Double_node* next_node = node->next();
+    unlink(node, node);
+    destroy_node( node );
+    
+    list_size--;
+    
+    return next_node;
+}
+
+// This method moves every node of list before position in O(1). list is left empty.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::splice( Double_node *position, Double_linked_list &list )
+{
+    if(&list == this || list.empty()){
+        return;
+    }
+    
+    splice(position, list, list.begin(), list.end());
+}
+
+// This method moves node, which belongs to list (possibly this list), before position in O(1).
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::splice( Double_node *position, Double_linked_list &list, Double_node *node )
+{
+    if(node == position || node->next() == position){
+        return;
+    }
+    
+    share_nodes(list);
+    
+    unlink(node, node);
+    link_before(position, node, node);
+    
+    list.list_size--;
+    list_size++;
+}
+
+/* This method moves the nodes [first, last) of list (possibly this list) before position,
+ * which must not be inside the range. The nodes are relinked in O(1), except that the
+ * range has to be counted when it moves between two lists (the whole list is not). */
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::splice( Double_node *position, Double_linked_list &list, Double_node *first, Double_node *last )
+{
+    // Moving a range in front of itself changes nothing.
+    if(first == last || position == first){
+        return;
+    }
+    
+    if(&list != this){
+        share_nodes(list);
+        
+        int moved_nodes = list.list_size;
+        
+        if(first != list.begin() || last != list.end()){
+            moved_nodes = 0;
+            for(Double_node* current_node = first; current_node != last; current_node = current_node->next()){
+                moved_nodes++;
+            }
+        }
+        
+        list.list_size -= moved_nodes;
+        list_size += moved_nodes;
+    }
+    
+    Double_node* back_node = last->previous();
+    unlink(first, back_node);
+    link_before(position, first, back_node);
+}
+
+/* This method moves the nodes of list into this list, both sorted, so that the result is
+ * sorted. Equal values of this list stay before those of list. O(n + m), no node is created. */
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::merge( Double_linked_list &list )
+{
+    if(&list == this){
+        return;
+    }
+    
+    share_nodes(list);
+    
+    Double_node* current_node = begin();
+    
+    while(!list.empty())
+    {
+        Double_node* moved_node = list.begin();
+        
+        // Finding the first node of this list higher than the node to move.
+        while(current_node != end() && !(moved_node->node_value < current_node->node_value))
+        {
+            current_node = current_node->next();
+        }
+        
+        // Moving the run of nodes of list that go before current_node.
+        Double_node* run_end = moved_node->next();
+        if(current_node != end())
+        {
+            while(run_end != list.end() && run_end->node_value < current_node->node_value)
+            {
+                run_end = run_end->next();
+            }
+        }
+        else
+        {
+            run_end = list.end();
+        }
+        
+        splice(current_node, list, moved_node, run_end);
+    }
+}
+
+/* This method sorts the list with a stable bottom-up merge sort that relinks the nodes,
+ * so no value is copied and no node is allocated. O(n log n) time and O(1) space.
+ * Each pass merges pairs of sorted runs of width nodes into runs of 2*width nodes. */
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::sort()
+{
+    if(list_size < 2){
+        return;
+    }
+    
+    Double_node* head_sentinel = rend();
+    Double_node* tail_sentinel = end();
+    
+    // The nodes are sorted as a chain that ends in nullptr, and linked back in at the end.
+    Double_node* chain = begin();
+    tail_sentinel->previous_node->next_node = nullptr;
+    
+    for(int width = 1; ; width *= 2)
+    {
+        Double_node* left = chain;
+        Double_node* last_node = nullptr;
+        int merges = 0;
+        chain = nullptr;
+        
+        while(left != nullptr)
+        {
+            merges++;
+            
+            // The right run starts width nodes after the left one.
+            Double_node* right = left;
+            int left_size = 0;
+            while(left_size < width && right != nullptr)
+            {
+                left_size++;
+                right = right->next_node;
+            }
+            int right_size = width;
+            
+            while(left_size > 0 || (right_size > 0 && right != nullptr))
+            {
+                Double_node* next_node;
+                
+                // Taking from the left run on ties keeps the sort stable.
+                if(left_size == 0 || (right_size > 0 && right != nullptr && right->node_value < left->node_value))
+                {
+                    next_node = right;
+                    right = right->next_node;
+                    right_size--;
+                }
+                else
+                {
+                    next_node = left;
+                    left = left->next_node;
+                    left_size--;
+                }
+                
+                if(last_node == nullptr)
+                {
+                    chain = next_node;
+                }
+                else
+                {
+                    last_node->next_node = next_node;
+                }
+                next_node->previous_node = last_node;
+                last_node = next_node;
+            }
+            
+            left = right;
+        }
+        
+        last_node->next_node = nullptr;
+        
+        if(merges <= 1)
+        {
+            // Linking the sorted chain back between the sentinels.
+            head_sentinel->next_node = chain;
+            chain->previous_node = head_sentinel;
+            last_node->next_node = tail_sentinel;
+            tail_sentinel->previous_node = last_node;
+            return;
+        }
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////
 //                      Nested Class Double_Node                       //
 /////////////////////////////////////////////////////////////////////////
 
-template <typename Type>
-Double_linked_list<Type>::Double_node::Double_node(
-	Type const &nv,
-	typename Double_linked_list<Type>::Double_node *pn,
-	typename Double_linked_list<Type>::Double_node *nn ):
-// Updated the initialization list here
-node_value( Type() ), // This assigns 'node_value' the default value of Type
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_node::Double_node():
 previous_node( nullptr ),
 next_node( nullptr )
 {
-    node_value = nv;
-    previous_node = pn;
-    next_node = nn;
+    // does nothing
+}
+
+// The value is constructed in place from args.
+template <typename Type, template <typename> class Allocator>
+template <typename... Args>
+Double_linked_list<Type, Allocator>::Double_node::Double_node(
+	typename Double_linked_list<Type, Allocator>::Double_node *pn,
+	typename Double_linked_list<Type, Allocator>::Double_node *nn,
+	Args &&...args ):
+previous_node( pn ),
+next_node( nn )
+{
+    new ( &node_value ) Type( std::forward<Args>( args )... );
+}
+
+template <typename Type, template <typename> class Allocator>
+Double_linked_list<Type, Allocator>::Double_node::~Double_node()
+{
+    // does nothing
 }
 
-template <typename Type>
-Type Double_linked_list<Type>::Double_node::value() const
+template <typename Type, template <typename> class Allocator>
+Type &Double_linked_list<Type, Allocator>::Double_node::value()
 {
 	return node_value;
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::Double_node::previous() const
+template <typename Type, template <typename> class Allocator>
+Type const &Double_linked_list<Type, Allocator>::Double_node::value() const
+{
+	return node_value;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::Double_node::previous() const
 {
 	return previous_node;
 }
 
-template <typename Type>
-typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::Double_node::next() const
+template <typename Type, template <typename> class Allocator>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::Double_node::next() const
 {
 	return next_node;
 }
@@ -405,37 +751,84 @@ typename Double_linked_list<Type>::Double_node *Double_linked_list<Type>::Double
 /////////////////////////////////////////////////////////////////////////
 
 // Some repeated code from the Double_linked_list Constructor.
-// It initializes the head, tail and sentinel nodes.
-template <typename Type>
-void Double_linked_list<Type>::initialize_list()
+// It links the head and tail sentinels to each other.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::initialize_list()
 {
+    link_chain(nullptr, nullptr);
+}
+
+// Links the chain of nodes first..last between the sentinels, or leaves the list without nodes if first is nullptr.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::link_chain( Double_node *first, Double_node *last )
+{
+    if(first == nullptr){
+        list_head.next_node = &list_tail;
+        list_tail.previous_node = &list_head;
+        return;
+    }
     
-    // Initializing sentinels
-    Double_node* head_sentinel = new Double_node();
-    Double_node* tail_sentinel = new Double_node();
-    
-    // Pointing head and tail to sentinels
-    list_head->next_node = head_sentinel;
-    list_tail->next_node = tail_sentinel;
-    
-    // Initializing head sentinel
-    head_sentinel->next_node = tail_sentinel;
-    head_sentinel->previous_node = nullptr;
-    
-    // Initializing tail sentinel
-    tail_sentinel->previous_node = head_sentinel;
-    tail_sentinel->next_node = nullptr;
+    list_head.next_node = first;
+    first->previous_node = &list_head;
+    list_tail.previous_node = last;
+    last->next_node = &list_tail;
+}
+
+// Constructs a node, and its value from args, in storage obtained from the list's allocator.
+template <typename Type, template <typename> class Allocator>
+template <typename... Args>
+typename Double_linked_list<Type, Allocator>::Double_node *Double_linked_list<Type, Allocator>::create_node( Double_node *pn, Double_node *nn, Args &&...args )
+{
+    return new ( node_allocator.allocate() ) Double_node( pn, nn, std::forward<Args>( args )... );
+}
+
+// Destroys a node and its value and returns its storage to the list's allocator.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::destroy_node( Double_node *node )
+{
+    node->node_value.~Type();
+    node->~Double_node();
+    node_allocator.deallocate( node );
+}
+
+/* Makes list share this list's allocator so that nodes can move between the two.
+ * Throws illegal_argument if the allocator cannot share its storage; Node_pool and
+ * Heap_allocator always can, however many lists their nodes have been spliced across. */
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::share_nodes( Double_linked_list &list )
+{
+    if(!node_allocator.absorb( list.node_allocator )){
+        throw illegal_argument();
+    }
+}
+
+// Links the chain of nodes first..last (already linked among themselves) before position.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::link_before( Double_node *position, Double_node *first, Double_node *last )
+{
+    first->previous_node = position->previous();
+    last->next_node = position;
+    position->previous_node->next_node = first;
+    position->previous_node = last;
+}
+
+// Unlinks the chain of nodes first..last from its list, leaving its inner links untouched.
+template <typename Type, template <typename> class Allocator>
+void Double_linked_list<Type, Allocator>::unlink( Double_node *first, Double_node *last )
+{
+    first->previous_node->next_node = last->next();
+    last->next_node->previous_node = first->previous();
 }
 
 /////////////////////////////////////////////////////////////////////////
 //                               Friends                               //
 /////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-std::ostream &operator<<( std::ostream &out, Double_linked_list<T> const &list ) {
+template <typename T, template <typename> class A>
+std::ostream &operator<<( std::ostream &out, Double_linked_list<T, A> const &list ) {
 	out << "head";
 
-	for ( typename Double_linked_list<T>::Double_node *ptr = list.rend(); ptr != nullptr; ptr = ptr->next() ) {
+	for ( typename Double_linked_list<T, A>::Double_node *ptr = list.rend(); ptr != nullptr; ptr = ptr->next() ) {
 		if ( ptr == list.rend() || ptr == list.end() ) {
 			out << "->S";
 		} else {
@@ -445,7 +838,7 @@ std::ostream &operator<<( std::ostream &out, Double_linked_list<T> const &list )
 
 	out << "->0" << std::endl << "tail";
 
-	for ( typename Double_linked_list<T>::Double_node *ptr = list.end(); ptr != nullptr; ptr = ptr->previous() ) {
+	for ( typename Double_linked_list<T, A>::Double_node *ptr = list.end(); ptr != nullptr; ptr = ptr->previous() ) {
 		if ( ptr == list.rend() || ptr == list.end() ) {
 			out << "->S";
 		} else {
@@ -0,0 +1,213 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef EPOCH_RECLAMATION_H
+#define EPOCH_RECLAMATION_H
+
+#include <atomic>
+
+/* Epoch-based reclamation for lock-free readers.
+ *
+ * A reader pins the current epoch (through a Guard) before it loads any shared pointer,
+ * and unpins it when it no longer uses what it loaded. A writer unlinks an object so that
+ * new readers cannot reach it, retires it (tagged with the current epoch), and advances
+ * the epoch. A retired object is only deleted once every pinned reader has pinned a later
+ * epoch, since those readers started after the object was unlinked.
+ *
+ * Nothing here takes a lock. The retired objects form a stack: retire pushes one with a
+ * compare-and-swap, and collect takes the whole stack with one exchange, deletes what it
+ * can and pushes the rest back as one chain. Nodes are never popped one by one, so the
+ * stack cannot suffer from ABA. */
+class Epoch_manager {
+    public:
+        static const int MAX_READERS = 128;
+
+    private:
+        // Each reader slot takes a cache line of its own so that readers don't share lines.
+        struct alignas( 64 ) Reader_slot {
+            std::atomic<unsigned long> pinned_epoch;    // 0 while the slot is not pinned.
+            std::atomic<bool> in_use;
+        };
+
+        struct Retired {
+            void *object;
+            void (*deleter)( void * );
+            unsigned long epoch;
+            Retired *next_retired;
+        };
+
+        std::atomic<unsigned long> global_epoch;
+        Reader_slot reader_slots[MAX_READERS];
+
+        alignas( 64 ) std::atomic<Retired *> retired;
+
+        void push_retired( Retired *first, Retired *last );
+
+    public:
+        // Keeps the epoch pinned for as long as it exists.
+        class Guard {
+            private:
+                Reader_slot *slot;
+
+                Guard( Reader_slot * );
+
+            public:
+                Guard( Guard && );
+                Guard( Guard const & ) = delete;
+                Guard &operator=( Guard const & ) = delete;
+                ~Guard();
+
+                friend class Epoch_manager;
+        };
+
+        Epoch_manager();
+        ~Epoch_manager();
+
+        Epoch_manager( Epoch_manager const & ) = delete;
+        Epoch_manager &operator=( Epoch_manager const & ) = delete;
+
+        Guard pin();
+        void retire( void *object, void (*deleter)( void * ) );
+        void advance();
+        int collect();
+};
+
+//////////////////////////////////////////////////////////////////////
+//                          Epoch_manager                           //
+//////////////////////////////////////////////////////////////////////
+
+inline Epoch_manager::Epoch_manager():
+global_epoch( 1 ),
+retired( nullptr ) {
+    for ( int i = 0; i < MAX_READERS; ++i ) {
+        reader_slots[i].pinned_epoch.store( 0 );
+        reader_slots[i].in_use.store( false );
+    }
+}
+
+// Deletes every object still retired. No reader may be pinned any more.
+inline Epoch_manager::~Epoch_manager() {
+    Retired *entry = retired.load();
+
+    while ( entry != nullptr ) {
+        Retired *next = entry->next_retired;
+        entry->deleter( entry->object );
+        delete entry;
+        entry = next;
+    }
+}
+
+/* Claims a free reader slot and pins the current epoch in it. The slots are searched
+ * starting from a place that depends on the calling thread, so concurrent readers rarely
+ * compete for the same slot. Throws overflow if MAX_READERS guards are already alive. */
+inline Epoch_manager::Guard Epoch_manager::pin() {
+    static std::atomic<unsigned int> next_start( 0 );
+    thread_local unsigned int start = next_start.fetch_add( 1 );
+
+    for ( int i = 0; i < MAX_READERS; ++i ) {
+        Reader_slot *slot = &reader_slots[( start + i ) % MAX_READERS];
+        bool expected = false;
+
+        if ( !slot->in_use.load( std::memory_order_relaxed ) &&
+             slot->in_use.compare_exchange_strong( expected, true ) ) {
+            // Sequentially consistent, so that the pin is visible before any pointer is loaded.
+            slot->pinned_epoch.store( global_epoch.load() );
+            return Guard( slot );
+        }
+    }
+
+    throw overflow();
+}
+
+// Hands over an object that no new reader can reach. It is deleted by a later collect().
+inline void Epoch_manager::retire( void *object, void (*deleter)( void * ) ) {
+    Retired *entry = new Retired;
+    entry->object = object;
+    entry->deleter = deleter;
+    entry->epoch = global_epoch.load();
+    push_retired( entry, entry );
+}
+
+// Moves to a new epoch. Called after a batch of objects has been retired.
+inline void Epoch_manager::advance() {
+    global_epoch.fetch_add( 1 );
+}
+
+// Deletes the retired objects that no pinned reader can still see. Returns how many were deleted.
+inline int Epoch_manager::collect() {
+    unsigned long oldest_pinned = global_epoch.load();
+
+    for ( int i = 0; i < MAX_READERS; ++i ) {
+        unsigned long epoch = reader_slots[i].pinned_epoch.load();
+
+        if ( epoch != 0 && epoch < oldest_pinned ) {
+            oldest_pinned = epoch;
+        }
+    }
+
+    // Objects retired from now on are not seen here, and are tagged with an epoch no older
+    // than oldest_pinned anyway. Concurrent calls each take a different part of the stack.
+    Retired *entry = retired.exchange( nullptr, std::memory_order_acquire );
+    Retired *kept_first = nullptr;
+    Retired *kept_last = nullptr;
+    int deleted = 0;
+
+    while ( entry != nullptr ) {
+        Retired *next = entry->next_retired;
+
+        if ( entry->epoch < oldest_pinned ) {
+            entry->deleter( entry->object );
+            delete entry;
+            ++deleted;
+        } else {
+            entry->next_retired = kept_first;
+            kept_first = entry;
+
+            if ( kept_last == nullptr ) {
+                kept_last = entry;
+            }
+        }
+
+        entry = next;
+    }
+
+    if ( kept_first != nullptr ) {
+        push_retired( kept_first, kept_last );
+    }
+
+    return deleted;
+}
+
+// Pushes the chain first..last (linked through next_retired) onto the retired stack.
+inline void Epoch_manager::push_retired( Retired *first, Retired *last ) {
+    Retired *top = retired.load( std::memory_order_relaxed );
+
+    do {
+        last->next_retired = top;
+    } while ( !retired.compare_exchange_weak( top, first, std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                       Epoch_manager::Guard                       //
+//////////////////////////////////////////////////////////////////////
+
+inline Epoch_manager::Guard::Guard( Reader_slot *reader_slot ):
+slot( reader_slot ) {
+    // does nothing
+}
+
+inline Epoch_manager::Guard::Guard( Guard &&guard ):
+slot( guard.slot ) {
+    guard.slot = nullptr;
+}
+
+// Unpins the epoch and frees the slot.
+inline Epoch_manager::Guard::~Guard() {
+    if ( slot != nullptr ) {
+        slot->pinned_epoch.store( 0 );
+        slot->in_use.store( false, std::memory_order_release );
+    }
+}
+
+#endif
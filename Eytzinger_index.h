@@ -0,0 +1,170 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef EYTZINGER_INDEX_H
+#define EYTZINGER_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* Immutable search index over a sorted sequence, stored in Eytzinger (BFS) order: the
+ * root is at position 1 and the children of position k are at 2k and 2k + 1.
+ *
+ * The top levels of the implicit tree share a few cache lines, and the descendants of a
+ * node a few levels down are contiguous, so they can be prefetched while the current
+ * levels are compared. The search loop has no data-dependent branch.
+ * The values must be sorted by the index's comparison object, which a stateful Compare
+ * receives through the constructor or assign. */
+template <typename Type, typename Compare = std::less<Type>>
+class Eytzinger_index {
+    private:
+        std::vector<Type> layout;       // Position 0 is unused.
+        int index_size;
+        Compare compare;
+
+        // The descendants of position k that are log2( PREFETCH_STRIDE ) levels down start
+        // at PREFETCH_STRIDE*k and take up about one 64-byte cache line.
+        static const int PREFETCH_STRIDE = ( sizeof( Type ) > 32 ) ? 1 :
+                                           ( sizeof( Type ) > 16 ) ? 2 :
+                                           ( sizeof( Type ) > 8 ) ? 4 :
+                                           ( sizeof( Type ) > 4 ) ? 8 : 16;
+
+        template <typename Input_iterator>
+        void fill( Input_iterator &current, int k );
+        int lower_bound_position( Type const & ) const;
+
+    public:
+        Eytzinger_index();
+        explicit Eytzinger_index( Compare const & );
+
+        template <typename Input_iterator>
+        void assign( Input_iterator first, int n );
+        template <typename Input_iterator>
+        void assign( Input_iterator first, int n, Compare const & );
+
+        int size() const;
+        bool empty() const;
+
+        Type const *find( Type const & ) const;
+        Type const *lower_bound( Type const & ) const;
+        bool member( Type const & ) const;
+};
+
+//////////////////////////////////////////////////////////////////////
+//                     Public Member Functions                      //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type, typename Compare>
+Eytzinger_index<Type, Compare>::Eytzinger_index():
+layout( 1 ),
+index_size( 0 ),
+compare() {
+    // does nothing
+}
+
+template <typename Type, typename Compare>
+Eytzinger_index<Type, Compare>::Eytzinger_index( Compare const &comparator ):
+layout( 1 ),
+index_size( 0 ),
+compare( comparator ) {
+    // does nothing
+}
+
+/* Replaces the contents of the index with the n sorted values starting at first. Only the
+ * prefix ++ and * operators of the iterator are used. The storage of a previous layout is
+ * reused, so an index can be rebuilt after every batch of writes. */
+template <typename Type, typename Compare>
+template <typename Input_iterator>
+void Eytzinger_index<Type, Compare>::assign( Input_iterator first, int n ) {
+    layout.resize( n + 1 );
+    index_size = n;
+    fill( first, 1 );
+}
+
+// The same, for values sorted by comparator, which the index then searches with.
+template <typename Type, typename Compare>
+template <typename Input_iterator>
+void Eytzinger_index<Type, Compare>::assign( Input_iterator first, int n, Compare const &comparator ) {
+    compare = comparator;
+    assign( first, n );
+}
+
+template <typename Type, typename Compare>
+int Eytzinger_index<Type, Compare>::size() const {
+    return index_size;
+}
+
+template <typename Type, typename Compare>
+bool Eytzinger_index<Type, Compare>::empty() const {
+    return ( index_size == 0 );
+}
+
+// Returns a pointer to the value equal to obj, or nullptr if there is none.
+template <typename Type, typename Compare>
+Type const *Eytzinger_index<Type, Compare>::find( Type const &obj ) const {
+    int k = lower_bound_position( obj );
+    return ( k != 0 && !compare( obj, layout[k] ) ) ? &layout[k] : nullptr;
+}
+
+// Returns a pointer to the first value not lower than obj, or nullptr if there is none.
+template <typename Type, typename Compare>
+Type const *Eytzinger_index<Type, Compare>::lower_bound( Type const &obj ) const {
+    int k = lower_bound_position( obj );
+    return ( k != 0 ) ? &layout[k] : nullptr;
+}
+
+template <typename Type, typename Compare>
+bool Eytzinger_index<Type, Compare>::member( Type const &obj ) const {
+    return ( find( obj ) != nullptr );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                     Private Member Functions                     //
+//////////////////////////////////////////////////////////////////////
+
+// Writes the values in order into the sub-tree rooted at position k (an in-order traversal).
+template <typename Type, typename Compare>
+template <typename Input_iterator>
+void Eytzinger_index<Type, Compare>::fill( Input_iterator &current, int k ) {
+    if ( k <= index_size ) {
+        fill( current, 2*k );
+        layout[k] = *current;
+        ++current;
+        fill( current, 2*k + 1 );
+    }
+}
+
+/* Returns the position of the first value not lower than obj, or 0 if there is none.
+ * The descent goes right whenever the value is lower than obj, so the answer is the last
+ * position where it went left: the bits of k record the turns, and the trailing 1s (right
+ * turns) after that last left turn are shifted out at the end. */
+template <typename Type, typename Compare>
+int Eytzinger_index<Type, Compare>::lower_bound_position( Type const &obj ) const {
+    Type const *base = layout.data();
+    unsigned int k = 1;
+
+    while ( k <= static_cast<unsigned int>( index_size ) ) {
+#if defined( __GNUC__ )
+        // Address arithmetic on integers, since the descendants may lie past the end.
+        __builtin_prefetch( reinterpret_cast<void const *>(
+            reinterpret_cast<std::uintptr_t>( base ) + sizeof( Type )*PREFETCH_STRIDE*k ) );
+#endif
+        k = 2*k + static_cast<unsigned int>( compare( base[k], obj ) );
+    }
+
+    // Shifting out the trailing 1s and the 0 of the last left turn.
+#if defined( __GNUC__ )
+    k >>= __builtin_ffs( ~k );
+#else
+    while ( k & 1u ) {
+        k >>= 1;
+    }
+    k >>= 1;
+#endif
+
+    return static_cast<int>( k );
+}
+
+#endif
@@ -0,0 +1,491 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+
+/* Intrusive doubly linked list: the links live in the elements themselves, in an
+ * Intrusive_hook member named by the Hook template argument, e.g.
+ *
+ *     struct Task {
+ *         int id;
+ *         Intrusive_hook ready_hook;
+ *     };
+ *
+ *     Intrusive_list<Task, &Task::ready_hook> ready;
+ *
+ * The list never allocates, copies or destroys an element: push_front and push_back link
+ * the caller's object and the pops only unlink it. Any element can be unlinked in O(1)
+ * with erase( &obj.hook ), since its hook knows its neighbours. An element can be in as
+ * many lists as it has hooks, but in only one list per hook, and must be unlinked before
+ * it is destroyed.
+ *
+ * Positions are hooks, walked with previous() and next() like Double_node, and element()
+ * returns the object that holds one. */
+class Intrusive_hook {
+    public:
+        Intrusive_hook();
+        Intrusive_hook( Intrusive_hook const & );               // Copies of an element start unlinked.
+        Intrusive_hook &operator=( Intrusive_hook const & );    // Keeps the current links.
+
+        bool linked() const;
+        Intrusive_hook *previous() const;
+        Intrusive_hook *next() const;
+
+    private:
+        Intrusive_hook *previous_hook;
+        Intrusive_hook *next_hook;
+
+        template <typename T, Intrusive_hook T::*H>
+        friend class Intrusive_list;
+};
+
+template <typename Type, Intrusive_hook Type::*Hook>
+class Intrusive_list {
+	public:
+		Intrusive_list();
+		Intrusive_list( Intrusive_list && );
+		~Intrusive_list();
+
+		// Elements are not owned, so a list cannot be copied.
+		Intrusive_list( Intrusive_list const & ) = delete;
+		Intrusive_list &operator=( Intrusive_list const & ) = delete;
+
+		// Accessors
+
+		int size() const;
+		bool empty() const;
+
+		Type &front() const;
+		Type &back() const;
+
+		Intrusive_hook *begin() const;
+		Intrusive_hook *end() const;
+		Intrusive_hook *rbegin() const;
+		Intrusive_hook *rend() const;
+
+		static Type &element( Intrusive_hook * );
+
+		Intrusive_hook *find( Type const & ) const;
+		int count( Type const & ) const;
+
+		// Mutators
+
+		void swap( Intrusive_list & );
+		Intrusive_list &operator=( Intrusive_list && );
+
+		void push_front( Type & );
+		void push_back( Type & );
+		void insert_before( Intrusive_hook *, Type & );
+
+		void pop_front();
+		void pop_back();
+
+		int erase( Type const & );
+		Intrusive_hook *erase( Intrusive_hook * );
+		void clear();
+
+	private:
+		mutable Intrusive_hook list_head;    // Mutable because the const accessors hand the
+		mutable Intrusive_hook list_tail;    // sentinels out as positions.
+		int list_size;
+
+		// Offset of the hook in Type, measured on the first element linked (-1 until then).
+		static std::atomic<std::ptrdiff_t> hook_offset;
+
+		static Intrusive_hook *hook( Type & );
+		void link_chain( Intrusive_hook *, Intrusive_hook * );
+		static void unlink( Intrusive_hook * );
+
+	// Friends
+
+	template <typename T, Intrusive_hook T::*H>
+	friend std::ostream &operator<<( std::ostream &, Intrusive_list<T, H> const & );
+};
+
+/////////////////////////////////////////////////////////////////////////
+//                            Intrusive_hook                           //
+/////////////////////////////////////////////////////////////////////////
+
+inline Intrusive_hook::Intrusive_hook():
+previous_hook( nullptr ),
+next_hook( nullptr )
+{
+    // does nothing
+}
+
+inline Intrusive_hook::Intrusive_hook( Intrusive_hook const & ):
+previous_hook( nullptr ),
+next_hook( nullptr )
+{
+    // does nothing
+}
+
+inline Intrusive_hook &Intrusive_hook::operator=( Intrusive_hook const & )
+{
+    return *this;
+}
+
+// Returns true if the element holding the hook is in a list.
+inline bool Intrusive_hook::linked() const
+{
+    return ( next_hook != nullptr );
+}
+
+inline Intrusive_hook *Intrusive_hook::previous() const
+{
+    return previous_hook;
+}
+
+inline Intrusive_hook *Intrusive_hook::next() const
+{
+    return next_hook;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                      Public member functions                        //
+/////////////////////////////////////////////////////////////////////////
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_list<Type, Hook>::Intrusive_list():
+list_head(),
+list_tail(),
+list_size( 0 )
+{
+    link_chain( nullptr, nullptr );
+}
+
+// The elements of list are relinked to this list's sentinels in O(1); list is left empty.
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_list<Type, Hook>::Intrusive_list( Intrusive_list &&list ):
+list_head(),
+list_tail(),
+list_size( 0 )
+{
+    link_chain( nullptr, nullptr );
+    swap( list );
+}
+
+// The elements are unlinked, not destroyed.
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_list<Type, Hook>::~Intrusive_list()
+{
+    clear();
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+int Intrusive_list<Type, Hook>::size() const
+{
+    return list_size;
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+bool Intrusive_list<Type, Hook>::empty() const
+{
+    return ( list_size == 0 );
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Type &Intrusive_list<Type, Hook>::front() const
+{
+    if(empty()){
+        throw underflow();
+    }
+
+    return element( list_head.next() );
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Type &Intrusive_list<Type, Hook>::back() const
+{
+    if(empty()){
+        throw underflow();
+    }
+
+    return element( list_tail.previous() );
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::begin() const
+{
+    return list_head.next();
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::end() const
+{
+    return &list_tail;
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::rbegin() const
+{
+    return list_tail.previous();
+}
+
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::rend() const
+{
+    return &list_head;
+}
+
+/* Returns the element that holds the hook, which must not be a sentinel. The hook was
+ * linked through hook(), so the offset of the hook in Type is already known. */
+template <typename Type, Intrusive_hook Type::*Hook>
+Type &Intrusive_list<Type, Hook>::element( Intrusive_hook *position )
+{
+    std::ptrdiff_t offset = hook_offset.load( std::memory_order_relaxed );
+
+    return *reinterpret_cast<Type *>( reinterpret_cast<char *>( position ) - offset );
+}
+
+// Returns the hook of the first element equal to obj, or end().
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::find( Type const &obj ) const
+{
+    for(Intrusive_hook *current_hook = begin(); current_hook != end(); current_hook = current_hook->next())
+    {
+        if(element( current_hook ) == obj)
+        {
+            return current_hook;
+        }
+    }
+
+    return end();
+}
+
+// Returns the number of elements equal to obj.
+template <typename Type, Intrusive_hook Type::*Hook>
+int Intrusive_list<Type, Hook>::count( Type const &obj ) const
+{
+    int total_matches = 0;
+
+    for(Intrusive_hook *current_hook = begin(); current_hook != end(); current_hook = current_hook->next())
+    {
+        if(element( current_hook ) == obj)
+        {
+            total_matches++;
+        }
+    }
+
+    return total_matches;
+}
+
+// The sentinels stay with their lists, so the two chains of elements are relinked to them in O(1).
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::swap( Intrusive_list &list )
+{
+    Intrusive_hook *first = empty() ? nullptr : begin();
+    Intrusive_hook *last = empty() ? nullptr : rbegin();
+    Intrusive_hook *list_first = list.empty() ? nullptr : list.begin();
+    Intrusive_hook *list_last = list.empty() ? nullptr : list.rbegin();
+
+    link_chain( list_first, list_last );
+    list.link_chain( first, last );
+
+    std::swap( list_size, list.list_size );
+}
+
+// The elements of this list are unlinked and those of rhs are moved in.
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_list<Type, Hook> &Intrusive_list<Type, Hook>::operator=( Intrusive_list &&rhs )
+{
+    clear();
+    swap( rhs );
+
+    return *this;
+}
+
+// Links obj at the front. Throws illegal_argument if its hook is already in a list.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::push_front( Type &obj )
+{
+    insert_before( begin(), obj );
+}
+
+// Links obj at the back. Throws illegal_argument if its hook is already in a list.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::push_back( Type &obj )
+{
+    insert_before( end(), obj );
+}
+
+// Links obj before position (a hook in this list, or end()). Throws illegal_argument if its hook is already in a list.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::insert_before( Intrusive_hook *position, Type &obj )
+{
+    Intrusive_hook *new_hook = hook( obj );
+
+    if(new_hook->linked()){
+        throw illegal_argument();
+    }
+
+    new_hook->previous_hook = position->previous();
+    new_hook->next_hook = position;
+    position->previous_hook->next_hook = new_hook;
+    position->previous_hook = new_hook;
+
+    list_size++;
+}
+
+// Unlinks the first element. Throws underflow if the list is empty.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::pop_front()
+{
+    if(empty()){
+        throw underflow();
+    }
+
+    unlink( begin() );
+    list_size--;
+}
+
+// Unlinks the last element. Throws underflow if the list is empty.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::pop_back()
+{
+    if(empty()){
+        throw underflow();
+    }
+
+    unlink( rbegin() );
+    list_size--;
+}
+
+// Unlinks every element equal to obj and returns how many there were.
+template <typename Type, Intrusive_hook Type::*Hook>
+int Intrusive_list<Type, Hook>::erase( Type const &obj )
+{
+    int deleted_nodes = 0;
+    Intrusive_hook *current_hook = begin();
+
+    while(current_hook != end())
+    {
+        Intrusive_hook *next_hook = current_hook->next();
+
+        if(element( current_hook ) == obj)
+        {
+            unlink( current_hook );
+            deleted_nodes++;
+            list_size--;
+        }
+
+        current_hook = next_hook;
+    }
+
+    return deleted_nodes;
+}
+
+/* Unlinks the element at position, a hook in this list, in O(1) and returns the hook that
+ * followed it. Throws illegal_argument for a sentinel or a hook that is not in a list. */
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::erase( Intrusive_hook *old_hook )
+{
+    if(old_hook->previous() == nullptr || old_hook->next() == nullptr){
+        throw illegal_argument();
+    }
+
+    Intrusive_hook *next_hook = old_hook->next();
+    unlink( old_hook );
+    list_size--;
+
+    return next_hook;
+}
+
+// Unlinks every element. O(n), as every hook is reset.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::clear()
+{
+    Intrusive_hook *current_hook = begin();
+
+    while(current_hook != end())
+    {
+        Intrusive_hook *next_hook = current_hook->next();
+        current_hook->previous_hook = nullptr;
+        current_hook->next_hook = nullptr;
+        current_hook = next_hook;
+    }
+
+    link_chain( nullptr, nullptr );
+    list_size = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                      Private member functions                       //
+/////////////////////////////////////////////////////////////////////////
+
+template <typename Type, Intrusive_hook Type::*Hook>
+std::atomic<std::ptrdiff_t> Intrusive_list<Type, Hook>::hook_offset( -1 );
+
+/* Returns the hook of obj. The first call records the offset of the hook in Type, which
+ * element() needs; it is the same for every element, so racing calls store the same value,
+ * and later calls only read it, so lists used by different threads don't share a written line. */
+template <typename Type, Intrusive_hook Type::*Hook>
+Intrusive_hook *Intrusive_list<Type, Hook>::hook( Type &obj )
+{
+    Intrusive_hook *obj_hook = &( obj.*Hook );
+
+    if ( hook_offset.load( std::memory_order_relaxed ) < 0 )
+    {
+        hook_offset.store( reinterpret_cast<char *>( obj_hook ) - reinterpret_cast<char *>( &obj ), std::memory_order_relaxed );
+    }
+
+    return obj_hook;
+}
+
+// Links the chain of hooks first..last between the sentinels, or leaves the list without elements if first is nullptr.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::link_chain( Intrusive_hook *first, Intrusive_hook *last )
+{
+    if(first == nullptr){
+        list_head.next_hook = &list_tail;
+        list_tail.previous_hook = &list_head;
+        return;
+    }
+
+    list_head.next_hook = first;
+    first->previous_hook = &list_head;
+    list_tail.previous_hook = last;
+    last->next_hook = &list_tail;
+}
+
+// Unlinks a hook from its neighbours and marks it as not linked.
+template <typename Type, Intrusive_hook Type::*Hook>
+void Intrusive_list<Type, Hook>::unlink( Intrusive_hook *old_hook )
+{
+    old_hook->previous_hook->next_hook = old_hook->next_hook;
+    old_hook->next_hook->previous_hook = old_hook->previous_hook;
+    old_hook->previous_hook = nullptr;
+    old_hook->next_hook = nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                               Friends                               //
+/////////////////////////////////////////////////////////////////////////
+
+template <typename T, Intrusive_hook T::*H>
+std::ostream &operator<<( std::ostream &out, Intrusive_list<T, H> const &list ) {
+	out << "head->S";
+
+	for ( Intrusive_hook *ptr = list.begin(); ptr != list.end(); ptr = ptr->next() ) {
+		out << "->" << list.element( ptr );
+	}
+
+	out << "->S->0" << std::endl << "tail->S";
+
+	for ( Intrusive_hook *ptr = list.rbegin(); ptr != list.rend(); ptr = ptr->previous() ) {
+		out << "->" << list.element( ptr );
+	}
+
+	out << "->S->0";
+
+	return out;
+}
+
+#endif
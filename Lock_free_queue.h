@@ -0,0 +1,187 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include "Epoch_reclamation.h"
+
+/* Multi-producer multi-consumer FIFO queue (Michael and Scott, "Simple, fast, and practical
+ * non-blocking and blocking concurrent queue algorithms").
+ *
+ * It is a singly linked list that always starts with a dummy node: push_back links a node
+ * after the last one and then swings the tail, pop_front swings the head to the first real
+ * node, which becomes the new dummy. Every step is a single compare-and-swap, and a thread
+ * that finds the tail lagging behind helps to move it, so no thread ever waits for another.
+ *
+ * A node that leaves the queue may still be read by threads that loaded it earlier, so it is
+ * retired to an Epoch_manager instead of being deleted, and every operation pins the epoch.
+ * Values are copied out of the queue (the losers of a race may be reading them). */
+template <typename Type>
+class Lock_free_queue {
+    private:
+        // Retired nodes are collected after this many pops.
+        static const unsigned int COLLECT_INTERVAL = 64;
+
+        class Node {
+            public:
+                Type node_value;
+                std::atomic<Node *> next_node;
+
+                Node( Type const & = Type() );
+        };
+
+        // Kept on separate cache lines so that producers and consumers don't share one.
+        alignas( 64 ) std::atomic<Node *> queue_head;
+        alignas( 64 ) std::atomic<Node *> queue_tail;
+        alignas( 64 ) std::atomic<unsigned int> pop_count;
+
+        Epoch_manager epochs;
+
+        static void delete_node( void * );
+
+    public:
+        Lock_free_queue();
+        ~Lock_free_queue();
+
+        Lock_free_queue( Lock_free_queue const & ) = delete;
+        Lock_free_queue &operator=( Lock_free_queue const & ) = delete;
+
+        bool empty();
+
+        void push_back( Type const & );
+        bool pop_front( Type & );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                   Queue Public Member Functions                  //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Lock_free_queue<Type>::Lock_free_queue():
+pop_count( 0 ) {
+    Node *dummy = new Node();
+    queue_head.store( dummy );
+    queue_tail.store( dummy );
+}
+
+// Deletes the nodes left in the queue. No other thread may be using it.
+template <typename Type>
+Lock_free_queue<Type>::~Lock_free_queue() {
+    Node *node = queue_head.load();
+
+    while ( node != nullptr ) {
+        Node *next = node->next_node.load();
+        delete node;
+        node = next;
+    }
+}
+
+// Only a snapshot: other threads may push or pop right after it is taken.
+template <typename Type>
+bool Lock_free_queue<Type>::empty() {
+    Epoch_manager::Guard guard = epochs.pin();
+    return ( queue_head.load()->next_node.load() == nullptr );
+}
+
+// Appends a copy of value to the queue. Never blocks.
+template <typename Type>
+void Lock_free_queue<Type>::push_back( Type const &value ) {
+    Node *node = new Node( value );
+    Epoch_manager::Guard guard = epochs.pin();
+
+    while ( true ) {
+        Node *tail = queue_tail.load( std::memory_order_acquire );
+        Node *next = tail->next_node.load( std::memory_order_acquire );
+
+        if ( tail != queue_tail.load( std::memory_order_acquire ) ) {
+            continue;
+        }
+
+        if ( next != nullptr ) {
+            // Another push linked its node but has not moved the tail yet: help it.
+            queue_tail.compare_exchange_weak( tail, next, std::memory_order_release, std::memory_order_relaxed );
+            continue;
+        }
+
+        if ( tail->next_node.compare_exchange_weak( next, node, std::memory_order_release, std::memory_order_relaxed ) ) {
+            // Failing is fine: some other thread has already moved the tail past the node.
+            queue_tail.compare_exchange_strong( tail, node, std::memory_order_release, std::memory_order_relaxed );
+            return;
+        }
+    }
+}
+
+/* Removes the first value of the queue and copies it into value. Returns false (and leaves
+ * value unchanged) if the queue was empty. Never blocks: retiring the old dummy node and
+ * collecting retired nodes are lock-free as well. */
+template <typename Type>
+bool Lock_free_queue<Type>::pop_front( Type &value ) {
+    Node *head;
+
+    {
+        Epoch_manager::Guard guard = epochs.pin();
+
+        while ( true ) {
+            head = queue_head.load( std::memory_order_acquire );
+            Node *tail = queue_tail.load( std::memory_order_acquire );
+            Node *next = head->next_node.load( std::memory_order_acquire );
+
+            if ( head != queue_head.load( std::memory_order_acquire ) ) {
+                continue;
+            }
+
+            if ( next == nullptr ) {
+                return false;
+            }
+
+            if ( head == tail ) {
+                // The tail lags behind a node that is already linked.
+                queue_tail.compare_exchange_weak( tail, next, std::memory_order_release, std::memory_order_relaxed );
+                continue;
+            }
+
+            // Read before the head moves: once it does, the node may be popped and retired.
+            Type first = next->node_value;
+
+            if ( queue_head.compare_exchange_weak( head, next, std::memory_order_acq_rel, std::memory_order_relaxed ) ) {
+                value = first;
+                break;
+            }
+        }
+    }
+
+    epochs.retire( head, delete_node );
+
+    // The guard is released first, so that this thread does not hold back its own collection.
+    if ( pop_count.fetch_add( 1, std::memory_order_relaxed ) % COLLECT_INTERVAL == COLLECT_INTERVAL - 1 ) {
+        epochs.advance();
+        epochs.collect();
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Queue Private Member Functions                 //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+void Lock_free_queue<Type>::delete_node( void *node ) {
+    delete static_cast<Node *>( node );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                               Node                               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Lock_free_queue<Type>::Node::Node( Type const &value ):
+node_value( value ),
+next_node( nullptr ) {
+    // does nothing
+}
+
+#endif
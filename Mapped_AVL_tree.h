@@ -0,0 +1,897 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef MAPPED_AVL_TREE_H
+#define MAPPED_AVL_TREE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* AVL tree stored in a memory-mapped file, so that it survives restarts.
+ *
+ * Nodes are linked by their byte offsets in the file instead of pointers (0 is the null
+ * link, as the header lives there), so the links stay valid wherever the file is mapped
+ * and when it grows. Opening a tree maps the file and reads its header, which is O(1):
+ * the pages of the nodes are only faulted in when a search reaches them.
+ *
+ * Every insert or erase is a transaction with a redo log kept next to the file (path.wal).
+ * The nodes it changes are staged in memory, appended to the log with a checksum and
+ * flushed with fdatasync, and only then copied into the mapping. If the process crashes,
+ * the next open replays the complete records of the log and drops an incomplete last one,
+ * so the file always holds the tree as of some committed transaction. The log is cleared
+ * (only once the file has been flushed) when it passes CHECKPOINT_BYTES and when the tree
+ * is destroyed, which bounds the work of a reopen.
+ *
+ * Values are stored as raw bytes, so Type must be trivially copyable, and the file can
+ * only be read back by a build with the same Type layout. References returned by the
+ * iterators are only valid until the next insert or erase, which may remap the file. */
+template <typename Type>
+class Mapped_AVL_tree {
+    static_assert( std::is_trivially_copyable<Type>::value, "Mapped_AVL_tree stores raw bytes and needs a trivially copyable type" );
+
+    public:
+        class Iterator;
+
+    private:
+        typedef std::uint64_t Offset;
+
+        static const std::uint64_t FILE_MAGIC = 0x4d41564c54524545ULL;     // "MAVLTREE"
+        static const std::uint64_t RECORD_MAGIC = 0x4d41564c57414c52ULL;   // "MAVLWALR"
+        static const std::uint64_t CHECKPOINT_BYTES = 1 << 20;
+        static const std::uint64_t INITIAL_BYTES = 1 << 16;
+        static const int MAX_HEIGHT = 64;
+
+        class Node {
+            public:
+                Type node_value;
+                Offset left_tree;
+                Offset right_tree;
+                Offset previous_node;      // Threaded in order, like AVL_tree.
+                Offset next_node;
+                int tree_height;
+        };
+
+        struct Header {
+            std::uint64_t magic;
+            std::uint64_t node_bytes;      // sizeof( Node ) of the build that created the file.
+            Offset root_node;
+            Offset front_node;
+            Offset back_node;
+            Offset free_list;              // Erased nodes, chained through left_tree.
+            std::uint64_t tree_size;
+            std::uint64_t node_count;      // Nodes ever carved out of the file.
+        };
+
+        // Nodes start on a 64-byte boundary after the header.
+        static const Offset FIRST_NODE = ( sizeof( Header ) + 63 )/64*64;
+
+        // A node changed by the current transaction, not yet written to the mapping.
+        struct Staged_node {
+            Offset offset;
+            Node node;
+        };
+
+        int file_fd;
+        int wal_fd;
+        unsigned char *mapping;
+        std::uint64_t mapped_bytes;
+        std::uint64_t wal_bytes;
+
+        Header header;                     // The header of the current transaction.
+        std::vector<Staged_node> staged;
+
+        Header const &file_header() const;
+        Node const &mapped_node( Offset ) const;
+
+        // Transactions
+        void begin_transaction();
+        Node load( Offset ) const;
+        void store( Offset, Node const & );
+        void commit();
+        void replay();
+        void apply( Offset, void const *, std::uint64_t );
+        void grow( std::uint64_t );
+        static std::uint64_t checksum( unsigned char const *, std::uint64_t );
+        static bool sync_directory( char const * );
+
+        // Tree operations on staged nodes
+        Offset allocate_node();
+        int height( Offset ) const;
+        void update_height( Offset );
+        Offset rotate_left( Offset );
+        Offset rotate_right( Offset );
+        Offset balance( Offset );
+        void rebalance( Offset path[], int depth );
+
+    public:
+        explicit Mapped_AVL_tree( char const *path );
+        ~Mapped_AVL_tree();
+
+        Mapped_AVL_tree( Mapped_AVL_tree const & ) = delete;
+        Mapped_AVL_tree &operator=( Mapped_AVL_tree const & ) = delete;
+
+        bool empty() const;
+        int size() const;
+        int height() const;
+
+        Type const &front() const;
+        Type const &back() const;
+        bool member( Type const & ) const;
+
+        Iterator begin() const;
+        Iterator end() const;
+        Iterator find( Type const & ) const;
+
+        void clear();
+        bool insert( Type const & );
+        bool erase( Type const & );
+        void checkpoint();
+
+        class Iterator {
+            private:
+                Mapped_AVL_tree const *containing_tree;
+                Offset current_node;
+
+                Iterator( Mapped_AVL_tree const *, Offset );
+
+            public:
+                Type const &operator*() const;
+                Type const *operator->() const;
+                Iterator &operator++();
+                bool operator==( Iterator const &rhs ) const;
+                bool operator!=( Iterator const &rhs ) const;
+
+                friend class Mapped_AVL_tree;
+        };
+};
+
+//////////////////////////////////////////////////////////////////////
+//                Mapped Tree Public Member Functions               //
+//////////////////////////////////////////////////////////////////////
+
+/* Opens the tree stored at path, creating an empty one if the file is new (or was never
+ * initialized), and replays the redo log left by a crash. The directory is synced after the
+ * files are opened, so that files just created survive a crash too. Throws illegal_argument
+ * if the files cannot be opened, synced or mapped, or if the file holds something else. */
+template <typename Type>
+Mapped_AVL_tree<Type>::Mapped_AVL_tree( char const *path ):
+file_fd( -1 ),
+wal_fd( -1 ),
+mapping( nullptr ),
+mapped_bytes( 0 ),
+wal_bytes( 0 ) {
+    std::string wal_path = std::string( path ) + ".wal";
+
+    file_fd = open( path, O_RDWR | O_CREAT, 0644 );
+    wal_fd = open( wal_path.c_str(), O_RDWR | O_CREAT, 0644 );
+    struct stat file_stat;
+
+    if ( file_fd == -1 || wal_fd == -1 || fstat( file_fd, &file_stat ) != 0 || !sync_directory( path ) ) {
+        if ( file_fd != -1 ) close( file_fd );
+        if ( wal_fd != -1 ) close( wal_fd );
+        throw illegal_argument();
+    }
+
+    mapped_bytes = static_cast<std::uint64_t>( file_stat.st_size );
+
+    if ( mapped_bytes < INITIAL_BYTES ) {
+        mapped_bytes = INITIAL_BYTES;
+
+        if ( ftruncate( file_fd, static_cast<off_t>( mapped_bytes ) ) != 0 ) {
+            close( file_fd );
+            close( wal_fd );
+            throw illegal_argument();
+        }
+    }
+
+    void *address = mmap( nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_fd, 0 );
+
+    if ( address == MAP_FAILED ) {
+        close( file_fd );
+        close( wal_fd );
+        throw illegal_argument();
+    }
+
+    mapping = static_cast<unsigned char *>( address );
+    bool replayed = true;
+
+    try {
+        replay();
+    } catch ( overflow const & ) {
+        replayed = false;
+    }
+
+    // A file whose header was never written (all zeros) is a new tree.
+    if ( replayed && file_header().magic == 0 ) {
+        Header fresh = {FILE_MAGIC, sizeof( Node ), 0, 0, 0, 0, 0, 0};
+        apply( 0, &fresh, sizeof( Header ) );
+        replayed = ( msync( mapping, FIRST_NODE, MS_SYNC ) == 0 && fdatasync( file_fd ) == 0 );
+    }
+
+    if ( !replayed || file_header().magic != FILE_MAGIC || file_header().node_bytes != sizeof( Node ) ) {
+        munmap( mapping, mapped_bytes );
+        close( file_fd );
+        close( wal_fd );
+        throw illegal_argument();
+    }
+
+    header = file_header();
+}
+
+// Checkpoints so that the next open has nothing to replay.
+template <typename Type>
+Mapped_AVL_tree<Type>::~Mapped_AVL_tree() {
+    checkpoint();
+    munmap( mapping, mapped_bytes );
+    close( file_fd );
+    close( wal_fd );
+}
+
+template <typename Type>
+bool Mapped_AVL_tree<Type>::empty() const {
+    return ( file_header().tree_size == 0 );
+}
+
+template <typename Type>
+int Mapped_AVL_tree<Type>::size() const {
+    return static_cast<int>( file_header().tree_size );
+}
+
+template <typename Type>
+int Mapped_AVL_tree<Type>::height() const {
+    Offset root = file_header().root_node;
+    return ( root == 0 ) ? -1 : mapped_node( root ).tree_height;
+}
+
+template <typename Type>
+Type const &Mapped_AVL_tree<Type>::front() const {
+    if ( empty() ) {
+        throw underflow();
+    }
+
+    return mapped_node( file_header().front_node ).node_value;
+}
+
+template <typename Type>
+Type const &Mapped_AVL_tree<Type>::back() const {
+    if ( empty() ) {
+        throw underflow();
+    }
+
+    return mapped_node( file_header().back_node ).node_value;
+}
+
+template <typename Type>
+bool Mapped_AVL_tree<Type>::member( Type const &obj ) const {
+    return ( find( obj ) != end() );
+}
+
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Iterator Mapped_AVL_tree<Type>::begin() const {
+    return Iterator( this, file_header().front_node );
+}
+
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Iterator Mapped_AVL_tree<Type>::end() const {
+    return Iterator( this, 0 );
+}
+
+// Only the nodes on the search path are read, so only their pages are faulted in.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Iterator Mapped_AVL_tree<Type>::find( Type const &obj ) const {
+    Offset current_node = file_header().root_node;
+
+    while ( current_node != 0 ) {
+        Node const &node = mapped_node( current_node );
+
+        if ( obj < node.node_value ) {
+            current_node = node.left_tree;
+        } else if ( node.node_value < obj ) {
+            current_node = node.right_tree;
+        } else {
+            break;
+        }
+    }
+
+    return Iterator( this, current_node );
+}
+
+// Empties the tree in one transaction. The file keeps its size and the space is reused.
+template <typename Type>
+void Mapped_AVL_tree<Type>::clear() {
+    begin_transaction();
+    header.root_node = 0;
+    header.front_node = 0;
+    header.back_node = 0;
+    header.free_list = 0;
+    header.tree_size = 0;
+    header.node_count = 0;
+    commit();
+}
+
+// Inserts obj durably. If the value already exists it returns false and nothing is written.
+template <typename Type>
+bool Mapped_AVL_tree<Type>::insert( Type const &obj ) {
+    begin_transaction();
+
+    Offset path[MAX_HEIGHT];
+    int depth = 0;
+    Offset current_node = header.root_node;
+    Offset previous = 0;
+    Offset next = 0;
+
+    while ( current_node != 0 ) {
+        Node node = load( current_node );
+        path[depth++] = current_node;
+
+        if ( obj < node.node_value ) {
+            next = current_node;
+            current_node = node.left_tree;
+        } else if ( node.node_value < obj ) {
+            previous = current_node;
+            current_node = node.right_tree;
+        } else {
+            staged.clear();
+            return false;
+        }
+    }
+
+    Offset new_offset = allocate_node();
+    Node new_node;
+    new_node.node_value = obj;
+    new_node.left_tree = 0;
+    new_node.right_tree = 0;
+    new_node.previous_node = previous;
+    new_node.next_node = next;
+    new_node.tree_height = 0;
+    store( new_offset, new_node );
+
+    // Threading the node between its neighbours.
+    if ( previous == 0 ) {
+        header.front_node = new_offset;
+    } else {
+        Node node = load( previous );
+        node.next_node = new_offset;
+        store( previous, node );
+    }
+
+    if ( next == 0 ) {
+        header.back_node = new_offset;
+    } else {
+        Node node = load( next );
+        node.previous_node = new_offset;
+        store( next, node );
+    }
+
+    // Linking it to its parent.
+    if ( depth == 0 ) {
+        header.root_node = new_offset;
+    } else {
+        Node parent = load( path[depth - 1] );
+
+        if ( obj < parent.node_value ) {
+            parent.left_tree = new_offset;
+        } else {
+            parent.right_tree = new_offset;
+        }
+
+        store( path[depth - 1], parent );
+    }
+
+    rebalance( path, depth );
+    ++header.tree_size;
+    commit();
+
+    return true;
+}
+
+/* Erases obj durably. If it is not in the tree it returns false and nothing is written.
+ * A node with two children takes the value of its successor, whose node is removed. */
+template <typename Type>
+bool Mapped_AVL_tree<Type>::erase( Type const &obj ) {
+    begin_transaction();
+
+    Offset path[MAX_HEIGHT];
+    int depth = 0;
+    Offset current_node = header.root_node;
+
+    while ( current_node != 0 ) {
+        Node node = load( current_node );
+
+        if ( obj < node.node_value ) {
+            path[depth++] = current_node;
+            current_node = node.left_tree;
+        } else if ( node.node_value < obj ) {
+            path[depth++] = current_node;
+            current_node = node.right_tree;
+        } else {
+            break;
+        }
+    }
+
+    if ( current_node == 0 ) {
+        staged.clear();
+        return false;
+    }
+
+    Node target = load( current_node );
+
+    if ( target.left_tree != 0 && target.right_tree != 0 ) {
+        // The successor is the front of the right sub-tree and has no left child.
+        path[depth++] = current_node;
+        Offset successor = target.right_tree;
+
+        while ( load( successor ).left_tree != 0 ) {
+            path[depth++] = successor;
+            successor = load( successor ).left_tree;
+        }
+
+        target.node_value = load( successor ).node_value;
+        store( current_node, target );
+
+        current_node = successor;
+        target = load( successor );
+    }
+
+    // The node to remove has at most one child, which takes its place.
+    Offset child = ( target.left_tree != 0 ) ? target.left_tree : target.right_tree;
+
+    if ( depth == 0 ) {
+        header.root_node = child;
+    } else {
+        Node parent = load( path[depth - 1] );
+
+        if ( parent.left_tree == current_node ) {
+            parent.left_tree = child;
+        } else {
+            parent.right_tree = child;
+        }
+
+        store( path[depth - 1], parent );
+    }
+
+    // Unthreading it.
+    if ( target.previous_node == 0 ) {
+        header.front_node = target.next_node;
+    } else {
+        Node node = load( target.previous_node );
+        node.next_node = target.next_node;
+        store( target.previous_node, node );
+    }
+
+    if ( target.next_node == 0 ) {
+        header.back_node = target.previous_node;
+    } else {
+        Node node = load( target.next_node );
+        node.previous_node = target.previous_node;
+        store( target.next_node, node );
+    }
+
+    // Adding it to the free list.
+    target.left_tree = header.free_list;
+    store( current_node, target );
+    header.free_list = current_node;
+
+    rebalance( path, depth );
+    --header.tree_size;
+    commit();
+
+    return true;
+}
+
+/* Flushes the file and clears the redo log, which then has nothing left to replay. The log
+ * is kept whole if the file could not be flushed (its size included, which msync does not
+ * cover), so that the next checkpoint or open tries again. */
+template <typename Type>
+void Mapped_AVL_tree<Type>::checkpoint() {
+    if ( wal_bytes == 0 ) {
+        return;
+    }
+
+    if ( msync( mapping, mapped_bytes, MS_SYNC ) != 0 || fdatasync( file_fd ) != 0 ) {
+        return;
+    }
+
+    if ( ftruncate( wal_fd, 0 ) == 0 ) {
+        fdatasync( wal_fd );
+        wal_bytes = 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//              Mapped Tree Private Member Functions                //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Header const &Mapped_AVL_tree<Type>::file_header() const {
+    return *reinterpret_cast<Header const *>( mapping );
+}
+
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Node const &Mapped_AVL_tree<Type>::mapped_node( Offset offset ) const {
+    return *reinterpret_cast<Node const *>( mapping + offset );
+}
+
+// Starts a transaction from the committed header.
+template <typename Type>
+void Mapped_AVL_tree<Type>::begin_transaction() {
+    header = file_header();
+    staged.clear();
+}
+
+// Returns a node as the current transaction sees it.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Node Mapped_AVL_tree<Type>::load( Offset offset ) const {
+    for ( std::size_t i = staged.size(); i > 0; --i ) {
+        if ( staged[i - 1].offset == offset ) {
+            return staged[i - 1].node;
+        }
+    }
+
+    return mapped_node( offset );
+}
+
+// Stages a node. A transaction only touches O(log n) nodes, so a vector is searched.
+template <typename Type>
+void Mapped_AVL_tree<Type>::store( Offset offset, Node const &node ) {
+    for ( std::size_t i = 0; i < staged.size(); ++i ) {
+        if ( staged[i].offset == offset ) {
+            staged[i].node = node;
+            return;
+        }
+    }
+
+    Staged_node entry;
+    entry.offset = offset;
+    entry.node = node;
+    staged.push_back( entry );
+}
+
+/* Writes the staged nodes and the header as one log record, makes it durable, and only then
+ * copies them into the mapping. A record is:
+ *     RECORD_MAGIC, payload bytes, checksum of the payload,
+ * followed by the payload, a sequence of ( offset, length, bytes ) entries. */
+template <typename Type>
+void Mapped_AVL_tree<Type>::commit() {
+    std::vector<unsigned char> record( 3*sizeof( std::uint64_t ) );
+
+    for ( std::size_t i = 0; i <= staged.size(); ++i ) {
+        std::uint64_t entry[2];
+        void const *bytes;
+
+        if ( i < staged.size() ) {
+            entry[0] = staged[i].offset;
+            entry[1] = sizeof( Node );
+            bytes = &staged[i].node;
+        } else {
+            entry[0] = 0;
+            entry[1] = sizeof( Header );
+            bytes = &header;
+        }
+
+        std::size_t start = record.size();
+        record.resize( start + sizeof( entry ) + entry[1] );
+        std::memcpy( &record[start], entry, sizeof( entry ) );
+        std::memcpy( &record[start + sizeof( entry )], bytes, entry[1] );
+    }
+
+    std::uint64_t prefix[3];
+    prefix[0] = RECORD_MAGIC;
+    prefix[1] = record.size() - sizeof( prefix );
+    prefix[2] = checksum( &record[sizeof( prefix )], prefix[1] );
+    std::memcpy( &record[0], prefix, sizeof( prefix ) );
+
+    if ( pwrite( wal_fd, &record[0], record.size(), static_cast<off_t>( wal_bytes ) ) != static_cast<ssize_t>( record.size() ) ||
+         fdatasync( wal_fd ) != 0 ) {
+        staged.clear();
+        header = file_header();
+        throw overflow();
+    }
+
+    wal_bytes += record.size();
+
+    // The record is durable, so the mapping can be changed.
+    for ( std::size_t i = 0; i < staged.size(); ++i ) {
+        apply( staged[i].offset, &staged[i].node, sizeof( Node ) );
+    }
+
+    apply( 0, &header, sizeof( Header ) );
+    staged.clear();
+
+    if ( wal_bytes > CHECKPOINT_BYTES ) {
+        checkpoint();
+    }
+}
+
+// Redoes every complete record of the log, in order, and then checkpoints.
+template <typename Type>
+void Mapped_AVL_tree<Type>::replay() {
+    struct stat wal_stat;
+
+    if ( fstat( wal_fd, &wal_stat ) != 0 || wal_stat.st_size == 0 ) {
+        return;
+    }
+
+    std::vector<unsigned char> log( static_cast<std::size_t>( wal_stat.st_size ) );
+
+    if ( pread( wal_fd, &log[0], log.size(), 0 ) != static_cast<ssize_t>( log.size() ) ) {
+        log.clear();
+    }
+
+    std::size_t position = 0;
+
+    while ( position + 3*sizeof( std::uint64_t ) <= log.size() ) {
+        std::uint64_t prefix[3];
+        std::memcpy( prefix, &log[position], sizeof( prefix ) );
+        std::size_t payload = position + sizeof( prefix );
+
+        // An incomplete or torn record was never committed, and nothing follows it.
+        if ( prefix[0] != RECORD_MAGIC || prefix[1] > log.size() - payload ||
+             checksum( &log[payload], prefix[1] ) != prefix[2] ) {
+            break;
+        }
+
+        for ( std::size_t entry = payload; entry < payload + prefix[1]; ) {
+            std::uint64_t offset_length[2];
+            std::memcpy( offset_length, &log[entry], sizeof( offset_length ) );
+            apply( offset_length[0], &log[entry + sizeof( offset_length )], offset_length[1] );
+            entry += sizeof( offset_length ) + offset_length[1];
+        }
+
+        position = payload + prefix[1];
+    }
+
+    // A torn tail is cut off, so that the next record is not appended behind it.
+    if ( position < log.size() && ftruncate( wal_fd, static_cast<off_t>( position ) ) != 0 ) {
+        throw overflow();
+    }
+
+    wal_bytes = position;
+    checkpoint();
+}
+
+// Copies bytes into the mapping at offset, growing the file first if it is too short.
+template <typename Type>
+void Mapped_AVL_tree<Type>::apply( Offset offset, void const *bytes, std::uint64_t length ) {
+    if ( offset + length > mapped_bytes ) {
+        grow( offset + length );
+    }
+
+    std::memcpy( mapping + offset, bytes, length );
+}
+
+// Doubles the file until it holds at least minimum bytes and maps it again. Throws overflow if it cannot.
+template <typename Type>
+void Mapped_AVL_tree<Type>::grow( std::uint64_t minimum ) {
+    std::uint64_t new_bytes = mapped_bytes;
+
+    while ( new_bytes < minimum ) {
+        new_bytes *= 2;
+    }
+
+    if ( ftruncate( file_fd, static_cast<off_t>( new_bytes ) ) != 0 ) {
+        throw overflow();
+    }
+
+    // The file is mapped again before the old mapping is dropped, so that a failure leaves
+    // the tree as it was (the file is only longer).
+    void *address = mmap( nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_fd, 0 );
+
+    if ( address == MAP_FAILED ) {
+        throw overflow();
+    }
+
+    munmap( mapping, mapped_bytes );
+    mapping = static_cast<unsigned char *>( address );
+    mapped_bytes = new_bytes;
+}
+
+// 64-bit FNV-1a.
+template <typename Type>
+std::uint64_t Mapped_AVL_tree<Type>::checksum( unsigned char const *bytes, std::uint64_t length ) {
+    std::uint64_t hash = 14695981039346656037ULL;
+
+    for ( std::uint64_t i = 0; i < length; ++i ) {
+        hash = ( hash ^ bytes[i] )*1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Syncs the directory holding path, which makes the files created in it durable.
+template <typename Type>
+bool Mapped_AVL_tree<Type>::sync_directory( char const *path ) {
+    std::string directory( path );
+    std::string::size_type slash = directory.rfind( '/' );
+    directory = ( slash == std::string::npos ) ? "." : ( slash == 0 ) ? "/" : directory.substr( 0, slash );
+
+    int directory_fd = open( directory.c_str(), O_RDONLY | O_DIRECTORY );
+
+    if ( directory_fd == -1 ) {
+        return false;
+    }
+
+    bool synced = ( fsync( directory_fd ) == 0 );
+    close( directory_fd );
+
+    return synced;
+}
+
+// Reuses an erased node, or carves a new one at the end of the file.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Offset Mapped_AVL_tree<Type>::allocate_node() {
+    if ( header.free_list != 0 ) {
+        Offset reused = header.free_list;
+        header.free_list = load( reused ).left_tree;
+        return reused;
+    }
+
+    Offset carved = FIRST_NODE + header.node_count*sizeof( Node );
+    ++header.node_count;
+
+    if ( carved + sizeof( Node ) > mapped_bytes ) {
+        grow( carved + sizeof( Node ) );
+    }
+
+    return carved;
+}
+
+template <typename Type>
+int Mapped_AVL_tree<Type>::height( Offset offset ) const {
+    return ( offset == 0 ) ? -1 : load( offset ).tree_height;
+}
+
+template <typename Type>
+void Mapped_AVL_tree<Type>::update_height( Offset offset ) {
+    Node node = load( offset );
+    int left_height = height( node.left_tree );
+    int right_height = height( node.right_tree );
+    node.tree_height = 1 + ( ( left_height > right_height ) ? left_height : right_height );
+    store( offset, node );
+}
+
+// Replaces the sub-tree at offset by its right child, and returns the child.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Offset Mapped_AVL_tree<Type>::rotate_left( Offset offset ) {
+    Node node = load( offset );
+    Offset raised = node.right_tree;
+    Node raised_node = load( raised );
+
+    node.right_tree = raised_node.left_tree;
+    store( offset, node );
+    update_height( offset );
+
+    raised_node.left_tree = offset;
+    store( raised, raised_node );
+    update_height( raised );
+
+    return raised;
+}
+
+// Replaces the sub-tree at offset by its left child, and returns the child.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Offset Mapped_AVL_tree<Type>::rotate_right( Offset offset ) {
+    Node node = load( offset );
+    Offset raised = node.left_tree;
+    Node raised_node = load( raised );
+
+    node.left_tree = raised_node.right_tree;
+    store( offset, node );
+    update_height( offset );
+
+    raised_node.right_tree = offset;
+    store( raised, raised_node );
+    update_height( raised );
+
+    return raised;
+}
+
+// Updates the height of the sub-tree at offset, rotates it if it is unbalanced, and returns its new root.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Offset Mapped_AVL_tree<Type>::balance( Offset offset ) {
+    update_height( offset );
+    Node node = load( offset );
+    int difference = height( node.left_tree ) - height( node.right_tree );
+
+    if ( difference > 1 ) {
+        Node left = load( node.left_tree );
+
+        if ( height( left.left_tree ) < height( left.right_tree ) ) {
+            node.left_tree = rotate_left( node.left_tree );
+            store( offset, node );
+        }
+
+        return rotate_right( offset );
+    }
+
+    if ( difference < -1 ) {
+        Node right = load( node.right_tree );
+
+        if ( height( right.right_tree ) < height( right.left_tree ) ) {
+            node.right_tree = rotate_right( node.right_tree );
+            store( offset, node );
+        }
+
+        return rotate_left( offset );
+    }
+
+    return offset;
+}
+
+// Balances the nodes path[depth - 1] up to path[0] (the root), relinking each new sub-tree root.
+template <typename Type>
+void Mapped_AVL_tree<Type>::rebalance( Offset path[], int depth ) {
+    while ( depth > 0 ) {
+        Offset old_root = path[--depth];
+        Offset new_root = balance( old_root );
+
+        if ( new_root == old_root ) {
+            continue;
+        }
+
+        if ( depth == 0 ) {
+            header.root_node = new_root;
+        } else {
+            Node parent = load( path[depth - 1] );
+
+            if ( parent.left_tree == old_root ) {
+                parent.left_tree = new_root;
+            } else {
+                parent.right_tree = new_root;
+            }
+
+            store( path[depth - 1], parent );
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                             Iterator                             //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Mapped_AVL_tree<Type>::Iterator::Iterator( Mapped_AVL_tree const *tree, Offset starting_node ):
+containing_tree( tree ),
+current_node( starting_node ) {
+    // does nothing
+}
+
+template <typename Type>
+Type const &Mapped_AVL_tree<Type>::Iterator::operator*() const {
+    return containing_tree->mapped_node( current_node ).node_value;
+}
+
+template <typename Type>
+Type const *Mapped_AVL_tree<Type>::Iterator::operator->() const {
+    return &containing_tree->mapped_node( current_node ).node_value;
+}
+
+// Follows the threaded list. The end stays at the end.
+template <typename Type>
+typename Mapped_AVL_tree<Type>::Iterator &Mapped_AVL_tree<Type>::Iterator::operator++() {
+    if ( current_node != 0 ) {
+        current_node = containing_tree->mapped_node( current_node ).next_node;
+    }
+
+    return *this;
+}
+
+template <typename Type>
+bool Mapped_AVL_tree<Type>::Iterator::operator==( Iterator const &rhs ) const {
+    return ( current_node == rhs.current_node );
+}
+
+template <typename Type>
+bool Mapped_AVL_tree<Type>::Iterator::operator!=( Iterator const &rhs ) const {
+    return ( current_node != rhs.current_node );
+}
+
+#endif
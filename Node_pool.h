@@ -0,0 +1,440 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <new>
+#include "Profiling_hooks.h"
+
+/* Node allocators used by the linked structures in this repository.
+ *
+ * An allocator hands out raw, suitably aligned storage for one node at a time:
+ *     Node_type *allocate();
+ *     void deallocate( Node_type * );
+ *     bool release();                      // Drops every node at once, false if it cannot.
+ *     bool shares( Allocator const & );    // True if nodes may move between the two.
+ *     bool absorb( Allocator & );          // Makes the argument share this allocator's storage.
+ *                                          // Node_pool and Heap_allocator always can.
+ *     void reserve( int );                 // Prepares storage for that many nodes in one block.
+ * The containers construct and destroy the nodes in place. */
+
+// Slab/free-list pool. Nodes are carved out of slabs of about 4 kB and recycled
+// through a free list, so a container in steady state never touches the global
+// heap and consecutive nodes end up next to each other in memory.
+// Copies of a pool share the same slabs, and so do pools merged by absorb(). A pool
+// only allocates its bookkeeping when it is first used, so a default-constructed or
+// moved-from pool costs nothing.
+template <typename Node_type>
+class Node_pool {
+    private:
+        // An unused node is reinterpreted as a link in the free list.
+        struct Free_node {
+            Free_node *next_free;
+        };
+
+        static const int SLAB_BYTES = 4096;
+        static const int NODE_BYTES = ( sizeof( Node_type ) > sizeof( Free_node ) ) ? sizeof( Node_type ) : sizeof( Free_node );
+        static const int NODE_ALIGN = ( alignof( Node_type ) > alignof( Free_node ) ) ? alignof( Node_type ) : alignof( Free_node );
+        static const int STRIDE = ( NODE_BYTES + NODE_ALIGN - 1 )/NODE_ALIGN*NODE_ALIGN;
+
+    public:
+        static const int NODES_PER_SLAB = ( SLAB_BYTES/STRIDE > 0 ) ? SLAB_BYTES/STRIDE : 1;
+
+    private:
+        // The nodes of a slab are stored right after it. Most slabs hold NODES_PER_SLAB
+        // nodes; reserve() links larger ones.
+        struct alignas( NODE_ALIGN ) Slab {
+            Slab *next_slab;
+            int capacity;
+
+            unsigned char *storage();
+        };
+
+        /* The storage shared by all copies of a pool. An arena absorbed while other pools
+         * still used it keeps no storage and forwards to the arena that took its slabs;
+         * those pools move to the end of the chain the next time they are used. */
+        struct Arena {
+            Slab *slab_list;        // Nodes are carved out of the first slab.
+            Slab *last_slab;
+            int slab_used;          // Number of nodes already carved out of the first slab.
+            int slab_capacity;      // Number of nodes the first slab can hold.
+            int slab_count;
+            Free_node *free_list;   // Nodes returned through deallocate().
+            Free_node *last_free;
+            int users;              // Number of pools and arenas referring to this arena.
+            Arena *forward;         // The arena that absorbed this one, or nullptr.
+        };
+
+        mutable Arena *arena;       // nullptr until first used; updated by const members too.
+
+        static Arena *new_arena();
+        static Slab *new_slab( int );
+        void push_slab( int );
+        static void free_slabs( Arena * );
+        static void leave_arena( Arena * );
+        Arena *current() const;
+
+    public:
+        Node_pool();
+        Node_pool( Node_pool const & );
+        Node_pool( Node_pool && );
+        Node_pool &operator=( Node_pool const & );
+        Node_pool &operator=( Node_pool && );
+        ~Node_pool();
+
+        int slabs() const;
+        bool shares( Node_pool const & ) const;
+
+        Node_type *allocate();
+        void deallocate( Node_type * );
+        bool release();
+        bool absorb( Node_pool & );
+        void reserve( int );
+};
+
+// Plain global heap allocator, one operator new per node.
+template <typename Node_type>
+class Heap_allocator {
+    public:
+        Node_type *allocate();
+        void deallocate( Node_type * );
+        bool release();
+        bool shares( Heap_allocator const & ) const;
+        bool absorb( Heap_allocator & );
+        void reserve( int );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                             Node_pool                            //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Node_type>
+Node_pool<Node_type>::Node_pool():
+arena( nullptr ) {
+    // does nothing
+}
+
+// The copy shares the slabs of the original pool.
+template <typename Node_type>
+Node_pool<Node_type>::Node_pool( Node_pool const &pool ):
+arena( pool.current() ) {
+    ++arena->users;
+}
+
+// The new pool takes the slabs, and pool is left like a default-constructed one.
+template <typename Node_type>
+Node_pool<Node_type>::Node_pool( Node_pool &&pool ):
+arena( pool.arena ) {
+    pool.arena = nullptr;
+}
+
+template <typename Node_type>
+Node_pool<Node_type> &Node_pool<Node_type>::operator=( Node_pool const &rhs ) {
+    if ( current() != rhs.current() ) {
+        leave_arena( arena );
+        arena = rhs.arena;
+        ++arena->users;
+    }
+
+    return *this;
+}
+
+template <typename Node_type>
+Node_pool<Node_type> &Node_pool<Node_type>::operator=( Node_pool &&rhs ) {
+    if ( this != &rhs ) {
+        leave_arena( arena );
+        arena = rhs.arena;
+        rhs.arena = nullptr;
+    }
+
+    return *this;
+}
+
+template <typename Node_type>
+Node_pool<Node_type>::~Node_pool() {
+    leave_arena( arena );
+}
+
+// Returns the number of slabs currently held by the pool.
+template <typename Node_type>
+int Node_pool<Node_type>::slabs() const {
+    return current()->slab_count;
+}
+
+// Returns true if both pools hand out nodes from the same slabs.
+template <typename Node_type>
+bool Node_pool<Node_type>::shares( Node_pool const &pool ) const {
+    return ( current() == pool.current() );
+}
+
+// Returns storage for one node, reusing freed nodes before carving new ones.
+template <typename Node_type>
+Node_type *Node_pool<Node_type>::allocate() {
+    Arena *arena = current();
+
+    if ( arena->free_list != nullptr ) {
+        Free_node *recycled = arena->free_list;
+        arena->free_list = recycled->next_free;
+
+        if ( arena->free_list == nullptr ) {
+            arena->last_free = nullptr;
+        }
+
+        return reinterpret_cast<Node_type *>( recycled );
+    }
+
+    // The current slab is full so a new one is linked in front of the others.
+    if ( arena->slab_used == arena->slab_capacity ) {
+        push_slab( NODES_PER_SLAB );
+    }
+
+    return reinterpret_cast<Node_type *>( arena->slab_list->storage() + STRIDE*arena->slab_used++ );
+}
+
+// Returns the storage of a node (already destroyed) to the free list.
+template <typename Node_type>
+void Node_pool<Node_type>::deallocate( Node_type *node ) {
+    Arena *arena = current();
+    Free_node *freed = reinterpret_cast<Free_node *>( node );
+    freed->next_free = arena->free_list;
+
+    if ( arena->free_list == nullptr ) {
+        arena->last_free = freed;
+    }
+
+    arena->free_list = freed;
+}
+
+/* Frees every slab at once. O(number of slabs).
+ * Returns false, and frees nothing, if other pools share the slabs. */
+template <typename Node_type>
+bool Node_pool<Node_type>::release() {
+    if ( arena == nullptr ) {
+        return true;
+    }
+
+    if ( current()->users != 1 ) {
+        return false;
+    }
+
+    free_slabs( arena );
+    return true;
+}
+
+/* Moves the slabs of pool into this pool, after which both pools share them,
+ * so nodes allocated by either one can be handed between containers. O(1).
+ * Every other pool sharing pool's slabs shares this pool's slabs too, so chains
+ * of absorptions between any number of pools always succeed. */
+template <typename Node_type>
+bool Node_pool<Node_type>::absorb( Node_pool &pool ) {
+    Arena *arena = current();
+    Arena *absorbed = pool.current();
+
+    if ( arena == absorbed ) {
+        return true;
+    }
+
+    // Slabs are appended after ours so that we keep carving out of our first slab.
+    // Whatever is left in the absorbed pool's first slab is not used again.
+    if ( absorbed->slab_list != nullptr ) {
+        if ( arena->slab_list == nullptr ) {
+            arena->slab_list = absorbed->slab_list;
+            arena->slab_used = absorbed->slab_used;
+            arena->slab_capacity = absorbed->slab_capacity;
+        } else {
+            arena->last_slab->next_slab = absorbed->slab_list;
+        }
+
+        arena->last_slab = absorbed->last_slab;
+        arena->slab_count += absorbed->slab_count;
+    }
+
+    if ( absorbed->free_list != nullptr ) {
+        absorbed->last_free->next_free = arena->free_list;
+
+        if ( arena->free_list == nullptr ) {
+            arena->last_free = absorbed->last_free;
+        }
+
+        arena->free_list = absorbed->free_list;
+    }
+
+    // The other users of the absorbed arena reach ours through it.
+    absorbed->slab_list = nullptr;
+    absorbed->free_list = nullptr;
+    absorbed->forward = arena;
+    ++arena->users;
+
+    pool.arena = arena;
+    ++arena->users;
+    leave_arena( absorbed );
+
+    return true;
+}
+
+/* Makes sure that the next n nodes not recycled from the free list are carved out of a
+ * single block, so a container built in one go gets one heap allocation and contiguous
+ * nodes. Whatever is left in the current slab when a new block is needed is not used again. */
+template <typename Node_type>
+void Node_pool<Node_type>::reserve( int n ) {
+    Arena *arena = current();
+
+    if ( n > arena->slab_capacity - arena->slab_used ) {
+        push_slab( ( n > NODES_PER_SLAB ) ? n : NODES_PER_SLAB );
+    }
+}
+
+template <typename Node_type>
+typename Node_pool<Node_type>::Arena *Node_pool<Node_type>::new_arena() {
+    PROFILE_ALLOCATION();
+    Arena *arena = new Arena;
+    arena->slab_list = nullptr;
+    arena->last_slab = nullptr;
+    arena->slab_used = 0;
+    arena->slab_capacity = 0;
+    arena->slab_count = 0;
+    arena->free_list = nullptr;
+    arena->last_free = nullptr;
+    arena->users = 1;
+    arena->forward = nullptr;
+
+    return arena;
+}
+
+/* The slabs are freed oldest first, in the order they were allocated. Freeing the newest
+ * first hands malloc one block after another at the top of the heap, which it then keeps
+ * trimming and growing again through system calls. */
+template <typename Node_type>
+void Node_pool<Node_type>::free_slabs( Arena *arena ) {
+    Slab *oldest_first = nullptr;
+
+    while ( arena->slab_list != nullptr ) {
+        Slab *slab = arena->slab_list;
+        arena->slab_list = slab->next_slab;
+        slab->next_slab = oldest_first;
+        oldest_first = slab;
+    }
+
+    while ( oldest_first != nullptr ) {
+        Slab *garbage_slab = oldest_first;
+        oldest_first = oldest_first->next_slab;
+        ::operator delete( garbage_slab );
+    }
+
+    arena->last_slab = nullptr;
+    arena->slab_used = 0;
+    arena->slab_capacity = 0;
+    arena->slab_count = 0;
+    arena->free_list = nullptr;
+    arena->last_free = nullptr;
+}
+
+// Returns an empty slab with room for capacity nodes, allocated together with its header.
+template <typename Node_type>
+typename Node_pool<Node_type>::Slab *Node_pool<Node_type>::new_slab( int capacity ) {
+    PROFILE_ALLOCATION();
+    Slab *slab = static_cast<Slab *>( ::operator new( sizeof( Slab ) + static_cast<std::size_t>( capacity )*STRIDE ) );
+    slab->next_slab = nullptr;
+    slab->capacity = capacity;
+
+    return slab;
+}
+
+// Links a new slab of the given capacity in front of the others and starts carving out of it.
+template <typename Node_type>
+void Node_pool<Node_type>::push_slab( int capacity ) {
+    Arena *arena = current();
+    Slab *slab = new_slab( capacity );
+    slab->next_slab = arena->slab_list;
+
+    if ( arena->slab_list == nullptr ) {
+        arena->last_slab = slab;
+    }
+
+    arena->slab_list = slab;
+    arena->slab_used = 0;
+    arena->slab_capacity = capacity;
+    ++arena->slab_count;
+}
+
+/* Drops a reference to arena, deleting it if that was the last one. A deleted forwarding
+ * arena drops its own reference to the arena it forwards to. */
+template <typename Node_type>
+void Node_pool<Node_type>::leave_arena( Arena *arena ) {
+    while ( arena != nullptr && --arena->users == 0 ) {
+        Arena *forward = arena->forward;
+        free_slabs( arena );
+        delete arena;
+        arena = forward;
+    }
+}
+
+/* Returns the arena holding the pool's slabs, first creating it if the pool has none yet,
+ * or moving the pool past any forwarding arenas. */
+template <typename Node_type>
+typename Node_pool<Node_type>::Arena *Node_pool<Node_type>::current() const {
+    if ( arena == nullptr ) {
+        arena = new_arena();
+    } else if ( arena->forward != nullptr ) {
+        Arena *target = arena->forward;
+
+        while ( target->forward != nullptr ) {
+            target = target->forward;
+        }
+
+        ++target->users;
+        leave_arena( arena );
+        arena = target;
+    }
+
+    return arena;
+}
+
+// The nodes start right after the header, whose size is a multiple of NODE_ALIGN.
+template <typename Node_type>
+unsigned char *Node_pool<Node_type>::Slab::storage() {
+    return reinterpret_cast<unsigned char *>( this ) + sizeof( Slab );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                          Heap_allocator                          //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Node_type>
+Node_type *Heap_allocator<Node_type>::allocate() {
+    PROFILE_ALLOCATION();
+    return static_cast<Node_type *>( ::operator new( sizeof( Node_type ) ) );
+}
+
+template <typename Node_type>
+void Heap_allocator<Node_type>::deallocate( Node_type *node ) {
+    ::operator delete( node );
+}
+
+// Nodes can only be freed one by one through deallocate().
+template <typename Node_type>
+bool Heap_allocator<Node_type>::release() {
+    return false;
+}
+
+// Every node comes from the global heap, so nodes can always move between containers.
+template <typename Node_type>
+bool Heap_allocator<Node_type>::shares( Heap_allocator const & ) const {
+    return true;
+}
+
+template <typename Node_type>
+bool Heap_allocator<Node_type>::absorb( Heap_allocator & ) {
+    return true;
+}
+
+// Every node is allocated on its own, so there is nothing to prepare.
+template <typename Node_type>
+void Heap_allocator<Node_type>::reserve( int ) {
+    // does nothing
+}
+
+#endif
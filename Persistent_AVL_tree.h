@@ -0,0 +1,495 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef PERSISTENT_AVL_TREE_H
+#define PERSISTENT_AVL_TREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "Epoch_reclamation.h"
+
+/* Persistent (path-copying) AVL tree for lock-free readers.
+ *
+ * Published nodes are never modified. insert and erase copy the nodes on the search path
+ * (and the few touched by rotations), then publish the new root atomically, so each root
+ * is an immutable version of the tree. Readers take a Snapshot, which is O(1): it pins the
+ * current epoch and loads the root. They can then search and iterate it without locks while
+ * the writer goes on. Nodes replaced by a write are reclaimed through Epoch_manager once no
+ * snapshot can see them.
+ *
+ * Writers are serialized by a mutex. Every Snapshot must be destroyed before the tree. */
+template <typename Type>
+class Persistent_AVL_tree {
+    private:
+        static const int MAX_HEIGHT = 64;
+
+        class Node {
+            public:
+                Type node_value;
+                int tree_height;
+                int subtree_size;
+                Node const *left_tree;
+                Node const *right_tree;
+                unsigned long version;      // The write that created the node.
+
+                Node( Type const &, Node const *, Node const *, unsigned long );
+        };
+
+        std::atomic<Node const *> root_node;
+        Epoch_manager epochs;
+
+        // Only used by the writer.
+        std::mutex writer_lock;
+        unsigned long write_version;
+        std::vector<Node const *> replaced_nodes;
+
+        static int height( Node const * );
+        static int size( Node const * );
+        static void delete_node( void * );
+        static void delete_tree( void * );
+
+        Node const *make_node( Type const &, Node const *, Node const * );
+        Node const *balance( Type const &, Node const *, Node const * );
+        void discard( Node const * );
+        Node const *insert_copy( Node const *, Type const &, bool & );
+        Node const *erase_copy( Node const *, Type const &, bool & );
+        Node const *erase_front_copy( Node const * );
+        void publish( Node const * );
+
+    public:
+        class Iterator;
+
+        // An immutable version of the tree, valid for as long as the snapshot exists.
+        class Snapshot {
+            private:
+                Epoch_manager::Guard guard;
+                Node const *snapshot_root;
+
+                Snapshot( Epoch_manager::Guard &&, Node const * );
+
+            public:
+                Snapshot( Snapshot && ) = default;
+
+                bool empty() const;
+                int size() const;
+                int height() const;
+                bool member( Type const & ) const;
+
+                Iterator begin() const;
+                Iterator end() const;
+
+                friend class Persistent_AVL_tree;
+        };
+
+        class Iterator {
+            private:
+                Node const *path[MAX_HEIGHT];       // Nodes still to visit on the way up.
+                int depth;                          // The iterator is at end() when depth is 0.
+
+                Iterator();
+                void push_left( Node const * );
+
+            public:
+                Type const &operator*() const;
+                Iterator &operator++();
+                bool operator==( Iterator const &rhs ) const;
+                bool operator!=( Iterator const &rhs ) const;
+
+                friend class Snapshot;
+        };
+
+        Persistent_AVL_tree();
+        ~Persistent_AVL_tree();
+
+        Persistent_AVL_tree( Persistent_AVL_tree const & ) = delete;
+        Persistent_AVL_tree &operator=( Persistent_AVL_tree const & ) = delete;
+
+        Snapshot snapshot();
+
+        void clear();
+        bool insert( Type const & );
+        bool erase( Type const & );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                Search Tree Public Member Functions               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Persistent_AVL_tree<Type>::Persistent_AVL_tree():
+root_node( nullptr ),
+write_version( 0 ) {
+    // does nothing
+}
+
+template <typename Type>
+Persistent_AVL_tree<Type>::~Persistent_AVL_tree() {
+    delete_tree( const_cast<Node *>( root_node.load() ) );
+}
+
+// Pins the current epoch and returns the current version of the tree. O(1).
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Snapshot Persistent_AVL_tree<Type>::snapshot() {
+    Epoch_manager::Guard guard = epochs.pin();
+    Node const *root = root_node.load();
+
+    return Snapshot( std::move( guard ), root );
+}
+
+// Publishes an empty tree. The old version is reclaimed as a whole once no snapshot uses it.
+template <typename Type>
+void Persistent_AVL_tree<Type>::clear() {
+    std::lock_guard<std::mutex> lock( writer_lock );
+    Node const *old_root = root_node.exchange( nullptr );
+
+    if ( old_root != nullptr ) {
+        epochs.retire( const_cast<Node *>( old_root ), delete_tree );
+        epochs.advance();
+        epochs.collect();
+    }
+}
+
+// Inserts obj into a new version of the tree. If obj already exists it returns false.
+template <typename Type>
+bool Persistent_AVL_tree<Type>::insert( Type const &obj ) {
+    std::lock_guard<std::mutex> lock( writer_lock );
+    ++write_version;
+
+    bool inserted = false;
+    Node const *new_root = insert_copy( root_node.load(), obj, inserted );
+
+    if ( inserted ) {
+        publish( new_root );
+    }
+
+    return inserted;
+}
+
+// Erases obj from a new version of the tree. If obj doesn't exist it returns false.
+template <typename Type>
+bool Persistent_AVL_tree<Type>::erase( Type const &obj ) {
+    std::lock_guard<std::mutex> lock( writer_lock );
+    ++write_version;
+
+    bool erased = false;
+    Node const *new_root = erase_copy( root_node.load(), obj, erased );
+
+    if ( erased ) {
+        publish( new_root );
+    }
+
+    return erased;
+}
+
+//////////////////////////////////////////////////////////////////////
+//              Search Tree Private Member Functions                //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+int Persistent_AVL_tree<Type>::height( Node const *node ) {
+    return ( node == nullptr ) ? -1 : node->tree_height;
+}
+
+template <typename Type>
+int Persistent_AVL_tree<Type>::size( Node const *node ) {
+    return ( node == nullptr ) ? 0 : node->subtree_size;
+}
+
+template <typename Type>
+void Persistent_AVL_tree<Type>::delete_node( void *node ) {
+    delete static_cast<Node *>( node );
+}
+
+// Deletes every node of a version that shares no node with the current one.
+template <typename Type>
+void Persistent_AVL_tree<Type>::delete_tree( void *root ) {
+    std::vector<Node const *> pending;
+
+    if ( root != nullptr ) {
+        pending.push_back( static_cast<Node const *>( root ) );
+    }
+
+    while ( !pending.empty() ) {
+        Node const *node = pending.back();
+        pending.pop_back();
+
+        if ( node->left_tree != nullptr ) {
+            pending.push_back( node->left_tree );
+        }
+
+        if ( node->right_tree != nullptr ) {
+            pending.push_back( node->right_tree );
+        }
+
+        delete node;
+    }
+}
+
+// Creates a node for the current write.
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Node const *Persistent_AVL_tree<Type>::make_node( Type const &obj, Node const *left, Node const *right ) {
+    return new Node( obj, left, right, write_version );
+}
+
+/* Returns a new node holding obj with the given sub-trees, rotating if their heights differ
+ * by two. Rotations build new nodes instead of relinking the old ones, which may be shared
+ * with older versions; the nodes they replace are discarded. */
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Node const *Persistent_AVL_tree<Type>::balance( Type const &obj, Node const *left, Node const *right ) {
+    Node const *result;
+
+    if ( height( left ) > height( right ) + 1 ) {
+        if ( height( left->left_tree ) >= height( left->right_tree ) ) {
+            // Case 1
+            result = make_node( left->node_value, left->left_tree, make_node( obj, left->right_tree, right ) );
+        } else {
+            // Case 2
+            Node const *middle = left->right_tree;
+            result = make_node( middle->node_value,
+                                make_node( left->node_value, left->left_tree, middle->left_tree ),
+                                make_node( obj, middle->right_tree, right ) );
+            discard( middle );
+        }
+        discard( left );
+    } else if ( height( right ) > height( left ) + 1 ) {
+        if ( height( right->right_tree ) >= height( right->left_tree ) ) {
+            // Case 1
+            result = make_node( right->node_value, make_node( obj, left, right->left_tree ), right->right_tree );
+        } else {
+            // Case 2
+            Node const *middle = right->left_tree;
+            result = make_node( middle->node_value,
+                                make_node( obj, left, middle->left_tree ),
+                                make_node( right->node_value, middle->right_tree, right->right_tree ) );
+            discard( middle );
+        }
+        discard( right );
+    } else {
+        result = make_node( obj, left, right );
+    }
+
+    return result;
+}
+
+/* A node replaced during the current write is deleted at once if it was created by the
+ * same write (no reader has seen it), and otherwise retired when the new root is published. */
+template <typename Type>
+void Persistent_AVL_tree<Type>::discard( Node const *node ) {
+    if ( node->version == write_version ) {
+        delete node;
+    } else {
+        replaced_nodes.push_back( node );
+    }
+}
+
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Node const *Persistent_AVL_tree<Type>::insert_copy( Node const *node, Type const &obj, bool &inserted ) {
+    if ( node == nullptr ) {
+        inserted = true;
+        return make_node( obj, nullptr, nullptr );
+    }
+
+    Node const *result = node;
+
+    if ( obj < node->node_value ) {
+        Node const *left = insert_copy( node->left_tree, obj, inserted );
+        if ( inserted ) {
+            result = balance( node->node_value, left, node->right_tree );
+            discard( node );
+        }
+    } else if ( obj > node->node_value ) {
+        Node const *right = insert_copy( node->right_tree, obj, inserted );
+        if ( inserted ) {
+            result = balance( node->node_value, node->left_tree, right );
+            discard( node );
+        }
+    }
+
+    return result;
+}
+
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Node const *Persistent_AVL_tree<Type>::erase_copy( Node const *node, Type const &obj, bool &erased ) {
+    if ( node == nullptr ) {
+        return nullptr;
+    }
+
+    Node const *result = node;
+
+    if ( obj < node->node_value ) {
+        Node const *left = erase_copy( node->left_tree, obj, erased );
+        if ( erased ) {
+            result = balance( node->node_value, left, node->right_tree );
+            discard( node );
+        }
+    } else if ( obj > node->node_value ) {
+        Node const *right = erase_copy( node->right_tree, obj, erased );
+        if ( erased ) {
+            result = balance( node->node_value, node->left_tree, right );
+            discard( node );
+        }
+    } else {
+        erased = true;
+
+        if ( node->left_tree == nullptr ) {
+            result = node->right_tree;
+        } else if ( node->right_tree == nullptr ) {
+            result = node->left_tree;
+        } else {
+            // The node takes the value of the next node, which is removed from the right sub-tree.
+            Node const *next = node->right_tree;
+            while ( next->left_tree != nullptr ) {
+                next = next->left_tree;
+            }
+
+            Type const &next_value = next->node_value;
+            Node const *right = erase_front_copy( node->right_tree );
+            result = balance( next_value, node->left_tree, right );
+        }
+        discard( node );
+    }
+
+    return result;
+}
+
+/* Removes the left-most node. It is only discarded after the caller has copied its value,
+ * so it is kept alive until the write is published (it was created by an older write). */
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Node const *Persistent_AVL_tree<Type>::erase_front_copy( Node const *node ) {
+    if ( node->left_tree == nullptr ) {
+        replaced_nodes.push_back( node );
+        return node->right_tree;
+    }
+
+    Node const *result = balance( node->node_value, erase_front_copy( node->left_tree ), node->right_tree );
+    discard( node );
+
+    return result;
+}
+
+// Makes the new version visible to readers and retires the nodes it no longer uses.
+template <typename Type>
+void Persistent_AVL_tree<Type>::publish( Node const *new_root ) {
+    root_node.store( new_root );
+
+    for ( std::size_t i = 0; i < replaced_nodes.size(); ++i ) {
+        epochs.retire( const_cast<Node *>( replaced_nodes[i] ), delete_node );
+    }
+
+    replaced_nodes.clear();
+    epochs.advance();
+    epochs.collect();
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Node Public Member Functions                   //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Persistent_AVL_tree<Type>::Node::Node( Type const &obj, Node const *left, Node const *right, unsigned long created_by ):
+node_value( obj ),
+tree_height( std::max( height( left ), height( right ) ) + 1 ),
+subtree_size( size( left ) + size( right ) + 1 ),
+left_tree( left ),
+right_tree( right ),
+version( created_by ) {
+    // does nothing
+}
+
+//////////////////////////////////////////////////////////////////////
+//               Snapshot Public Member Functions                   //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Persistent_AVL_tree<Type>::Snapshot::Snapshot( Epoch_manager::Guard &&pinned, Node const *root ):
+guard( std::move( pinned ) ),
+snapshot_root( root ) {
+    // does nothing
+}
+
+template <typename Type>
+bool Persistent_AVL_tree<Type>::Snapshot::empty() const {
+    return ( snapshot_root == nullptr );
+}
+
+template <typename Type>
+int Persistent_AVL_tree<Type>::Snapshot::size() const {
+    return Persistent_AVL_tree::size( snapshot_root );
+}
+
+template <typename Type>
+int Persistent_AVL_tree<Type>::Snapshot::height() const {
+    return Persistent_AVL_tree::height( snapshot_root );
+}
+
+template <typename Type>
+bool Persistent_AVL_tree<Type>::Snapshot::member( Type const &obj ) const {
+    Node const *current_node = snapshot_root;
+
+    while ( current_node != nullptr && !( obj == current_node->node_value ) ) {
+        current_node = ( obj < current_node->node_value ) ? current_node->left_tree : current_node->right_tree;
+    }
+
+    return ( current_node != nullptr );
+}
+
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Iterator Persistent_AVL_tree<Type>::Snapshot::begin() const {
+    Iterator itr;
+    itr.push_left( snapshot_root );
+
+    return itr;
+}
+
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Iterator Persistent_AVL_tree<Type>::Snapshot::end() const {
+    return Iterator();
+}
+
+//////////////////////////////////////////////////////////////////////
+//                 Iterator Public Member Functions                 //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Persistent_AVL_tree<Type>::Iterator::Iterator():
+depth( 0 ) {
+    // does nothing
+}
+
+// Pushes node and its chain of left sub-trees; the last one pushed is the next in order.
+template <typename Type>
+void Persistent_AVL_tree<Type>::Iterator::push_left( Node const *node ) {
+    for ( ; node != nullptr; node = node->left_tree ) {
+        path[depth++] = node;
+    }
+}
+
+template <typename Type>
+Type const &Persistent_AVL_tree<Type>::Iterator::operator*() const {
+    return path[depth - 1]->node_value;
+}
+
+template <typename Type>
+typename Persistent_AVL_tree<Type>::Iterator &Persistent_AVL_tree<Type>::Iterator::operator++() {
+    if ( depth > 0 ) {
+        Node const *current_node = path[--depth];
+        push_left( current_node->right_tree );
+    }
+
+    return *this;
+}
+
+template <typename Type>
+bool Persistent_AVL_tree<Type>::Iterator::operator==( Iterator const &rhs ) const {
+    return ( depth == rhs.depth ) && ( depth == 0 || path[depth - 1] == rhs.path[depth - 1] );
+}
+
+template <typename Type>
+bool Persistent_AVL_tree<Type>::Iterator::operator!=( Iterator const &rhs ) const {
+    return !( *this == rhs );
+}
+
+#endif
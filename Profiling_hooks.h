@@ -0,0 +1,359 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef PROFILING_HOOKS_H
+#define PROFILING_HOOKS_H
+
+/* Optional instrumentation of the containers' hot paths, compiled in only when
+ * CONTAINER_PROFILING is defined (e.g. -DCONTAINER_PROFILING). Otherwise the hooks expand
+ * to nothing, Profiler::report prints a single line, and the header includes nothing.
+ *
+ *     PROFILE_OPERATION( AVL_INSERT );    // Profiles the rest of the enclosing block.
+ *     PROFILE_ALLOCATION();               // Counts a heap allocation made by a container.
+ *     PROFILE_ALLOCATIONS( 3 );           // Counts several at once.
+ *
+ * The operations are the enumerators of Profiler::Operation, named without the Profiler::
+ * prefix inside the macro. Each operation class accumulates its number of calls, the
+ * user-space hardware counters read through perf_event_open (cycles, L1 data cache read
+ * misses, last level cache misses and branch misses) and the allocations counted while it
+ * ran. Only the outermost operation of a thread is profiled, so a hash table insert includes
+ * the member() it calls. The counters are read with a system call at both ends of an
+ * operation, which costs about a microsecond each, so the figures are meant to compare
+ * operations, not to time them. Counters that cannot be opened (no PMU, perf_event_paranoid
+ * too high) are reported as "-". Profiler::report( std::cout ) prints the summary table.
+ *
+ * Every allocation the profiled containers make with new is counted: the nodes, slabs and
+ * arenas of the node allocators, the AVL_tree sentinels and the arrays of
+ * Quadratic_hash_table and Weighted_graph. Those made by constructors, outside any
+ * operation, are reported on a line of their own. Memory that a container gets through a
+ * standard container (the std::vectors of Weighted_graph::distances, for instance) is not
+ * counted. */
+
+#ifdef CONTAINER_PROFILING
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PROFILE_CONCAT_( a, b ) a ## b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_( a, b )
+#define PROFILE_OPERATION( operation ) Profiler::Scope PROFILE_CONCAT( profile_scope_, __LINE__ )( Profiler::operation )
+#define PROFILE_ALLOCATION() Profiler::count_allocations( 1 )
+#define PROFILE_ALLOCATIONS( count ) Profiler::count_allocations( count )
+
+class Profiler {
+    public:
+        enum Operation {
+            AVL_INSERT,
+            AVL_ERASE,
+            AVL_FIND,
+            HASH_MEMBER,
+            HASH_INSERT,
+            GRAPH_DISTANCE,
+            OPERATIONS
+        };
+
+        enum Counter { CYCLES, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, COUNTERS };
+
+        // Profiles one operation, from its construction to its destruction.
+        class Scope {
+            private:
+                Operation operation;
+                bool outermost;
+                unsigned long start_allocations;
+                unsigned long long start_counters[COUNTERS];
+
+            public:
+                explicit Scope( Operation );
+                ~Scope();
+
+                Scope( Scope const & ) = delete;
+                Scope &operator=( Scope const & ) = delete;
+        };
+
+        static void count_allocations( unsigned long );
+        static void report( std::ostream & );
+        static void reset();
+
+        static unsigned long long calls( Operation );
+        static unsigned long long allocations( Operation );
+        static unsigned long long allocations_outside_operations();
+
+    private:
+        struct Totals {
+            std::atomic<unsigned long long> calls;
+            std::atomic<unsigned long long> allocations;
+            std::atomic<unsigned long long> counters[COUNTERS];
+        };
+
+        // The counters of the calling thread, opened as one group on first use.
+        struct Thread_counters {
+            int fds[COUNTERS];          // -1 if the counter could not be opened.
+            int group_fd;
+            int depth;                  // Number of nested Scopes.
+            unsigned long allocations;
+
+            Thread_counters();
+            ~Thread_counters();
+        };
+
+        static Totals *totals();
+        static std::atomic<unsigned long long> &outside_totals();
+        static std::atomic<bool> *available();
+        static Thread_counters &thread_counters();
+        static int open_counter( Counter, int );
+        static void read_counters( Thread_counters &, unsigned long long[] );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                             Profiler                             //
+//////////////////////////////////////////////////////////////////////
+
+// Counts heap allocations against the operation the calling thread is in, if any.
+inline void Profiler::count_allocations( unsigned long count ) {
+    Thread_counters &counters = thread_counters();
+
+    if ( counters.depth == 0 ) {
+        outside_totals().fetch_add( count, std::memory_order_relaxed );
+    } else {
+        counters.allocations += count;
+    }
+}
+
+// Prints one row per operation class that was called: calls, then averages per call.
+inline void Profiler::report( std::ostream &out ) {
+    static char const *const names[OPERATIONS] = {
+        "AVL_tree::insert", "AVL_tree::erase", "AVL_tree::find",
+        "Quadratic_hash_table::member", "Quadratic_hash_table::insert", "Weighted_graph::distance"
+    };
+
+    char line[160];
+
+    std::snprintf( line, sizeof( line ), "%-30s %12s %12s %12s %12s %12s %12s",
+                   "operation", "calls", "cycles", "L1D misses", "LLC misses", "br misses", "allocations" );
+    out << line << std::endl;
+
+    for ( int i = 0; i < OPERATIONS; ++i ) {
+        Totals &row = totals()[i];
+        unsigned long long calls = row.calls.load();
+
+        if ( calls == 0 ) {
+            continue;
+        }
+
+        char columns[COUNTERS][16];
+
+        for ( int c = 0; c < COUNTERS; ++c ) {
+            if ( available()[c].load() ) {
+                std::snprintf( columns[c], sizeof( columns[c] ), "%.1f", static_cast<double>( row.counters[c].load() )/calls );
+            } else {
+                std::snprintf( columns[c], sizeof( columns[c] ), "-" );
+            }
+        }
+
+        std::snprintf( line, sizeof( line ), "%-30s %12llu %12s %12s %12s %12s %12.2f",
+                       names[i], calls, columns[CYCLES], columns[L1D_MISSES], columns[LLC_MISSES],
+                       columns[BRANCH_MISSES], static_cast<double>( row.allocations.load() )/calls );
+        out << line << std::endl;
+    }
+
+    out << "allocations outside operations: " << outside_totals().load() << std::endl;
+}
+
+// Clears the totals, e.g. after a warm-up phase.
+inline void Profiler::reset() {
+    outside_totals().store( 0 );
+
+    for ( int i = 0; i < OPERATIONS; ++i ) {
+        totals()[i].calls.store( 0 );
+        totals()[i].allocations.store( 0 );
+
+        for ( int c = 0; c < COUNTERS; ++c ) {
+            totals()[i].counters[c].store( 0 );
+        }
+    }
+}
+
+inline unsigned long long Profiler::calls( Operation operation ) {
+    return totals()[operation].calls.load();
+}
+
+inline unsigned long long Profiler::allocations( Operation operation ) {
+    return totals()[operation].allocations.load();
+}
+
+// Allocations made while no operation was profiled, by constructors for instance.
+inline unsigned long long Profiler::allocations_outside_operations() {
+    return outside_totals().load();
+}
+
+// Function-local statics, so that the header can be included in several translation units.
+inline Profiler::Totals *Profiler::totals() {
+    static Totals table[OPERATIONS];
+    return table;
+}
+
+inline std::atomic<unsigned long long> &Profiler::outside_totals() {
+    static std::atomic<unsigned long long> allocations( 0 );
+    return allocations;
+}
+
+// Whether some thread managed to open each counter.
+inline std::atomic<bool> *Profiler::available() {
+    static std::atomic<bool> flags[COUNTERS];
+    return flags;
+}
+
+inline Profiler::Thread_counters &Profiler::thread_counters() {
+    thread_local Thread_counters counters;
+    return counters;
+}
+
+// Opens a user-space counter of the calling thread on any CPU. Returns -1 if it cannot.
+inline int Profiler::open_counter( Counter counter, int group_fd ) {
+    perf_event_attr attr;
+    std::memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = ( group_fd == -1 ) ? 1 : 0;
+
+    switch ( counter ) {
+        case CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+            break;
+        case LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+
+    return static_cast<int>( syscall( SYS_perf_event_open, &attr, 0, -1, group_fd, 0 ) );
+}
+
+/* Reads the whole group at once. The values come in the order the counters were opened,
+ * which skips those that could not be. Counters that are not open read as 0. */
+inline void Profiler::read_counters( Thread_counters &counters, unsigned long long values[] ) {
+    unsigned long long buffer[1 + COUNTERS] = {0};
+
+    if ( counters.group_fd != -1 && read( counters.group_fd, buffer, sizeof( buffer ) ) <= 0 ) {
+        buffer[0] = 0;
+    }
+
+    int next = 1;
+
+    for ( int c = 0; c < COUNTERS; ++c ) {
+        values[c] = ( counters.fds[c] != -1 && next <= static_cast<int>( buffer[0] ) ) ? buffer[next++] : 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                         Profiler::Scope                          //
+//////////////////////////////////////////////////////////////////////
+
+inline Profiler::Scope::Scope( Operation profiled ):
+operation( profiled ),
+outermost( thread_counters().depth++ == 0 ),
+start_allocations( thread_counters().allocations ) {
+    if ( outermost ) {
+        read_counters( thread_counters(), start_counters );
+    }
+}
+
+inline Profiler::Scope::~Scope() {
+    Thread_counters &counters = thread_counters();
+    --counters.depth;
+
+    if ( !outermost ) {
+        return;
+    }
+
+    unsigned long long end_counters[COUNTERS];
+    read_counters( counters, end_counters );
+
+    Totals &row = totals()[operation];
+    row.calls.fetch_add( 1, std::memory_order_relaxed );
+    row.allocations.fetch_add( counters.allocations - start_allocations, std::memory_order_relaxed );
+
+    for ( int c = 0; c < COUNTERS; ++c ) {
+        row.counters[c].fetch_add( end_counters[c] - start_counters[c], std::memory_order_relaxed );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                    Profiler::Thread_counters                     //
+//////////////////////////////////////////////////////////////////////
+
+// The first counter that opens leads the group; the group is enabled once all are open.
+inline Profiler::Thread_counters::Thread_counters():
+group_fd( -1 ),
+depth( 0 ),
+allocations( 0 ) {
+    for ( int c = 0; c < COUNTERS; ++c ) {
+        fds[c] = open_counter( static_cast<Counter>( c ), group_fd );
+
+        if ( fds[c] != -1 ) {
+            if ( group_fd == -1 ) {
+                group_fd = fds[c];
+            }
+
+            available()[c].store( true );
+        }
+    }
+
+    if ( group_fd != -1 ) {
+        ioctl( group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+        ioctl( group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+    }
+}
+
+inline Profiler::Thread_counters::~Thread_counters() {
+    for ( int c = 0; c < COUNTERS; ++c ) {
+        if ( fds[c] != -1 ) {
+            close( fds[c] );
+        }
+    }
+}
+
+#else
+
+#define PROFILE_OPERATION( operation )
+#define PROFILE_ALLOCATION()
+#define PROFILE_ALLOCATIONS( count )
+
+// report is a template so that this branch needs no stream header.
+class Profiler {
+    public:
+        template <typename Stream>
+        static void report( Stream & );
+        static void reset();
+};
+
+template <typename Stream>
+void Profiler::report( Stream &out ) {
+    out << "Profiling is disabled (compile with -DCONTAINER_PROFILING)\n";
+}
+
+inline void Profiler::reset() {
+    // does nothing
+}
+
+#endif
+
+#endif
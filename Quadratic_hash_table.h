@@ -3,6 +3,12 @@
  ****************************************/
  // Signature type methods provided by Douglas W. Harder https://ece.uwaterloo.ca/~dwharder/
  
+#ifndef QUADRATIC_HASH_TABLE_H
+#define QUADRATIC_HASH_TABLE_H
+
+#include <iostream>
+#include "Profiling_hooks.h"
+
 enum bin_state_t { UNOCCUPIED, OCCUPIED, ERASED };
 
 template <typename Type>
@@ -16,7 +22,15 @@ private:
     int mask;
     Type *array;                        // Array that stores the values
     bin_state_t *occupied;              // Array that stores the current state of each bin.
+    
+    // A bin's state is only valid if its stamp matches the current generation,
+    // otherwise the bin is UNOCCUPIED. This lets clear() run in O(1).
+    unsigned int *generation_stamp;     // Generation in which each bin was last written.
+    unsigned int current_generation;    // Bins stamped with any other value are UNOCCUPIED.
+    
     int hash( Type const & ) const;
+    bin_state_t state( int ) const;
+    void set_state( int, bin_state_t );
     
 public:
     // Constructor / Destructor
@@ -41,6 +55,8 @@ public:
     template <typename T>
     friend std::ostream &operator<<( std::ostream &, Quadratic_hash_table<T> const & );
     
+    // Lets tests/Quadratic_hash_table_test.cpp move the generation close to its wraparound.
+    friend class Quadratic_hash_table_tester;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -56,10 +72,14 @@ power( m ),
 array_size( 1 << power ),
 mask( array_size - 1 ),
 array( new Type[array_size] ),
-occupied( new bin_state_t[array_size] ) {
+occupied( new bin_state_t[array_size] ),
+generation_stamp( new unsigned int[array_size] ),
+current_generation( 1 ) {
+    PROFILE_ALLOCATIONS( 3 );
     
+    // Stamp 0 is never a current generation, so every bin starts UNOCCUPIED.
     for ( int i = 0; i < array_size; ++i ) {
-        occupied[i] = UNOCCUPIED;
+        generation_stamp[i] = 0;
     }
 }
 
@@ -69,6 +89,7 @@ Quadratic_hash_table<Type>::~Quadratic_hash_table() {
     clear();         // Deleting hash table content
     delete[] array;
     delete[] occupied;
+    delete[] generation_stamp;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -86,6 +107,19 @@ int Quadratic_hash_table<Type>::hash(Type const &obj) const{
     return hash_value;
 }
 
+// Returns the state of bin n, treating bins stamped by an older generation as UNOCCUPIED.
+template <typename Type>
+bin_state_t Quadratic_hash_table<Type>::state( int n ) const{
+    return (generation_stamp[n] == current_generation) ? occupied[n] : UNOCCUPIED;
+}
+
+// Sets the state of bin n and stamps it with the current generation.
+template <typename Type>
+void Quadratic_hash_table<Type>::set_state( int n, bin_state_t new_state ){
+    occupied[n] = new_state;
+    generation_stamp[n] = current_generation;
+}
+
 
 // Returns the number of elements currently stored in the hash table.
 template <typename Type>
@@ -114,6 +148,8 @@ bool Quadratic_hash_table<Type>::empty() const{
 // Returns true if object obj is in the hash table and false otherwise.
 template <typename Type>
 bool Quadratic_hash_table<Type>::member(Type const &obj ) const{
+    PROFILE_OPERATION( HASH_MEMBER );
+    
     // The initial vlaue we will be looking at.
     int index = hash(obj);
     
@@ -121,12 +157,12 @@ bool Quadratic_hash_table<Type>::member(Type const &obj ) const{
     for (int i = 1; i <= capacity(); i++) {
         
         // Return false if an empty bin is found
-        if (occupied[index] == UNOCCUPIED) {
+        if (state(index) == UNOCCUPIED) {
             return false;
         }
         
         // Return true if an occupaied bin with the same value is found.
-        if (array[index] == obj && occupied[index] == OCCUPIED) {
+        if (state(index) == OCCUPIED && array[index] == obj) {
             return true;
         }
         
@@ -162,6 +198,7 @@ Type Quadratic_hash_table<Type>::bin( int n ) const {
 // Inserts the argument into the hash table.
 template <typename Type>
 void Quadratic_hash_table<Type>::insert( Type const &obj ){
+    PROFILE_OPERATION( HASH_INSERT );
     
     // Throw overflow exception if the array is full;
     if( size() == capacity()){
@@ -173,19 +210,19 @@ void Quadratic_hash_table<Type>::insert( Type const &obj ){
     // Looping through the entire has table
     if (!member(obj)) {
         for (int i = 1; i <= capacity(); i ++) {
-            if (occupied[index] == UNOCCUPIED) {
+            if (state(index) == UNOCCUPIED) {
                 array[index] = obj;
                 
                  // Updating member variables
-                occupied[index] = OCCUPIED;
+                set_state(index, OCCUPIED);
                 ++bins_occupied;
                 return;
             }
-            if (occupied[index] == ERASED) {
+            if (state(index) == ERASED) {
                 array[index] = obj;
                 
                 // Updating member variables
-                occupied[index] = OCCUPIED;
+                set_state(index, OCCUPIED);
                 --bins_erased;
                 ++bins_occupied;
                 return;
@@ -201,17 +238,17 @@ template <typename Type>
 bool Quadratic_hash_table<Type>::erase( Type const &obj ){
     int index = hash(obj);
     for (int i = 1; i <= capacity(); i++) {
-        if (array[index] == obj && occupied[index] == OCCUPIED) {
+        if (state(index) == OCCUPIED && array[index] == obj) {
             
             // Setting the flag of the "deleted" bin to ERASED.
-            occupied[index] = ERASED;
+            set_state(index, ERASED);
             
             // Updating member variables.
             ++bins_erased;
             --bins_occupied;
             return true;
         }
-        if (occupied[index] == UNOCCUPIED) {
+        if (state(index) == UNOCCUPIED) {
             
             // An unoccupied bin was found so return false.
             return false;
@@ -222,13 +259,18 @@ bool Quadratic_hash_table<Type>::erase( Type const &obj ){
     return false;
 }
 
-// Removes all the elements in the hash table
+/* Removes all the elements in the hash table.
+ * Moving to a new generation makes every bin UNOCCUPIED in O(1). The stamps are
+ * only swept when the generation counter wraps around. */
 template <typename Type>
 void Quadratic_hash_table<Type>::clear(){
     
-    // Setting all values in array to UNOCCUPIED state.
-    for (int i = 0; i< capacity(); i++) {
-        occupied[i] = UNOCCUPIED;
+    if (++current_generation == 0) {
+        // Setting all stamps back to the initial generation.
+        for (int i = 0; i< capacity(); i++) {
+            generation_stamp[i] = 0;
+        }
+        current_generation = 1;
     }
     
     // Updating member variables.
@@ -240,9 +282,9 @@ void Quadratic_hash_table<Type>::clear(){
 template <typename T>
 std::ostream &operator<<( std::ostream &out, Quadratic_hash_table<T> const &hash ) {
     for ( int i = 0; i < hash.capacity(); ++i ) {
-        if ( hash.occupied[i] == UNOCCUPIED ) {
+        if ( hash.state( i ) == UNOCCUPIED ) {
             out << "- ";
-        } else if ( hash.occupied[i] == ERASED ) {
+        } else if ( hash.state( i ) == ERASED ) {
             out << "x ";
         } else {
             out << hash.array[i] << ' ';
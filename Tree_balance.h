@@ -0,0 +1,290 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef TREE_BALANCE_H
+#define TREE_BALANCE_H
+
+/* Balancing policies for AVL_tree.
+ *
+ * A policy restores the balance after a node has been linked or unlinked:
+ *     template <typename Node> static void after_insert( Node **path[], int depth );
+ *     template <typename Node> static void after_erase( Node **path[], int depth );
+ * path[0..depth-1] are the links followed from the root, and path[depth] is the link (in
+ * the last node) whose sub-tree grew or shrank. A policy must also refresh the sub-tree
+ * size of every node on the path. Nodes store the balancing data in tree_height.
+ *
+ * HEIGHT_BALANCED tells whether tree_height is an AVL height, which join and split rely on
+ * to relink trees in O(log n). Other policies rebuild the trees in linear time instead.
+ *
+ * When TREE_BALANCE_STATISTICS is defined (for the whole program), every rotation made by
+ * a tree is counted in Balance_statistics::rotations(), per thread; a double rotation
+ * counts as two. Otherwise the count compiles to nothing. */
+
+#ifdef TREE_BALANCE_STATISTICS
+
+struct Balance_statistics {
+    static long &rotations() {
+        thread_local long count = 0;
+        return count;
+    }
+};
+
+#define COUNT_ROTATIONS( count ) ( Balance_statistics::rotations() += ( count ) )
+
+#else
+
+#define COUNT_ROTATIONS( count )
+
+#endif
+
+// Strict AVL balancing: tree_height is the height and sibling heights differ by at most 1.
+struct AVL_balance {
+    static const bool HEIGHT_BALANCED = true;
+
+    template <typename Node>
+    static void after_insert( Node **path[], int depth );
+    template <typename Node>
+    static void after_erase( Node **path[], int depth );
+
+    private:
+        template <typename Node>
+        static void rebalance( Node **path[], int depth );
+};
+
+/* Weak AVL balancing (Haeupler, Sen and Tarjan, "Rank-balanced trees"). tree_height is a
+ * rank: the rank of a child is 1 or 2 lower than its parent's (an empty tree has rank -1)
+ * and leaves have rank 0. It is the same as AVL while there are only insertions, but an
+ * erase does at most two rotations and O(1) amortized rank changes, where AVL may rotate
+ * all the way up. The height is at most 2 log2 n instead of 1.44 log2 n. */
+struct WAVL_balance {
+    static const bool HEIGHT_BALANCED = false;
+
+    template <typename Node>
+    static void after_insert( Node **path[], int depth );
+    template <typename Node>
+    static void after_erase( Node **path[], int depth );
+
+    private:
+        template <typename Node>
+        static bool insert_step( Node *&link, Node **child );
+        template <typename Node>
+        static bool erase_step( Node *&link, Node **child );
+        template <typename Node>
+        static void rotate_left( Node *&link );
+        template <typename Node>
+        static void rotate_right( Node *&link );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                            AVL_balance                           //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Node>
+void AVL_balance::after_insert( Node **path[], int depth ) {
+    rebalance( path, depth );
+}
+
+template <typename Node>
+void AVL_balance::after_erase( Node **path[], int depth ) {
+    rebalance( path, depth );
+}
+
+/* Updates and rebalances every node on the path, from the deepest one up to the root.
+ * A rotation replaces the node through its link. The sub-tree sizes change all the way
+ * up, so the pass never stops early. */
+template <typename Node>
+void AVL_balance::rebalance( Node **path[], int depth ) {
+    while ( depth > 0 ) {
+        Node *&link = *path[--depth];
+        link->update_height();
+        link->check_balance( link );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                           WAVL_balance                           //
+//////////////////////////////////////////////////////////////////////
+
+// Promotes nodes up the path until the new node's ancestors are valid, then only updates sizes.
+template <typename Node>
+void WAVL_balance::after_insert( Node **path[], int depth ) {
+    bool balanced = false;
+
+    while ( depth > 0 ) {
+        Node **child = path[depth];
+        Node *&link = *path[--depth];
+
+        if ( !balanced ) {
+            balanced = insert_step( link, child );
+        }
+
+        link->update_size();
+    }
+}
+
+// Demotes nodes up the path until no node is a 3-child or a 2,2 leaf, then only updates sizes.
+template <typename Node>
+void WAVL_balance::after_erase( Node **path[], int depth ) {
+    bool balanced = false;
+
+    while ( depth > 0 ) {
+        Node **child = path[depth];
+        Node *&link = *path[--depth];
+
+        if ( !balanced ) {
+            balanced = erase_step( link, child );
+        }
+
+        link->update_size();
+    }
+}
+
+/* The child of the node at link has just been inserted or promoted. Returns true once the
+ * tree is balanced, false if the node was promoted and its parent has to be checked. */
+template <typename Node>
+bool WAVL_balance::insert_step( Node *&link, Node **child ) {
+    Node *parent = link;
+    Node *raised = *child;
+
+    // The rank differences are still 1 or 2.
+    if ( raised->tree_height != parent->tree_height ) {
+        return true;
+    }
+
+    bool is_left = ( child == &parent->left_tree );
+    Node *sibling = is_left ? parent->right_tree : parent->left_tree;
+
+    // The parent is a 0,1 node: promoting it moves the problem one level up.
+    if ( parent->tree_height - Node::height( sibling ) == 1 ) {
+        ++parent->tree_height;
+        return false;
+    }
+
+    // The parent is a 0,2 node: one single or double rotation ends the insertion.
+    Node *inner = is_left ? raised->right_tree : raised->left_tree;
+
+    if ( raised->tree_height - Node::height( inner ) == 2 ) {
+        if ( is_left ) {
+            rotate_right( link );
+        } else {
+            rotate_left( link );
+        }
+        --parent->tree_height;
+    } else {
+        if ( is_left ) {
+            rotate_left( parent->left_tree );
+            rotate_right( link );
+        } else {
+            rotate_right( parent->right_tree );
+            rotate_left( link );
+        }
+        ++inner->tree_height;
+        --raised->tree_height;
+        --parent->tree_height;
+    }
+
+    return true;
+}
+
+/* The sub-tree at child, below the node at link, has just lost a node or been demoted.
+ * Returns true once the tree is balanced, false if the node was demoted and its parent
+ * has to be checked. */
+template <typename Node>
+bool WAVL_balance::erase_step( Node *&link, Node **child ) {
+    Node *parent = link;
+
+    // A leaf must have rank 0.
+    if ( parent->is_leaf() ) {
+        if ( parent->tree_height == 1 ) {
+            parent->tree_height = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Nothing to do unless the child is a 3-child.
+    if ( parent->tree_height - Node::height( *child ) < 3 ) {
+        return true;
+    }
+
+    bool is_left = ( child == &parent->left_tree );
+    Node *sibling = is_left ? parent->right_tree : parent->left_tree;
+
+    if ( parent->tree_height - sibling->tree_height == 2 ) {
+        // The parent is a 3,2 node.
+        --parent->tree_height;
+        return false;
+    }
+
+    Node *outer = is_left ? sibling->right_tree : sibling->left_tree;
+    Node *inner = is_left ? sibling->left_tree : sibling->right_tree;
+
+    if ( sibling->tree_height - Node::height( outer ) == 2 && sibling->tree_height - Node::height( inner ) == 2 ) {
+        // The parent is a 3,1 node whose sibling is a 2,2 node.
+        --parent->tree_height;
+        --sibling->tree_height;
+        return false;
+    }
+
+    // One single or double rotation ends the erase.
+    if ( sibling->tree_height - Node::height( outer ) == 1 ) {
+        if ( is_left ) {
+            rotate_left( link );
+        } else {
+            rotate_right( link );
+        }
+        ++sibling->tree_height;
+        --parent->tree_height;
+
+        if ( parent->is_leaf() ) {
+            --parent->tree_height;
+        }
+    } else {
+        if ( is_left ) {
+            rotate_right( parent->right_tree );
+            rotate_left( link );
+        } else {
+            rotate_left( parent->left_tree );
+            rotate_right( link );
+        }
+        inner->tree_height += 2;
+        --sibling->tree_height;
+        parent->tree_height -= 2;
+    }
+
+    return true;
+}
+
+// Replaces the node at link by its right child. Ranks are left to the caller.
+template <typename Node>
+void WAVL_balance::rotate_left( Node *&link ) {
+    COUNT_ROTATIONS( 1 );
+    Node *node = link;
+    Node *raised = node->right_tree;
+
+    node->right_tree = raised->left_tree;
+    raised->left_tree = node;
+
+    node->update_size();
+    raised->update_size();
+    link = raised;
+}
+
+// Replaces the node at link by its left child. Ranks are left to the caller.
+template <typename Node>
+void WAVL_balance::rotate_right( Node *&link ) {
+    COUNT_ROTATIONS( 1 );
+    Node *node = link;
+    Node *raised = node->left_tree;
+
+    node->left_tree = raised->right_tree;
+    raised->right_tree = node;
+
+    node->update_size();
+    raised->update_size();
+    link = raised;
+}
+
+#endif
@@ -0,0 +1,609 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef UNROLLED_LINKED_LIST_H
+#define UNROLLED_LINKED_LIST_H
+
+#include <iostream>
+#include <new>
+#include <utility>
+#include "Node_pool.h"
+
+/* Unrolled doubly linked list: every node (a chunk) holds up to CHUNK_CAPACITY values,
+ * about 64 bytes' worth, in a contiguous array.
+ *
+ * It has the push/pop interface of Double_linked_list, and its chunks are walked with
+ * previous() and next() like Double_node. find, count and erase scan the values of a
+ * chunk as a plain array, so there is one pointer to chase per chunk instead of per value,
+ * and for arithmetic types the compiler can vectorize the comparisons.
+ *
+ * The values of a chunk occupy the slots [first, first + count), so a value can be pushed
+ * at either end of the list in O(1) without shifting the others. */
+template <typename Type, template <typename> class Allocator = Node_pool>
+class Unrolled_linked_list {
+	public:
+		static const int CHUNK_CAPACITY = ( sizeof( Type ) < 64 ) ? 64/sizeof( Type ) : 1;
+
+		class Chunk {
+			public:
+				int size() const;
+				Type const &value( int ) const;
+				Type const *data() const;       // The size() values, contiguous.
+				Chunk *previous() const;
+				Chunk *next() const;
+
+			private:
+				alignas( Type ) unsigned char storage[CHUNK_CAPACITY*sizeof( Type )];
+				int first;                      // Slot of the first value.
+				int count;
+				Chunk *previous_chunk;
+				Chunk *next_chunk;
+
+				Type *slots();
+				Type const *slots() const;
+
+				friend class Unrolled_linked_list;
+		};
+
+		typedef Allocator<Chunk> Node_allocator;
+
+		Unrolled_linked_list();
+		explicit Unrolled_linked_list( Node_allocator const & );
+		Unrolled_linked_list( Unrolled_linked_list const & );
+		Unrolled_linked_list( Unrolled_linked_list && );
+		~Unrolled_linked_list();
+
+		// Accessors
+
+		int size() const;
+		bool empty() const;
+		int chunks() const;
+
+		Type const &front() const;
+		Type const &back() const;
+
+		Chunk *begin() const;
+		Chunk *end() const;
+		Chunk *rbegin() const;
+		Chunk *rend() const;
+
+		Type const *find( Type const & ) const;
+		int count( Type const & ) const;
+
+		// Mutators
+
+		void swap( Unrolled_linked_list & );
+		Unrolled_linked_list &operator=( Unrolled_linked_list );
+
+		void push_front( Type const & );
+		void push_back( Type const & );
+
+		void pop_front();
+		void pop_back();
+
+		int erase( Type const & );
+		void clear();
+
+	private:
+		Node_allocator node_allocator;
+		Chunk *first_chunk;
+		Chunk *last_chunk;
+		int list_size;
+		int chunk_count;
+
+		Chunk *create_chunk( int first, Chunk *previous, Chunk *next );
+		void destroy_chunk( Chunk * );
+		void merge_chunks( Chunk *, Chunk * );
+
+	// Friends
+
+	template <typename T, template <typename> class A>
+	friend std::ostream &operator<<( std::ostream &, Unrolled_linked_list<T, A> const & );
+};
+
+/////////////////////////////////////////////////////////////////////////
+//                      Public member functions                        //
+/////////////////////////////////////////////////////////////////////////
+
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator>::Unrolled_linked_list():
+node_allocator(),
+first_chunk( nullptr ),
+last_chunk( nullptr ),
+list_size( 0 ),
+chunk_count( 0 )
+{
+    // does nothing
+}
+
+// Lists built with copies of one pool share its chunks.
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator>::Unrolled_linked_list( Node_allocator const &allocator ):
+node_allocator( allocator ),
+first_chunk( nullptr ),
+last_chunk( nullptr ),
+list_size( 0 ),
+chunk_count( 0 )
+{
+    // does nothing
+}
+
+// The copy packs the values into full chunks.
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator>::Unrolled_linked_list( Unrolled_linked_list const &list ):
+node_allocator(),
+first_chunk( nullptr ),
+last_chunk( nullptr ),
+list_size( 0 ),
+chunk_count( 0 )
+{
+    for ( Chunk *chunk = list.first_chunk; chunk != nullptr; chunk = chunk->next_chunk )
+    {
+        Type const *values = chunk->data();
+
+        for ( int i = 0; i < chunk->count; ++i )
+        {
+            push_back( values[i] );
+        }
+    }
+}
+
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator>::Unrolled_linked_list( Unrolled_linked_list &&list ):
+node_allocator(),
+first_chunk( nullptr ),
+last_chunk( nullptr ),
+list_size( 0 ),
+chunk_count( 0 )
+{
+    swap( list );
+}
+
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator>::~Unrolled_linked_list()
+{
+    clear();
+}
+
+template <typename Type, template <typename> class Allocator>
+int Unrolled_linked_list<Type, Allocator>::size() const
+{
+    return list_size;
+}
+
+template <typename Type, template <typename> class Allocator>
+bool Unrolled_linked_list<Type, Allocator>::empty() const
+{
+    return ( list_size == 0 );
+}
+
+// Returns the number of chunks in the list.
+template <typename Type, template <typename> class Allocator>
+int Unrolled_linked_list<Type, Allocator>::chunks() const
+{
+    return chunk_count;
+}
+
+template <typename Type, template <typename> class Allocator>
+Type const &Unrolled_linked_list<Type, Allocator>::front() const
+{
+    if ( empty() )
+    {
+        throw underflow();
+    }
+
+    return first_chunk->data()[0];
+}
+
+template <typename Type, template <typename> class Allocator>
+Type const &Unrolled_linked_list<Type, Allocator>::back() const
+{
+    if ( empty() )
+    {
+        throw underflow();
+    }
+
+    return last_chunk->data()[last_chunk->count - 1];
+}
+
+// The chunks are walked from begin() to end() (nullptr) with next(), or backwards
+// from rbegin() to rend() (nullptr) with previous().
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::begin() const
+{
+    return first_chunk;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::end() const
+{
+    return nullptr;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::rbegin() const
+{
+    return last_chunk;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::rend() const
+{
+    return nullptr;
+}
+
+/* Returns the address of the first value equal to obj, or nullptr if there is none.
+ * Each chunk is first tested with a loop that has no early exit (so it can be vectorized),
+ * and only the chunk that holds a match is searched value by value. */
+template <typename Type, template <typename> class Allocator>
+Type const *Unrolled_linked_list<Type, Allocator>::find( Type const &obj ) const
+{
+    for ( Chunk *chunk = first_chunk; chunk != nullptr; chunk = chunk->next_chunk )
+    {
+        Type const *values = chunk->data();
+        bool found = false;
+
+        for ( int i = 0; i < chunk->count; ++i )
+        {
+            found |= ( values[i] == obj );
+        }
+
+        if ( found )
+        {
+            for ( int i = 0; ; ++i )
+            {
+                if ( values[i] == obj )
+                {
+                    return &values[i];
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+// Returns the number of values equal to obj. The inner loop has no branch.
+template <typename Type, template <typename> class Allocator>
+int Unrolled_linked_list<Type, Allocator>::count( Type const &obj ) const
+{
+    int total_matches = 0;
+
+    for ( Chunk *chunk = first_chunk; chunk != nullptr; chunk = chunk->next_chunk )
+    {
+        Type const *values = chunk->data();
+
+        for ( int i = 0; i < chunk->count; ++i )
+        {
+            total_matches += ( values[i] == obj );
+        }
+    }
+
+    return total_matches;
+}
+
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::swap( Unrolled_linked_list &list )
+{
+    std::swap( node_allocator, list.node_allocator );
+    std::swap( first_chunk, list.first_chunk );
+    std::swap( last_chunk, list.last_chunk );
+    std::swap( list_size, list.list_size );
+    std::swap( chunk_count, list.chunk_count );
+}
+
+template <typename Type, template <typename> class Allocator>
+Unrolled_linked_list<Type, Allocator> &Unrolled_linked_list<Type, Allocator>::operator=( Unrolled_linked_list rhs )
+{
+    swap( rhs );
+
+    return *this;
+}
+
+/* Adds a value to the front of the list. If the first chunk has no free slot in front of
+ * its values, a new chunk is linked in and filled from its last slot backwards. */
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::push_front( Type const &obj )
+{
+    if ( first_chunk == nullptr || first_chunk->first == 0 )
+    {
+        first_chunk = create_chunk( CHUNK_CAPACITY, nullptr, first_chunk );
+    }
+
+    new ( first_chunk->slots() + first_chunk->first - 1 ) Type( obj );
+    --first_chunk->first;
+    ++first_chunk->count;
+    ++list_size;
+}
+
+/* Adds a value to the back of the list. If the last chunk has no free slot after its
+ * values, a new chunk is linked in and filled from its first slot. */
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::push_back( Type const &obj )
+{
+    if ( last_chunk == nullptr || last_chunk->first + last_chunk->count == CHUNK_CAPACITY )
+    {
+        last_chunk = create_chunk( 0, last_chunk, nullptr );
+    }
+
+    new ( last_chunk->slots() + last_chunk->first + last_chunk->count ) Type( obj );
+    ++last_chunk->count;
+    ++list_size;
+}
+
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::pop_front()
+{
+    if ( empty() )
+    {
+        throw underflow();
+    }
+
+    first_chunk->slots()[first_chunk->first].~Type();
+    ++first_chunk->first;
+    --first_chunk->count;
+    --list_size;
+
+    if ( first_chunk->count == 0 )
+    {
+        destroy_chunk( first_chunk );
+    }
+}
+
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::pop_back()
+{
+    if ( empty() )
+    {
+        throw underflow();
+    }
+
+    --last_chunk->count;
+    last_chunk->slots()[last_chunk->first + last_chunk->count].~Type();
+    --list_size;
+
+    if ( last_chunk->count == 0 )
+    {
+        destroy_chunk( last_chunk );
+    }
+}
+
+/* Deletes all the values equal to obj and returns how many were deleted. The values left
+ * in each chunk are moved down over the deleted ones, and empty chunks are unlinked. A chunk
+ * whose values fit in the free slots of the chunk before it is merged into that chunk, so
+ * that erasing values here and there does not leave a trail of nearly empty chunks. */
+template <typename Type, template <typename> class Allocator>
+int Unrolled_linked_list<Type, Allocator>::erase( Type const &obj )
+{
+    int deleted_values = 0;
+    Chunk *chunk = first_chunk;
+
+    while ( chunk != nullptr )
+    {
+        Type *values = chunk->slots() + chunk->first;
+        int kept = 0;
+
+        for ( int i = 0; i < chunk->count; ++i )
+        {
+            if ( !( values[i] == obj ) )
+            {
+                if ( kept != i )
+                {
+                    values[kept] = std::move( values[i] );
+                }
+                ++kept;
+            }
+        }
+
+        for ( int i = kept; i < chunk->count; ++i )
+        {
+            values[i].~Type();
+        }
+
+        deleted_values += chunk->count - kept;
+        list_size -= chunk->count - kept;
+        chunk->count = kept;
+
+        Chunk *next = chunk->next_chunk;
+
+        if ( kept == 0 )
+        {
+            destroy_chunk( chunk );
+        }
+        else if ( chunk->previous_chunk != nullptr && chunk->previous_chunk->count + kept <= CHUNK_CAPACITY )
+        {
+            merge_chunks( chunk->previous_chunk, chunk );
+        }
+
+        chunk = next;
+    }
+
+    return deleted_values;
+}
+
+// Deletes every value and every chunk.
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::clear()
+{
+    while ( first_chunk != nullptr )
+    {
+        Type *values = first_chunk->slots() + first_chunk->first;
+
+        for ( int i = 0; i < first_chunk->count; ++i )
+        {
+            values[i].~Type();
+        }
+
+        destroy_chunk( first_chunk );
+    }
+
+    list_size = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                      Private member functions                       //
+/////////////////////////////////////////////////////////////////////////
+
+// Creates an empty chunk whose values will start at slot first, and links it between previous and next.
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::create_chunk( int first, Chunk *previous, Chunk *next )
+{
+    Chunk *chunk = new ( node_allocator.allocate() ) Chunk;
+    chunk->first = first;
+    chunk->count = 0;
+    chunk->previous_chunk = previous;
+    chunk->next_chunk = next;
+
+    if ( previous == nullptr )
+    {
+        first_chunk = chunk;
+    }
+    else
+    {
+        previous->next_chunk = chunk;
+    }
+
+    if ( next == nullptr )
+    {
+        last_chunk = chunk;
+    }
+    else
+    {
+        next->previous_chunk = chunk;
+    }
+
+    ++chunk_count;
+
+    return chunk;
+}
+
+// Unlinks an empty chunk (its values already destroyed) and returns it to the allocator.
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::destroy_chunk( Chunk *chunk )
+{
+    if ( chunk->previous_chunk == nullptr )
+    {
+        first_chunk = chunk->next_chunk;
+    }
+    else
+    {
+        chunk->previous_chunk->next_chunk = chunk->next_chunk;
+    }
+
+    if ( chunk->next_chunk == nullptr )
+    {
+        last_chunk = chunk->previous_chunk;
+    }
+    else
+    {
+        chunk->next_chunk->previous_chunk = chunk->previous_chunk;
+    }
+
+    --chunk_count;
+    chunk->~Chunk();
+    node_allocator.deallocate( chunk );
+}
+
+/* Moves the values of chunk back to the end of chunk front, the chunk before it, and
+ * destroys back. The values of front are first moved down to its first slot if there is
+ * not enough room after them. Both chunks must fit in one. */
+template <typename Type, template <typename> class Allocator>
+void Unrolled_linked_list<Type, Allocator>::merge_chunks( Chunk *front, Chunk *back )
+{
+    Type *slots = front->slots();
+
+    if ( front->first + front->count + back->count > CHUNK_CAPACITY )
+    {
+        for ( int i = 0; i < front->count; ++i )
+        {
+            new ( slots + i ) Type( std::move( slots[front->first + i] ) );
+            slots[front->first + i].~Type();
+        }
+
+        front->first = 0;
+    }
+
+    Type *values = back->slots() + back->first;
+
+    for ( int i = 0; i < back->count; ++i )
+    {
+        new ( slots + front->first + front->count + i ) Type( std::move( values[i] ) );
+        values[i].~Type();
+    }
+
+    front->count += back->count;
+    back->count = 0;
+    destroy_chunk( back );
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                          Nested Class Chunk                         //
+/////////////////////////////////////////////////////////////////////////
+
+template <typename Type, template <typename> class Allocator>
+int Unrolled_linked_list<Type, Allocator>::Chunk::size() const
+{
+    return count;
+}
+
+// Returns the i-th value of the chunk, 0 <= i < size().
+template <typename Type, template <typename> class Allocator>
+Type const &Unrolled_linked_list<Type, Allocator>::Chunk::value( int i ) const
+{
+    return slots()[first + i];
+}
+
+template <typename Type, template <typename> class Allocator>
+Type const *Unrolled_linked_list<Type, Allocator>::Chunk::data() const
+{
+    return slots() + first;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::Chunk::previous() const
+{
+    return previous_chunk;
+}
+
+template <typename Type, template <typename> class Allocator>
+typename Unrolled_linked_list<Type, Allocator>::Chunk *Unrolled_linked_list<Type, Allocator>::Chunk::next() const
+{
+    return next_chunk;
+}
+
+template <typename Type, template <typename> class Allocator>
+Type *Unrolled_linked_list<Type, Allocator>::Chunk::slots()
+{
+    return reinterpret_cast<Type *>( storage );
+}
+
+template <typename Type, template <typename> class Allocator>
+Type const *Unrolled_linked_list<Type, Allocator>::Chunk::slots() const
+{
+    return reinterpret_cast<Type const *>( storage );
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                               Friends                               //
+/////////////////////////////////////////////////////////////////////////
+
+// Prints the values chunk by chunk, e.g. [1 2 3]->[4 5]->0
+template <typename T, template <typename> class A>
+std::ostream &operator<<( std::ostream &out, Unrolled_linked_list<T, A> const &list ) {
+    for ( typename Unrolled_linked_list<T, A>::Chunk *chunk = list.begin(); chunk != list.end(); chunk = chunk->next() ) {
+        out << "[";
+
+        for ( int i = 0; i < chunk->size(); ++i ) {
+            out << ( i == 0 ? "" : " " ) << chunk->value( i );
+        }
+
+        out << "]->";
+    }
+
+    out << "0";
+
+    return out;
+}
+
+#endif
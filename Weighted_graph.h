@@ -4,16 +4,40 @@
  
  // Signature type methods provided by Douglas W. Harder https://ece.uwaterloo.ca/~dwharder/
  
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Profiling_hooks.h"
 
 class Weighted_graph {
+	public:
+		// An edge between vertices m and n of weight w.
+		struct Edge {
+			int m;
+			int n;
+			double w;
+		};
+
 	private:
         // Private members
         double *matrix;             // This list contains all entries and its edges to other entries.
         int num_vertices;           // The number of vertices in the graph.
         int num_edges;              // The number of edges in the graph.
         int *vertice_degree_array;  // Array of size n containg the degree of each vertice.
+        double edge_weight_sum;     // The sum of the weights of all edges, for the default delta.
+    
+        // For connectivity purposes (edges are never removed, so components only merge)
+        int *component_parent;      // Union-find forest of the connected components.
+        int *component_size;        // Number of vertices under each root.
+        int num_components;         // The number of connected components.
     
         // For Dijkistra's algorithm purposes
         double *vertices;           // Table with the entries and 2 columns per entry.
@@ -21,7 +45,42 @@ class Weighted_graph {
         double *shortest_dist;      // List of shortest distances between nodes.
         bool *updated;              // Updated vertices flags.
     
+        // For streaming ingestion purposes
+        std::vector<Edge> delta_log;         // Updates staged since the last epoch, in arrival order.
+        std::mutex delta_mutex;              // Guards delta_log only.
+    
 		static const double INF;    // Infinity constant.
+		static const long PARALLEL_GRAIN = 1 << 16;  // Matrix entries scanned per thread, at least.
+
+		// Threads started once per query and handed every relaxation phase of it.
+		class Thread_team {
+			private:
+				std::vector<std::thread> workers;
+				std::mutex team_mutex;
+				std::condition_variable work_ready;
+				std::condition_variable work_done;
+				std::function<void(int)> const *task;
+				int active;                 // Threads running the current phase, the caller included.
+				int pending;                // Workers that have not finished the current phase.
+				unsigned long phase;        // Bumped for every phase handed out.
+				bool stopping;
+
+				void work(int);
+				void stop();
+
+			public:
+				explicit Thread_team(int);
+				~Thread_team();
+
+				int size() const;
+				void run(int, std::function<void(int)> const &);
+		};
+
+		bool set_edge( int, int, double );
+		static int find_root( int *, int );
+		static bool unite( int *, int *, int, int );
+		static bool lighter( Edge const &, Edge const & );
+		void relax( std::vector<int> const &, bool, double, std::atomic<double> *, std::vector<std::vector<int> > &, Thread_team & ) const;
 
 	public:
 		Weighted_graph( int = 50 );
@@ -31,7 +90,19 @@ class Weighted_graph {
 		int edge_count() const;
 		double adjacent( int, int ) const;
 		double distance( int, int );
+		std::vector<double> distances( int, int = 0, double = 0 );
+
+		// Spanning trees and connectivity
+		std::vector<Edge> minimum_spanning_tree() const;
+		std::vector<Edge> parallel_minimum_spanning_tree( int = 0 ) const;
+		std::vector<int> connected_components();
+		int component_count() const;
 		void insert( int, int, double );
+
+		// Streaming ingestion
+		void stage( int, int, double );
+		int staged();
+		int apply_epoch();
 };
 
 const double Weighted_graph::INF = std::numeric_limits<double>::infinity();
@@ -43,6 +114,7 @@ const double Weighted_graph::INF = std::numeric_limits<double>::infinity();
 // Constructor
 Weighted_graph::Weighted_graph(int n):
 num_edges(0),
+edge_weight_sum(0),
 empty(true){
     
     if(n <=0){
@@ -55,6 +127,10 @@ empty(true){
     vertices = new double [n*2];
     matrix = new double [n*n];
     shortest_dist = new double [n*n];
+    component_parent = new int[n];
+    component_size = new int[n];
+    PROFILE_ALLOCATIONS( 7 );
+    num_components = n;
     
     // Using -1 for infinity instead of INF to speed up the comparison process.
     for (int i = 0; i < n*n; ++i) {
@@ -63,6 +139,8 @@ empty(true){
         if (i<n) {
             matrix[num_vertices*i + i] = 0;
             vertice_degree_array[i] = 0;
+            component_parent[i] = i;
+            component_size[i] = 1;
             updated[i] = true;
             shortest_dist[num_vertices*i + i] = 0;
         }
@@ -77,6 +155,8 @@ Weighted_graph::~Weighted_graph(){
     delete [] vertice_degree_array;
     delete [] vertices;
     delete [] updated;
+    delete [] component_parent;
+    delete [] component_size;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -118,23 +198,74 @@ void Weighted_graph::insert(int m, int n, double w){
         throw illegal_argument();
     }
     
-    // Increment the number of edges and the vertices' degree whenever we create a new edge.
-    if (matrix[m*num_vertices +n] == -1) {
-        num_edges++;
-        vertice_degree_array[n] = vertice_degree_array[n] + 1;
-        vertice_degree_array[m] = vertice_degree_array[m] + 1;
+    // Setting empty flag to true. It means that the values in the shortest_dist table are no longer correct.
+    if (set_edge(m, n, w)) {
+        empty = true;
     }
+}
+
+/* Stages an insertion or re-weighting in the delta log instead of applying it. The graph,
+ * and so every query, is unchanged until the next apply_epoch(). Any number of threads may
+ * stage updates while queries run, as only the log is touched. */
+void Weighted_graph::stage(int m, int n, double w){
     
-    // Updating the matrix with the new edges.
-    matrix[m*num_vertices + n] = w;
-    matrix[n*num_vertices + m] = w;
+    // Throw exception if parameters are incompatible, so that the log only holds valid updates.
+    if(w <= 0 || m == n || m >= num_vertices || m < 0 || n >= num_vertices || n < 0){
+        throw illegal_argument();
+    }
     
-    // Setting empty flag to true. It means that the values in the shortest_dist table are no longer correct.
-    empty = true;
+    Edge update = {m, n, w};
+    
+    std::lock_guard<std::mutex> lock(delta_mutex);
+    delta_log.push_back(update);
+}
+
+// Returns the number of updates waiting for the next epoch.
+int Weighted_graph::staged(){
+    std::lock_guard<std::mutex> lock(delta_mutex);
+    return static_cast<int>(delta_log.size());
+}
+
+/* Applies every staged update in arrival order (the last weight staged for an edge wins) and
+ * returns how many were applied. The shortest distances are invalidated once for the whole
+ * batch, and only if some weight changed. The log is swapped out first, so producers can keep
+ * staging the next batch meanwhile; queries must not run concurrently with this call. */
+int Weighted_graph::apply_epoch(){
+    std::vector<Edge> batch;
+    
+    {
+        std::lock_guard<std::mutex> lock(delta_mutex);
+        batch.swap(delta_log);
+    }
+    
+    int applied = static_cast<int>(batch.size());
+    bool changed = false;
+    
+    for (int i = 0; i < applied; ++i) {
+        changed = set_edge(batch[i].m, batch[i].n, batch[i].w) || changed;
+    }
+    
+    if (changed) {
+        empty = true;
+    }
+    
+    // Handing the emptied buffer back keeps its capacity for the next batch.
+    batch.clear();
+    
+    {
+        std::lock_guard<std::mutex> lock(delta_mutex);
+        
+        if (delta_log.empty()) {
+            delta_log.swap(batch);
+        }
+    }
+    
+    return applied;
 }
 
 // This method returns the shortest path between vertices m and n.
 double Weighted_graph::distance(int m, int n){
+    PROFILE_OPERATION( GRAPH_DISTANCE );
     
     // Throw exception if the argument does not correspond to an existing vertex
     if(m >= num_vertices || m < 0 || n >= num_vertices || n < 0){
@@ -146,6 +277,11 @@ double Weighted_graph::distance(int m, int n){
         return 0;
     }
     
+    // Vertices in different components are disconnected, no search needed.
+    if (find_root(component_parent, m) != find_root(component_parent, n)) {
+        return INF;
+    }
+    
     // If the value was already calculated from a previous search just return that value.
     if(!empty){
         if (updated[m]) {
@@ -235,3 +371,510 @@ double Weighted_graph::distance(int m, int n){
     
     return (result == -1)?INF:result;
 }
+
+/* Returns the shortest distances from vertex m to every vertex (INF if unreachable) using
+ * delta-stepping (Meyer and Sanders, "Delta-stepping: a parallelizable shortest path
+ * algorithm"), and caches them for distance().
+ *
+ * Vertices are kept in buckets of width delta by tentative distance and the buckets are
+ * settled in order. Within a bucket, the light edges (weight <= delta) of its vertices are
+ * relaxed repeatedly until no vertex re-enters it, then their heavy edges are relaxed once.
+ * Each relaxation phase splits its vertices between a team of threads, started once for the
+ * query, which lower the tentative distances with a compare-and-swap. Every distance is the
+ * sum of the weights along a shortest path, added in path order, so the results are
+ * identical to distance()'s.
+ *
+ * threads = 0 uses every hardware thread; small phases run on fewer threads, as each must
+ * scan at least PARALLEL_GRAIN matrix entries. delta = 0 uses the mean edge weight. A small
+ * delta does less redundant work and a large one exposes more parallelism per phase. A
+ * negative or non-finite delta throws illegal_argument, and one so small that the bucket
+ * numbers would not fit in a long long is raised to the smallest width that fits. */
+std::vector<double> Weighted_graph::distances(int m, int threads, double delta){
+    
+    // Throw exception if the arguments are incompatible.
+    if(m >= num_vertices || m < 0 || threads < 0 || !std::isfinite(delta) || delta < 0){
+        throw illegal_argument();
+    }
+    
+    if (threads == 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        threads = (threads > 0) ? threads : 1;
+    }
+    
+    if (delta == 0) {
+        delta = (num_edges > 0) ? edge_weight_sum/num_edges : 1;
+    }
+    
+    // A tentative distance is the length of a simple path, so at most edge_weight_sum, and
+    // the bucket numbers stay below 10^18 (a long long holds 9.2*10^18).
+    if (delta < edge_weight_sum/1e18) {
+        delta = edge_weight_sum/1e18;
+    }
+    
+    // The largest phase relaxes every vertex, which is all the team will ever be given.
+    long largest = static_cast<long>(num_vertices)*num_vertices/PARALLEL_GRAIN;
+    Thread_team team(static_cast<int>((largest < threads) ? ((largest > 0) ? largest : 1) : threads));
+    
+    std::vector<std::atomic<double> > tentative(num_vertices);
+    
+    for (int i = 0; i < num_vertices; ++i) {
+        tentative[i].store(INF, std::memory_order_relaxed);
+    }
+    
+    tentative[m].store(0, std::memory_order_relaxed);
+    
+    // The buckets are sparse, as distances may span many multiples of delta.
+    // queued[v] is the bucket v was last put in (stale entries elsewhere are skipped), or -1.
+    std::map<long long, std::vector<int> > buckets;
+    std::vector<long long> queued(num_vertices, -1);
+    std::vector<long long> settled_in(num_vertices, -1);
+    std::vector<std::vector<int> > improved(team.size());
+    
+    buckets[0].push_back(m);
+    queued[m] = 0;
+    
+    while (!buckets.empty()) {
+        long long current = buckets.begin()->first;
+        std::vector<int> settled;
+        
+        // Light edges can put vertices back into the current bucket.
+        while (buckets.count(current) != 0) {
+            std::vector<int> frontier;
+            
+            for (int v : buckets[current]) {
+                if (queued[v] == current) {
+                    queued[v] = -1;
+                    frontier.push_back(v);
+                    
+                    if (settled_in[v] != current) {
+                        settled_in[v] = current;
+                        settled.push_back(v);
+                    }
+                }
+            }
+            
+            buckets.erase(current);
+            relax(frontier, true, delta, tentative.data(), improved, team);
+            
+            for (int t = 0; t < team.size(); ++t) {
+                for (int v : improved[t]) {
+                    long long bucket = static_cast<long long>(std::floor(tentative[v].load(std::memory_order_relaxed)/delta));
+                    
+                    if (queued[v] != bucket) {
+                        queued[v] = bucket;
+                        buckets[bucket].push_back(v);
+                    }
+                }
+                
+                improved[t].clear();
+            }
+        }
+        
+        // The distances of the settled vertices are final, so heavy edges are relaxed once.
+        relax(settled, false, delta, tentative.data(), improved, team);
+        
+        for (int t = 0; t < team.size(); ++t) {
+            for (int v : improved[t]) {
+                long long bucket = static_cast<long long>(std::floor(tentative[v].load(std::memory_order_relaxed)/delta));
+                
+                if (queued[v] != bucket) {
+                    queued[v] = bucket;
+                    buckets[bucket].push_back(v);
+                }
+            }
+            
+            improved[t].clear();
+        }
+    }
+    
+    // Caching the results in the shortest_dist table, as distance() does.
+    if (empty) {
+        for (int i = 0; i < num_vertices; ++i) {
+            updated[i] = false;
+        }
+        
+        empty = false;
+    }
+    
+    std::vector<double> result(num_vertices);
+    
+    for (int i = 0; i < num_vertices; ++i) {
+        result[i] = tentative[i].load(std::memory_order_relaxed);
+        shortest_dist[m*num_vertices + i] = (result[i] == INF) ? -1 : result[i];
+        shortest_dist[i*num_vertices + m] = shortest_dist[m*num_vertices + i];
+    }
+    
+    updated[m] = true;
+    
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Spanning Trees & Connectivity                  //
+//////////////////////////////////////////////////////////////////////
+
+/* Returns a minimum spanning forest (one tree per connected component) with Kruskal's
+ * algorithm: the edges are sorted by weight and each one that joins two different trees of a
+ * union-find is kept. Each edge has m < n, and the edges come in increasing order of weight
+ * (ties broken by m, then n), which makes the forest unique. O(n^2 + E log E). */
+std::vector<Weighted_graph::Edge> Weighted_graph::minimum_spanning_tree() const{
+    std::vector<Edge> edges;
+    edges.reserve(num_edges);
+    
+    for (int m = 0; m < num_vertices; ++m) {
+        for (int n = m + 1; n < num_vertices; ++n) {
+            if (matrix[m*num_vertices + n] > 0) {
+                Edge edge = {m, n, matrix[m*num_vertices + n]};
+                edges.push_back(edge);
+            }
+        }
+    }
+    
+    std::sort(edges.begin(), edges.end(), lighter);
+    
+    std::vector<int> parent(num_vertices);
+    std::vector<int> size(num_vertices, 1);
+    std::vector<Edge> forest;
+    
+    for (int i = 0; i < num_vertices; ++i) {
+        parent[i] = i;
+    }
+    
+    for (std::size_t i = 0; i < edges.size() && static_cast<int>(forest.size()) < num_vertices - num_components; ++i) {
+        if (unite(parent.data(), size.data(), edges[i].m, edges[i].n)) {
+            forest.push_back(edges[i]);
+        }
+    }
+    
+    return forest;
+}
+
+/* Returns the same forest as minimum_spanning_tree(), in the same order, with Borůvka's
+ * algorithm. Each round, every vertex scans its row for its lightest edge leaving its tree,
+ * the vertices being split between up to threads threads (0 uses every hardware thread), and
+ * the lightest such edge of every tree is added. The number of trees at least halves each
+ * round, so there are at most log n rounds of O(n^2/threads) each. */
+std::vector<Weighted_graph::Edge> Weighted_graph::parallel_minimum_spanning_tree(int threads) const{
+    
+    if (threads < 0) {
+        throw illegal_argument();
+    }
+    
+    if (threads == 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        threads = (threads > 0) ? threads : 1;
+    }
+    
+    long work = static_cast<long>(num_vertices)*num_vertices;
+    int team = static_cast<int>((work/PARALLEL_GRAIN < threads) ? work/PARALLEL_GRAIN : threads);
+    team = (team > 0) ? team : 1;
+    int chunk = (num_vertices + team - 1)/team;
+    
+    std::vector<int> parent(num_vertices);
+    std::vector<int> size(num_vertices, 1);
+    std::vector<int> tree(num_vertices);
+    std::vector<Edge> cheapest(static_cast<std::size_t>(team)*num_vertices);
+    std::vector<Edge> forest;
+    Edge none = {-1, -1, INF};
+    
+    for (int i = 0; i < num_vertices; ++i) {
+        parent[i] = i;
+    }
+    
+    while (static_cast<int>(forest.size()) < num_vertices - num_components) {
+        for (int i = 0; i < num_vertices; ++i) {
+            tree[i] = find_root(parent.data(), i);
+        }
+        
+        std::fill(cheapest.begin(), cheapest.end(), none);
+        
+        // Thread t keeps the lightest edge leaving each tree in its own slice of cheapest.
+        auto scan_rows = [&](int t){
+            Edge *best = cheapest.data() + static_cast<std::size_t>(t)*num_vertices;
+            int last = ((t + 1)*chunk < num_vertices) ? (t + 1)*chunk : num_vertices;
+            
+            for (int u = t*chunk; u < last; ++u) {
+                double const *row = matrix + static_cast<long>(u)*num_vertices;
+                
+                for (int v = 0; v < num_vertices; ++v) {
+                    if (row[v] > 0 && tree[u] != tree[v]) {
+                        Edge edge = {(u < v) ? u : v, (u < v) ? v : u, row[v]};
+                        
+                        if (lighter(edge, best[tree[u]])) {
+                            best[tree[u]] = edge;
+                        }
+                    }
+                }
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        
+        for (int t = 1; t < team; ++t) {
+            workers.emplace_back(scan_rows, t);
+        }
+        
+        scan_rows(0);
+        
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        
+        // Two trees may pick the same edge; the union-find keeps it once.
+        for (int root = 0; root < num_vertices; ++root) {
+            Edge best = none;
+            
+            for (int t = 0; t < team; ++t) {
+                if (lighter(cheapest[static_cast<std::size_t>(t)*num_vertices + root], best)) {
+                    best = cheapest[static_cast<std::size_t>(t)*num_vertices + root];
+                }
+            }
+            
+            if (best.m != -1 && unite(parent.data(), size.data(), best.m, best.n)) {
+                forest.push_back(best);
+            }
+        }
+    }
+    
+    std::sort(forest.begin(), forest.end(), lighter);
+    
+    return forest;
+}
+
+/* Returns the label of the connected component of each vertex. Labels go from 0 to
+ * component_count() - 1, in the order of the components' smallest vertices. */
+std::vector<int> Weighted_graph::connected_components(){
+    std::vector<int> labels(num_vertices);
+    std::vector<int> root_label(num_vertices, -1);
+    int next_label = 0;
+    
+    for (int i = 0; i < num_vertices; ++i) {
+        int root = find_root(component_parent, i);
+        
+        if (root_label[root] == -1) {
+            root_label[root] = next_label++;
+        }
+        
+        labels[i] = root_label[root];
+    }
+    
+    return labels;
+}
+
+// Returns the number of connected components, kept up to date by every insertion. O(1).
+int Weighted_graph::component_count() const{
+    return num_components;
+}
+
+//////////////////////////////////////////////////////////////////////
+//                     Private Member Functions                     //
+//////////////////////////////////////////////////////////////////////
+
+/* Relaxes the light (weight <= delta) or heavy edges of the given vertices, splitting them
+ * between up to team.size() threads. Thread t appends the vertices whose distance it lowered
+ * to improved[t]; a vertex may be listed by several threads. */
+void Weighted_graph::relax(std::vector<int> const &sources, bool light, double delta, std::atomic<double> *tentative,
+                           std::vector<std::vector<int> > &improved, Thread_team &team) const{
+    
+    long work = static_cast<long>(sources.size())*num_vertices;
+    int count = static_cast<int>((work/PARALLEL_GRAIN < team.size()) ? work/PARALLEL_GRAIN : team.size());
+    count = (count > 0) ? count : 1;
+    std::size_t chunk = (sources.size() + count - 1)/count;
+    
+    std::function<void(int)> relax_chunk = [&](int t){
+        std::size_t last = (t + 1)*chunk < sources.size() ? (t + 1)*chunk : sources.size();
+        
+        for (std::size_t i = t*chunk; i < last; ++i) {
+            int u = sources[i];
+            double d = tentative[u].load(std::memory_order_relaxed);
+            double const *row = matrix + static_cast<long>(u)*num_vertices;
+            
+            for (int v = 0; v < num_vertices; ++v) {
+                // -1 is no edge and 0 the vertex itself.
+                if (row[v] <= 0 || (row[v] <= delta) != light) {
+                    continue;
+                }
+                
+                double candidate = d + row[v];
+                double current = tentative[v].load(std::memory_order_relaxed);
+                
+                while (candidate < current) {
+                    if (tentative[v].compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+                        improved[t].push_back(v);
+                        break;
+                    }
+                }
+            }
+        }
+    };
+    
+    team.run(count, relax_chunk);
+}
+
+// Writes the edge into the matrix. Returns false if it already had that weight.
+bool Weighted_graph::set_edge(int m, int n, double w){
+    
+    if (matrix[m*num_vertices + n] == w) {
+        return false;
+    }
+    
+    // Increment the number of edges and the vertices' degree whenever we create a new edge.
+    if (matrix[m*num_vertices +n] == -1) {
+        num_edges++;
+        vertice_degree_array[n] = vertice_degree_array[n] + 1;
+        vertice_degree_array[m] = vertice_degree_array[m] + 1;
+        edge_weight_sum += w;
+        
+        if (unite(component_parent, component_size, m, n)) {
+            num_components--;
+        }
+    } else {
+        edge_weight_sum += w - matrix[m*num_vertices + n];
+    }
+    
+    // Updating the matrix with the new edges.
+    matrix[m*num_vertices + n] = w;
+    matrix[n*num_vertices + m] = w;
+    
+    return true;
+}
+
+// Returns the root of v's tree in a union-find forest, halving the path on the way.
+int Weighted_graph::find_root(int *parent, int v){
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    
+    return v;
+}
+
+// Merges the trees of a and b, the smaller under the larger. Returns false if they were the same tree.
+bool Weighted_graph::unite(int *parent, int *size, int a, int b){
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    
+    if (a == b) {
+        return false;
+    }
+    
+    if (size[a] < size[b]) {
+        std::swap(a, b);
+    }
+    
+    parent[b] = a;
+    size[a] += size[b];
+    
+    return true;
+}
+
+// Orders edges by weight, then m, then n, so that no two distinct edges tie.
+bool Weighted_graph::lighter(Edge const &lhs, Edge const &rhs){
+    if (lhs.w != rhs.w) {
+        return lhs.w < rhs.w;
+    }
+    
+    return (lhs.m != rhs.m) ? lhs.m < rhs.m : lhs.n < rhs.n;
+}
+
+//////////////////////////////////////////////////////////////////////
+//                            Thread Team                           //
+//////////////////////////////////////////////////////////////////////
+
+// Starts size - 1 workers; the thread that calls run() is the last member of the team.
+Weighted_graph::Thread_team::Thread_team(int size):
+task(nullptr),
+active(1),
+pending(0),
+phase(0),
+stopping(false){
+    
+    try {
+        for (int t = 1; t < size; ++t) {
+            workers.emplace_back(&Thread_team::work, this, t);
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+Weighted_graph::Thread_team::~Thread_team(){
+    stop();
+}
+
+int Weighted_graph::Thread_team::size() const{
+    return static_cast<int>(workers.size()) + 1;
+}
+
+/* Runs job(0), ..., job(count - 1) at the same time, job(0) on the calling thread, and
+ * returns once they have all returned. A single job is run directly. */
+void Weighted_graph::Thread_team::run(int count, std::function<void(int)> const &job){
+    
+    if (count <= 1) {
+        job(0);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(team_mutex);
+        task = &job;
+        active = count;
+        pending = count - 1;
+        ++phase;
+    }
+    
+    work_ready.notify_all();
+    job(0);
+    
+    std::unique_lock<std::mutex> lock(team_mutex);
+    work_done.wait(lock, [this]{ return pending == 0; });
+}
+
+/* Worker t waits for each new phase and runs its job if the phase needs it. A phase cannot
+ * be replaced before its workers are done, so no worker misses one it is part of. */
+void Weighted_graph::Thread_team::work(int t){
+    unsigned long seen = 0;
+    
+    while (true) {
+        std::function<void(int)> const *job;
+        
+        {
+            std::unique_lock<std::mutex> lock(team_mutex);
+            work_ready.wait(lock, [&]{ return stopping || phase != seen; });
+            
+            if (stopping) {
+                return;
+            }
+            
+            seen = phase;
+            
+            if (t >= active) {
+                continue;
+            }
+            
+            job = task;
+        }
+        
+        (*job)(t);
+        
+        std::lock_guard<std::mutex> lock(team_mutex);
+        
+        if (--pending == 0) {
+            work_done.notify_one();
+        }
+    }
+}
+
+void Weighted_graph::Thread_team::stop(){
+    {
+        std::lock_guard<std::mutex> lock(team_mutex);
+        stopping = true;
+    }
+    
+    work_ready.notify_all();
+    
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+}
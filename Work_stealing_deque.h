@@ -0,0 +1,238 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <type_traits>
+#include "Epoch_reclamation.h"
+
+/* Work-stealing deque (Chase and Lev, "Dynamic circular work-stealing deque", with the memory
+ * orders of Lê, Pop, Cohen and Zappa Nardelli, "Correct and efficient work-stealing for weak
+ * memory models").
+ *
+ * One thread owns the deque and uses it as a stack: push_back and pop_back work on the
+ * bottom end without any compare-and-swap, except to race for the very last value. Any
+ * number of other threads take the oldest values with pop_front, which claims the top end
+ * with a compare-and-swap. The values live in a circular array that the owner doubles when
+ * it is full. Thieves may still be reading the old array, so it is retired to an
+ * Epoch_manager, and pop_front pins the epoch.
+ *
+ * Thieves read slots that the owner may be overwriting, so the slots are atomics and Type
+ * must be trivially copyable (a pointer or an index to the task, typically). */
+template <typename Type>
+class Work_stealing_deque {
+    static_assert( std::is_trivially_copyable<Type>::value, "Work_stealing_deque needs a trivially copyable type" );
+
+    private:
+        class Ring {
+            public:
+                long capacity;
+                std::atomic<Type> *slots;
+
+                Ring( long );
+                ~Ring();
+
+                Type get( long ) const;
+                void put( long, Type const & );
+                Ring *grow( long, long ) const;
+        };
+
+        // Kept on separate cache lines so that the owner and the thieves don't share one.
+        alignas( 64 ) std::atomic<long> deque_top;
+        alignas( 64 ) std::atomic<long> deque_bottom;
+        std::atomic<Ring *> ring;
+
+        Epoch_manager epochs;
+
+        static void delete_ring( void * );
+
+    public:
+        explicit Work_stealing_deque( int = 64 );
+        ~Work_stealing_deque();
+
+        Work_stealing_deque( Work_stealing_deque const & ) = delete;
+        Work_stealing_deque &operator=( Work_stealing_deque const & ) = delete;
+
+        bool empty() const;
+        int size() const;
+
+        // Owner only
+        void push_back( Type const & );
+        bool pop_back( Type & );
+
+        // Any thread
+        bool pop_front( Type & );
+};
+
+//////////////////////////////////////////////////////////////////////
+//                   Deque Public Member Functions                  //
+//////////////////////////////////////////////////////////////////////
+
+// The capacity is rounded up to a power of 2, as the array is indexed with a mask.
+template <typename Type>
+Work_stealing_deque<Type>::Work_stealing_deque( int initial_capacity ):
+deque_top( 0 ),
+deque_bottom( 0 ) {
+    if ( initial_capacity < 1 ) {
+        throw illegal_argument();
+    }
+
+    long capacity = 1;
+
+    while ( capacity < initial_capacity ) {
+        capacity *= 2;
+    }
+
+    ring.store( new Ring( capacity ) );
+}
+
+// No other thread may be using the deque.
+template <typename Type>
+Work_stealing_deque<Type>::~Work_stealing_deque() {
+    delete ring.load();
+}
+
+// Only a snapshot unless it is called by the owner while no thief is active.
+template <typename Type>
+bool Work_stealing_deque<Type>::empty() const {
+    return ( size() == 0 );
+}
+
+template <typename Type>
+int Work_stealing_deque<Type>::size() const {
+    long count = deque_bottom.load( std::memory_order_relaxed ) - deque_top.load( std::memory_order_relaxed );
+    return count > 0 ? static_cast<int>( count ) : 0;
+}
+
+// Pushes value on the bottom end. Only the owner may call it. Doubles the array when it is full.
+template <typename Type>
+void Work_stealing_deque<Type>::push_back( Type const &value ) {
+    long bottom = deque_bottom.load( std::memory_order_relaxed );
+    long top = deque_top.load( std::memory_order_acquire );
+    Ring *current = ring.load( std::memory_order_relaxed );
+
+    if ( bottom - top > current->capacity - 1 ) {
+        Ring *old = current;
+        current = old->grow( bottom, top );
+        ring.store( current, std::memory_order_release );
+
+        epochs.retire( old, delete_ring );
+        epochs.advance();
+        epochs.collect();
+    }
+
+    current->put( bottom, value );
+    std::atomic_thread_fence( std::memory_order_release );
+    deque_bottom.store( bottom + 1, std::memory_order_relaxed );
+}
+
+/* Pops the newest value into value. Only the owner may call it. Returns false (and leaves
+ * value unchanged) if the deque was empty or a thief took the last value first. */
+template <typename Type>
+bool Work_stealing_deque<Type>::pop_back( Type &value ) {
+    long bottom = deque_bottom.load( std::memory_order_relaxed ) - 1;
+    Ring *current = ring.load( std::memory_order_relaxed );
+
+    // Reserve the bottom value before looking at the top, so thieves see the reservation.
+    deque_bottom.store( bottom, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    long top = deque_top.load( std::memory_order_relaxed );
+
+    if ( top > bottom ) {
+        deque_bottom.store( bottom + 1, std::memory_order_relaxed );
+        return false;
+    }
+
+    Type last = current->get( bottom );
+
+    if ( top == bottom ) {
+        // The last value: race the thieves for it through the top end.
+        bool won = deque_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+        deque_bottom.store( bottom + 1, std::memory_order_relaxed );
+
+        if ( !won ) {
+            return false;
+        }
+    }
+
+    value = last;
+    return true;
+}
+
+/* Takes the oldest value into value. Any thread may call it. It retries while it loses races
+ * to other threads and returns false (leaving value unchanged) only if the deque was empty. */
+template <typename Type>
+bool Work_stealing_deque<Type>::pop_front( Type &value ) {
+    Epoch_manager::Guard guard = epochs.pin();
+
+    while ( true ) {
+        long top = deque_top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        long bottom = deque_bottom.load( std::memory_order_acquire );
+
+        if ( top >= bottom ) {
+            return false;
+        }
+
+        // The ring may be replaced right after this, but the old one keeps the value at top.
+        Type first = ring.load( std::memory_order_acquire )->get( top );
+
+        if ( deque_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+            value = first;
+            return true;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//                   Deque Private Member Functions                 //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+void Work_stealing_deque<Type>::delete_ring( void *old ) {
+    delete static_cast<Ring *>( old );
+}
+
+//////////////////////////////////////////////////////////////////////
+//                               Ring                               //
+//////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+Work_stealing_deque<Type>::Ring::Ring( long ring_capacity ):
+capacity( ring_capacity ),
+slots( new std::atomic<Type>[ring_capacity] ) {
+    // does nothing
+}
+
+template <typename Type>
+Work_stealing_deque<Type>::Ring::~Ring() {
+    delete[] slots;
+}
+
+// Indices grow without bound; capacity is a power of 2, so the mask wraps them.
+template <typename Type>
+Type Work_stealing_deque<Type>::Ring::get( long index ) const {
+    return slots[index & ( capacity - 1 )].load( std::memory_order_relaxed );
+}
+
+template <typename Type>
+void Work_stealing_deque<Type>::Ring::put( long index, Type const &value ) {
+    slots[index & ( capacity - 1 )].store( value, std::memory_order_relaxed );
+}
+
+// Returns a ring twice as large holding the values in [top, bottom) at the same indices.
+template <typename Type>
+typename Work_stealing_deque<Type>::Ring *Work_stealing_deque<Type>::Ring::grow( long bottom, long top ) const {
+    Ring *larger = new Ring( 2*capacity );
+
+    for ( long i = top; i < bottom; ++i ) {
+        larger->put( i, get( i ) );
+    }
+
+    return larger;
+}
+
+#endif
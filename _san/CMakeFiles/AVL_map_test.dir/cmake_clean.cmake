@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "AVL_map_test"
+  "AVL_map_test.pdb"
+  "CMakeFiles/AVL_map_test.dir/tests/AVL_map_test.cpp.o"
+  "CMakeFiles/AVL_map_test.dir/tests/AVL_map_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/AVL_map_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
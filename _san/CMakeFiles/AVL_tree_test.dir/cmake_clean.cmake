@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "AVL_tree_test"
+  "AVL_tree_test.pdb"
+  "CMakeFiles/AVL_tree_test.dir/tests/AVL_tree_test.cpp.o"
+  "CMakeFiles/AVL_tree_test.dir/tests/AVL_tree_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/AVL_tree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
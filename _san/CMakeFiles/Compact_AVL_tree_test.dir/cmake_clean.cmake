@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Compact_AVL_tree_test.dir/tests/Compact_AVL_tree_test.cpp.o"
+  "CMakeFiles/Compact_AVL_tree_test.dir/tests/Compact_AVL_tree_test.cpp.o.d"
+  "Compact_AVL_tree_test"
+  "Compact_AVL_tree_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Compact_AVL_tree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
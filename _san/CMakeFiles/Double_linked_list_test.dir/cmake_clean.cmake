@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Double_linked_list_test.dir/tests/Double_linked_list_test.cpp.o"
+  "CMakeFiles/Double_linked_list_test.dir/tests/Double_linked_list_test.cpp.o.d"
+  "Double_linked_list_test"
+  "Double_linked_list_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Double_linked_list_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
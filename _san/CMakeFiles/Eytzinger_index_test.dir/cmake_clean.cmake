@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Eytzinger_index_test.dir/tests/Eytzinger_index_test.cpp.o"
+  "CMakeFiles/Eytzinger_index_test.dir/tests/Eytzinger_index_test.cpp.o.d"
+  "Eytzinger_index_test"
+  "Eytzinger_index_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Eytzinger_index_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Intrusive_list_test.dir/tests/Intrusive_list_test.cpp.o"
+  "CMakeFiles/Intrusive_list_test.dir/tests/Intrusive_list_test.cpp.o.d"
+  "Intrusive_list_test"
+  "Intrusive_list_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Intrusive_list_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
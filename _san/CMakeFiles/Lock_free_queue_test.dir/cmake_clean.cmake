@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Lock_free_queue_test.dir/tests/Lock_free_queue_test.cpp.o"
+  "CMakeFiles/Lock_free_queue_test.dir/tests/Lock_free_queue_test.cpp.o.d"
+  "Lock_free_queue_test"
+  "Lock_free_queue_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Lock_free_queue_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
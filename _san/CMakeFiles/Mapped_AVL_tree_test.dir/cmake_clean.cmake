@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Mapped_AVL_tree_test.dir/tests/Mapped_AVL_tree_test.cpp.o"
+  "CMakeFiles/Mapped_AVL_tree_test.dir/tests/Mapped_AVL_tree_test.cpp.o.d"
+  "Mapped_AVL_tree_test"
+  "Mapped_AVL_tree_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Mapped_AVL_tree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Persistent_AVL_tree_test.dir/tests/Persistent_AVL_tree_test.cpp.o"
+  "CMakeFiles/Persistent_AVL_tree_test.dir/tests/Persistent_AVL_tree_test.cpp.o.d"
+  "Persistent_AVL_tree_test"
+  "Persistent_AVL_tree_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Persistent_AVL_tree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Profiling_hooks_test.dir/tests/Profiling_hooks_test.cpp.o"
+  "CMakeFiles/Profiling_hooks_test.dir/tests/Profiling_hooks_test.cpp.o.d"
+  "Profiling_hooks_test"
+  "Profiling_hooks_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Profiling_hooks_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
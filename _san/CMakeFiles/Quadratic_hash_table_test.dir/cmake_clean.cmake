@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Quadratic_hash_table_test.dir/tests/Quadratic_hash_table_test.cpp.o"
+  "CMakeFiles/Quadratic_hash_table_test.dir/tests/Quadratic_hash_table_test.cpp.o.d"
+  "Quadratic_hash_table_test"
+  "Quadratic_hash_table_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Quadratic_hash_table_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Tree_balance_test.dir/tests/Tree_balance_test.cpp.o"
+  "CMakeFiles/Tree_balance_test.dir/tests/Tree_balance_test.cpp.o.d"
+  "Tree_balance_test"
+  "Tree_balance_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Tree_balance_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Unrolled_linked_list_test.dir/tests/Unrolled_linked_list_test.cpp.o"
+  "CMakeFiles/Unrolled_linked_list_test.dir/tests/Unrolled_linked_list_test.cpp.o.d"
+  "Unrolled_linked_list_test"
+  "Unrolled_linked_list_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Unrolled_linked_list_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Weighted_graph_test.dir/tests/Weighted_graph_test.cpp.o"
+  "CMakeFiles/Weighted_graph_test.dir/tests/Weighted_graph_test.cpp.o.d"
+  "Weighted_graph_test"
+  "Weighted_graph_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Weighted_graph_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Work_stealing_deque_test.dir/tests/Work_stealing_deque_test.cpp.o"
+  "CMakeFiles/Work_stealing_deque_test.dir/tests/Work_stealing_deque_test.cpp.o.d"
+  "Work_stealing_deque_test"
+  "Work_stealing_deque_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Work_stealing_deque_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
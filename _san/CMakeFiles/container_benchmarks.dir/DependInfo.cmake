@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/benchmarks/AVL_map_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_map_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_map_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/AVL_tree_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_tree_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_tree_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Compact_AVL_tree_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Compact_AVL_tree_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Compact_AVL_tree_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Double_linked_list_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Double_linked_list_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Double_linked_list_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Lock_free_queue_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Lock_free_queue_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Lock_free_queue_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Persistent_AVL_tree_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Persistent_AVL_tree_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Persistent_AVL_tree_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Quadratic_hash_table_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Quadratic_hash_table_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Quadratic_hash_table_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Tree_balance_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Tree_balance_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Tree_balance_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/Weighted_graph_benchmark.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/Weighted_graph_benchmark.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/Weighted_graph_benchmark.cpp.o.d"
+  "/root/repo/benchmarks/benchmark_main.cpp" "CMakeFiles/container_benchmarks.dir/benchmarks/benchmark_main.cpp.o" "gcc" "CMakeFiles/container_benchmarks.dir/benchmarks/benchmark_main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
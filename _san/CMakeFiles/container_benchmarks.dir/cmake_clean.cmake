@@ -0,0 +1,29 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_map_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_map_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_tree_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/AVL_tree_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Compact_AVL_tree_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Compact_AVL_tree_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Double_linked_list_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Double_linked_list_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Lock_free_queue_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Lock_free_queue_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Persistent_AVL_tree_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Persistent_AVL_tree_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Quadratic_hash_table_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Quadratic_hash_table_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Tree_balance_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Tree_balance_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Weighted_graph_benchmark.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/Weighted_graph_benchmark.cpp.o.d"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/benchmark_main.cpp.o"
+  "CMakeFiles/container_benchmarks.dir/benchmarks/benchmark_main.cpp.o.d"
+  "container_benchmarks"
+  "container_benchmarks.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/container_benchmarks.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
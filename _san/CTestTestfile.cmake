@@ -0,0 +1,38 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_san
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(AVL_tree_test "/root/repo/_san/AVL_tree_test")
+set_tests_properties(AVL_tree_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;34;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(AVL_map_test "/root/repo/_san/AVL_map_test")
+set_tests_properties(AVL_map_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;35;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Compact_AVL_tree_test "/root/repo/_san/Compact_AVL_tree_test")
+set_tests_properties(Compact_AVL_tree_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;36;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Double_linked_list_test "/root/repo/_san/Double_linked_list_test")
+set_tests_properties(Double_linked_list_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;37;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Eytzinger_index_test "/root/repo/_san/Eytzinger_index_test")
+set_tests_properties(Eytzinger_index_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;38;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Intrusive_list_test "/root/repo/_san/Intrusive_list_test")
+set_tests_properties(Intrusive_list_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;39;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Lock_free_queue_test "/root/repo/_san/Lock_free_queue_test")
+set_tests_properties(Lock_free_queue_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;40;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Mapped_AVL_tree_test "/root/repo/_san/Mapped_AVL_tree_test")
+set_tests_properties(Mapped_AVL_tree_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;41;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Persistent_AVL_tree_test "/root/repo/_san/Persistent_AVL_tree_test")
+set_tests_properties(Persistent_AVL_tree_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;42;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Profiling_hooks_test "/root/repo/_san/Profiling_hooks_test")
+set_tests_properties(Profiling_hooks_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;43;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Quadratic_hash_table_test "/root/repo/_san/Quadratic_hash_table_test")
+set_tests_properties(Quadratic_hash_table_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;44;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Tree_balance_test "/root/repo/_san/Tree_balance_test")
+set_tests_properties(Tree_balance_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;45;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Unrolled_linked_list_test "/root/repo/_san/Unrolled_linked_list_test")
+set_tests_properties(Unrolled_linked_list_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;46;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Weighted_graph_test "/root/repo/_san/Weighted_graph_test")
+set_tests_properties(Weighted_graph_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;47;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(Work_stealing_deque_test "/root/repo/_san/Work_stealing_deque_test")
+set_tests_properties(Work_stealing_deque_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;31;add_test;/root/repo/CMakeLists.txt;48;add_container_test;/root/repo/CMakeLists.txt;0;")
+add_test(container_benchmarks_quick "/root/repo/_san/container_benchmarks" "--quick" "--json" "/root/repo/_san/benchmarks_quick.json")
+set_tests_properties(container_benchmarks_quick PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;85;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,57 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <map>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "AVL_map.h"
+
+// operator[] on missing keys (insertions) and then on present keys, against std::map.
+BENCHMARK( avl_map_subscript ) {
+    long n = bench.size( 1000000 );
+
+    bench.measure( "AVL_map::operator[] miss", n, n, [&] {
+        AVL_map<long, long> map;
+
+        for ( long i = 0; i < n; ++i ) {
+            map[( i*7919 )%n] = i;
+        }
+    } );
+
+    bench.measure( "std::map::operator[] miss", n, n, [&] {
+        std::map<long, long> map;
+
+        for ( long i = 0; i < n; ++i ) {
+            map[( i*7919 )%n] = i;
+        }
+    } );
+
+    AVL_map<long, long> map;
+    std::map<long, long> reference;
+
+    for ( long i = 0; i < n; ++i ) {
+        map[i] = i;
+        reference[i] = i;
+    }
+
+    bench.measure( "AVL_map::operator[] hit", n, n, [&] {
+        long sum = 0;
+
+        for ( long i = 0; i < n; ++i ) {
+            sum += map[( i*7919 )%n];
+        }
+
+        Benchmark::keep( sum );
+    } );
+
+    bench.measure( "std::map::operator[] hit", n, n, [&] {
+        long sum = 0;
+
+        for ( long i = 0; i < n; ++i ) {
+            sum += reference[( i*7919 )%n];
+        }
+
+        Benchmark::keep( sum );
+    } );
+}
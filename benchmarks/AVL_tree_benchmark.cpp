@@ -0,0 +1,249 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "Key_distributions.h"
+#include "AVL_tree.h"
+
+namespace {
+    std::vector<int> shuffled( long n ) {
+        std::vector<int> values( n );
+
+        for ( long i = 0; i < n; ++i ) {
+            values[i] = static_cast<int>( i );
+        }
+
+        std::shuffle( values.begin(), values.end(), std::mt19937( 42 ) );
+        return values;
+    }
+
+    // Keys of 200 characters, so that copying one costs far more than relinking a node.
+    std::vector<std::string> heavy_keys( long n ) {
+        std::vector<int> order = shuffled( n );
+        std::vector<std::string> keys( n );
+
+        for ( long i = 0; i < n; ++i ) {
+            keys[i] = std::to_string( 1000000000 + order[i] ) + std::string( 190, 'k' );
+        }
+
+        return keys;
+    }
+
+    // The adversarial keys alternate between the two ends of the range, so that every insert
+    // lands at the bottom of one of the two spines and rebalances it.
+    std::vector<int> tree_keys( Key_distribution distribution, long n, unsigned seed ) {
+        switch ( distribution ) {
+            case Key_distribution::UNIFORM:
+                return uniform_keys( n, n, seed );
+            case Key_distribution::ZIPF:
+                return zipf_keys( n, n, seed );
+            case Key_distribution::SEQUENTIAL:
+                return sequential_keys( n );
+            default: {
+                std::vector<int> keys( n );
+
+                for ( long i = 0; i < n; ++i ) {
+                    keys[i] = static_cast<int>( ( i%2 == 0 ) ? i/2 : n - 1 - i/2 );
+                }
+
+                return keys;
+            }
+        }
+    }
+}
+
+// Insert, find and erase of random keys through the iterative paths, against std::set.
+BENCHMARK( avl_tree_operations ) {
+    long n = bench.size( 1000000 );
+    std::vector<int> values = shuffled( n );
+
+    bench.measure( "AVL_tree::insert", n, n, [&] {
+        AVL_tree<int> tree;
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( values[i] );
+        }
+    } );
+
+    bench.measure( "std::set::insert", n, n, [&] {
+        std::set<int> tree;
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( values[i] );
+        }
+    } );
+
+    AVL_tree<int> tree;
+    std::set<int> reference( values.begin(), values.end() );
+
+    for ( long i = 0; i < n; ++i ) {
+        tree.insert( values[i] );
+    }
+
+    bench.measure( "AVL_tree::find", n, n, [&] {
+        long found = 0;
+
+        for ( long i = 0; i < n; ++i ) {
+            found += ( tree.find( values[i] ) != tree.end() );
+        }
+
+        Benchmark::keep( found );
+    } );
+
+    bench.measure( "std::set::find", n, n, [&] {
+        long found = 0;
+
+        for ( long i = 0; i < n; ++i ) {
+            found += ( reference.find( values[i] ) != reference.end() );
+        }
+
+        Benchmark::keep( found );
+    } );
+
+    // Erasing everything and inserting it back keeps every repetition alike.
+    bench.measure( "AVL_tree::erase+insert", n, 2*n, [&] {
+        for ( long i = 0; i < n; ++i ) {
+            tree.erase( values[i] );
+        }
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( values[i] );
+        }
+    } );
+}
+
+// Heavy values: copying insert against moving insert, and erase with node relinking.
+BENCHMARK( avl_tree_heavy_values ) {
+    long n = bench.size( 200000 );
+    std::vector<std::string> keys = heavy_keys( n );
+    std::vector<std::string> copies;
+
+    bench.measure( "AVL_tree<string>::insert(copy)", n, n, [&] {
+        AVL_tree<std::string> tree;
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( keys[i] );
+        }
+    } );
+
+    // The strings to move from are copied by the setup, outside the timing.
+    bench.measure( "AVL_tree<string>::insert(move)", n, n, [&] {
+        copies = keys;
+    }, [&] {
+        AVL_tree<std::string> tree;
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( std::move( copies[i] ) );
+        }
+    } );
+
+    bench.measure( "std::set<string>::insert(move)", n, n, [&] {
+        copies = keys;
+    }, [&] {
+        std::set<std::string> tree;
+
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( std::move( copies[i] ) );
+        }
+    } );
+
+    AVL_tree<std::string> tree;
+    std::set<std::string> reference;
+
+    // Every node is extracted and inserted back, so no value is ever copied.
+    bench.measure( "AVL_tree<string>::extract+insert", n, 2*n, [&] {
+        if ( tree.empty() ) {
+            for ( long i = 0; i < n; ++i ) {
+                tree.insert( keys[i] );
+            }
+        }
+    }, [&] {
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( tree.extract( keys[i] ) );
+        }
+    } );
+
+    bench.measure( "AVL_tree<string>::erase", n, n, [&] {
+        for ( long i = 0; i < n; ++i ) {
+            tree.insert( keys[i] );
+        }
+    }, [&] {
+        for ( long i = 0; i < n; ++i ) {
+            tree.erase( keys[i] );
+        }
+    } );
+
+    bench.measure( "std::set<string>::erase", n, n, [&] {
+        reference.insert( keys.begin(), keys.end() );
+    }, [&] {
+        for ( long i = 0; i < n; ++i ) {
+            reference.erase( keys[i] );
+        }
+    } );
+}
+
+// Insert and find under every key distribution and size, against std::set.
+BENCHMARK( avl_tree_distributions ) {
+    std::vector<long> sizes = bench.sizes( 100000000 );
+
+    for ( std::size_t i = 0; i < sizes.size(); ++i ) {
+        long n = sizes[i];
+
+        for ( Key_distribution distribution : KEY_DISTRIBUTIONS ) {
+            std::string suffix = std::string( "/" ) + distribution_name( distribution );
+            std::vector<int> inserted = tree_keys( distribution, n, 42 );
+            std::vector<int> searched = tree_keys( distribution, n, 43 );
+
+            {
+                AVL_tree<int> tree;
+
+                bench.measure( "AVL_tree::insert" + suffix, n, n, [&] {
+                    tree.clear();
+                }, [&] {
+                    for ( long j = 0; j < n; ++j ) {
+                        tree.insert( inserted[j] );
+                    }
+                } );
+
+                bench.measure( "AVL_tree::find" + suffix, n, n, [&] {
+                    long found = 0;
+
+                    for ( long j = 0; j < n; ++j ) {
+                        found += ( tree.find( searched[j] ) != tree.end() );
+                    }
+
+                    Benchmark::keep( found );
+                } );
+            }
+
+            {
+                std::set<int> reference;
+
+                bench.measure( "std::set::insert" + suffix, n, n, [&] {
+                    reference.clear();
+                }, [&] {
+                    for ( long j = 0; j < n; ++j ) {
+                        reference.insert( inserted[j] );
+                    }
+                } );
+
+                bench.measure( "std::set::find" + suffix, n, n, [&] {
+                    long found = 0;
+
+                    for ( long j = 0; j < n; ++j ) {
+                        found += ( reference.find( searched[j] ) != reference.end() );
+                    }
+
+                    Benchmark::keep( found );
+                } );
+            }
+        }
+    }
+}
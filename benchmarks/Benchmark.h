@@ -0,0 +1,193 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Minimal benchmark driver shared by every container. A benchmark is a function registered
+ * with BENCHMARK( name ) that times code through Benchmark::measure; benchmark_main.cpp runs
+ * them and prints every measurement as JSON.
+ *
+ *     BENCHMARK( avl_tree_insert ) {
+ *         long n = bench.size( 1000000 );
+ *         bench.measure( "AVL_tree::insert", n, n, [&] { ... } );
+ *     }
+ *
+ * measure runs the body repetitions() times and keeps the fastest run, reported as
+ * nanoseconds per operation. Anything the body builds is timed too, so bodies build their
+ * containers themselves when construction is part of the operation, and measure separately
+ * otherwise; state that each run consumes is rebuilt by a setup function, which is not timed.
+ * --quick shrinks the sizes and thread counts so that ctest can run the suite as a smoke
+ * test, and --max-size bounds the problem sizes returned by sizes(). */
+class Benchmark {
+    public:
+        typedef void ( *Function )( Benchmark & );
+
+        struct Result {
+            std::string name;
+            long n;                    // Problem size.
+            int threads;
+            double ns_per_operation;
+            double seconds;            // Fastest run.
+            std::vector<std::pair<std::string, double> > metrics;    // Extra figures, see annotate.
+        };
+
+    private:
+        std::vector<Result> measured;
+        bool quick_run;
+        int max_thread_count;
+        long max_problem_size;
+
+    public:
+        Benchmark( bool quick, int max_threads, long max_size );
+
+        long size( long ) const;
+        std::vector<long> sizes( long ) const;
+        int repetitions() const;
+        std::vector<int> thread_counts( int ) const;
+        std::vector<Result> const &results() const;
+
+        template <typename Body>
+        void measure( std::string const &name, long n, long operations, Body body, int threads = 1 );
+        template <typename Setup, typename Body>
+        void measure( std::string const &name, long n, long operations, Setup setup, Body body, int threads = 1 );
+        void annotate( std::string const &metric, double value );
+
+        static std::vector<std::pair<char const *, Function> > &registry();
+
+        // Keeps a result alive so that the compiler cannot drop the work that produced it.
+        template <typename Type>
+        static void keep( Type const & );
+
+        class Registrar {
+            public:
+                Registrar( char const *, Function );
+        };
+};
+
+#define BENCHMARK( name ) \
+    static void name( Benchmark & ); \
+    static Benchmark::Registrar name##_registrar( #name, name ); \
+    static void name( Benchmark &bench )
+
+//////////////////////////////////////////////////////////////////////
+//                             Benchmark                            //
+//////////////////////////////////////////////////////////////////////
+
+inline Benchmark::Benchmark( bool quick, int max_threads, long max_size ):
+quick_run( quick ),
+max_thread_count( max_threads ),
+max_problem_size( max_size ) {
+    // does nothing
+}
+
+// Sizes are divided by 100 (but kept above 100) in a quick run.
+inline long Benchmark::size( long n ) const {
+    if ( !quick_run ) {
+        return n;
+    }
+
+    return ( n/100 > 100 ) ? n/100 : ( ( n < 100 ) ? n : 100 );
+}
+
+// Powers of 10 from 10^3 up to limit, capped by --max-size (and by 10^3 in a quick run).
+inline std::vector<long> Benchmark::sizes( long limit ) const {
+    std::vector<long> counts;
+    long cap = ( limit < max_problem_size ) ? limit : max_problem_size;
+
+    if ( quick_run && cap > 1000 ) {
+        cap = 1000;
+    }
+
+    for ( long n = 1000; n <= cap; n *= 10 ) {
+        counts.push_back( n );
+    }
+
+    return counts;
+}
+
+inline int Benchmark::repetitions() const {
+    return quick_run ? 1 : 5;
+}
+
+// Powers of 2 from 1 up to limit, capped by --max-threads (and by 4 in a quick run).
+inline std::vector<int> Benchmark::thread_counts( int limit ) const {
+    std::vector<int> counts;
+    int cap = ( limit < max_thread_count ) ? limit : max_thread_count;
+
+    if ( quick_run && cap > 4 ) {
+        cap = 4;
+    }
+
+    for ( int threads = 1; threads <= cap; threads *= 2 ) {
+        counts.push_back( threads );
+    }
+
+    return counts;
+}
+
+inline std::vector<Benchmark::Result> const &Benchmark::results() const {
+    return measured;
+}
+
+// Adds a figure other than the time (a height, rotations per operation...) to the last result.
+inline void Benchmark::annotate( std::string const &metric, double value ) {
+    if ( !measured.empty() ) {
+        measured.back().metrics.push_back( std::make_pair( metric, value ) );
+    }
+}
+
+template <typename Body>
+void Benchmark::measure( std::string const &name, long n, long operations, Body body, int threads ) {
+    measure( name, n, operations, [] {}, body, threads );
+}
+
+// Calls setup before every run of the body, outside the timing.
+template <typename Setup, typename Body>
+void Benchmark::measure( std::string const &name, long n, long operations, Setup setup, Body body, int threads ) {
+    double best = 0;
+
+    for ( int i = 0; i < repetitions(); ++i ) {
+        setup();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+        if ( i == 0 || seconds < best ) {
+            best = seconds;
+        }
+    }
+
+    Result result = {name, n, threads, ( operations > 0 ) ? best*1e9/operations : 0, best, {}};
+    measured.push_back( result );
+}
+
+// Function-local static, so that registrations from any translation unit come first.
+inline std::vector<std::pair<char const *, Benchmark::Function> > &Benchmark::registry() {
+    static std::vector<std::pair<char const *, Function> > functions;
+    return functions;
+}
+
+// The empty asm statement claims to read value and all of memory, which the optimizer must honour.
+template <typename Type>
+void Benchmark::keep( Type const &value ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+    asm volatile( "" : : "r"( &value ) : "memory" );
+#else
+    static Type const *volatile sink;
+    sink = &value;
+    static_cast<void>( sink );
+#endif
+}
+
+inline Benchmark::Registrar::Registrar( char const *name, Function function ) {
+    registry().push_back( std::make_pair( name, function ) );
+}
+
+#endif
@@ -0,0 +1,149 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "AVL_tree.h"
+#include "Compact_AVL_tree.h"
+
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ( 2, 33 )
+#include <malloc.h>
+#define HAVE_MALLINFO2
+#endif
+#endif
+
+/* Compact_AVL_tree against AVL_tree on random int keys. Besides the time per operation, the
+ * insert results give the heap bytes per value that a tree of n values holds, as malloc sees
+ * them (with glibc 2.33 or later; elsewhere the figure is left out). A Compact_AVL_tree<int>
+ * node is 12 bytes and an AVL_tree<int> node 48; the pool of a Compact_AVL_tree that was not
+ * reserved may be up to twice as large as its nodes. */
+namespace {
+    std::vector<int> shuffled( long n ) {
+        std::vector<int> values( n );
+
+        for ( long i = 0; i < n; ++i ) {
+            values[i] = static_cast<int>( i );
+        }
+
+        std::shuffle( values.begin(), values.end(), std::mt19937( 32 ) );
+        return values;
+    }
+
+    // Returns the bytes allocated from the heap and not yet freed, or -1 if unknown.
+    long heap_bytes() {
+#ifdef HAVE_MALLINFO2
+        struct mallinfo2 info = mallinfo2();
+        return static_cast<long>( info.uordblks + info.hblkhd );
+#else
+        return -1;
+#endif
+    }
+
+    /* Annotates the last result with the heap bytes per value of a tree of n values. build
+     * builds the tree and returns heap_bytes() while the tree is still alive. */
+    template <typename Build>
+    void annotate_bytes( Benchmark &bench, long n, Build build ) {
+        long before = heap_bytes();
+
+        if ( before >= 0 ) {
+            bench.annotate( "bytes_per_value", static_cast<double>( build() - before )/n );
+        }
+    }
+
+    template <typename Tree>
+    void insert_all( Tree &tree, std::vector<int> const &values ) {
+        for ( std::size_t i = 0; i < values.size(); ++i ) {
+            tree.insert( values[i] );
+        }
+    }
+
+    template <typename Tree>
+    long find_all( Tree &tree, std::vector<int> const &values ) {
+        long found = 0;
+
+        for ( std::size_t i = 0; i < values.size(); ++i ) {
+            found += ( tree.find( values[i] ) != tree.end() );
+        }
+
+        return found;
+    }
+
+    // Erasing everything and inserting it back keeps every repetition alike.
+    template <typename Tree>
+    void erase_and_insert_all( Tree &tree, std::vector<int> const &values ) {
+        for ( std::size_t i = 0; i < values.size(); ++i ) {
+            tree.erase( values[i] );
+        }
+
+        insert_all( tree, values );
+    }
+}
+
+BENCHMARK( compact_avl_tree_operations ) {
+    std::vector<long> counts = bench.sizes( 10000000 );
+
+    for ( std::size_t c = 0; c < counts.size(); ++c ) {
+        long n = counts[c];
+        std::vector<int> values = shuffled( n );
+
+        bench.measure( "Compact_AVL_tree::insert", n, n, [&] {
+            Compact_AVL_tree<int> tree;
+            insert_all( tree, values );
+        } );
+        annotate_bytes( bench, n, [&] {
+            Compact_AVL_tree<int> tree;
+            insert_all( tree, values );
+            return heap_bytes();
+        } );
+
+        bench.measure( "Compact_AVL_tree::insert (reserved)", n, n, [&] {
+            Compact_AVL_tree<int> tree;
+            tree.reserve( static_cast<int>( n ) );
+            insert_all( tree, values );
+        } );
+        annotate_bytes( bench, n, [&] {
+            Compact_AVL_tree<int> tree;
+            tree.reserve( static_cast<int>( n ) );
+            insert_all( tree, values );
+            return heap_bytes();
+        } );
+
+        bench.measure( "AVL_tree::insert", n, n, [&] {
+            AVL_tree<int> tree;
+            insert_all( tree, values );
+        } );
+        annotate_bytes( bench, n, [&] {
+            AVL_tree<int> tree;
+            insert_all( tree, values );
+            return heap_bytes();
+        } );
+
+        Compact_AVL_tree<int> compact;
+        AVL_tree<int> tree;
+        insert_all( compact, values );
+        insert_all( tree, values );
+
+        bench.measure( "Compact_AVL_tree::find", n, n, [&] {
+            Benchmark::keep( find_all( compact, values ) );
+        } );
+
+        bench.measure( "AVL_tree::find", n, n, [&] {
+            Benchmark::keep( find_all( tree, values ) );
+        } );
+
+        bench.measure( "Compact_AVL_tree::erase+insert", n, 2*n, [&] {
+            erase_and_insert_all( compact, values );
+        } );
+
+        bench.measure( "AVL_tree::erase+insert", n, 2*n, [&] {
+            erase_and_insert_all( tree, values );
+        } );
+    }
+}
@@ -0,0 +1,202 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "Key_distributions.h"
+#include "Double_linked_list.h"
+
+namespace {
+    // A 256-byte value, expensive to copy and trivially destructible.
+    struct Large {
+        long words[32];
+
+        explicit Large( long value = 0 ) {
+            for ( int i = 0; i < 32; ++i ) {
+                words[i] = value + i;
+            }
+        }
+    };
+
+    long sum_first_words( Double_linked_list<Large> const &list ) {
+        long sum = 0;
+
+        for ( Double_linked_list<Large>::Double_node *node = list.begin(); node != list.end(); node = node->next() ) {
+            sum += node->value().words[0];
+        }
+
+        return sum;
+    }
+}
+
+/* Building, copying, moving and walking lists of 256-byte values and of 200-character
+ * strings, against std::list. Walking reads the values through references. */
+BENCHMARK( double_linked_list_large_values ) {
+    long n = bench.size( 200000 );
+
+    bench.measure( "Double_linked_list<Large>::emplace_back", n, n, [&] {
+        Double_linked_list<Large> list;
+
+        for ( long i = 0; i < n; ++i ) {
+            list.emplace_back( i );
+        }
+    } );
+
+    bench.measure( "std::list<Large>::emplace_back", n, n, [&] {
+        std::list<Large> list;
+
+        for ( long i = 0; i < n; ++i ) {
+            list.emplace_back( i );
+        }
+    } );
+
+    Double_linked_list<Large> large;
+    std::list<Large> reference;
+
+    for ( long i = 0; i < n; ++i ) {
+        large.emplace_back( i );
+        reference.emplace_back( i );
+    }
+
+    bench.measure( "Double_linked_list<Large> copy", n, n, [&] {
+        Double_linked_list<Large> copy( large );
+        Benchmark::keep( copy.size() );
+    } );
+
+    bench.measure( "std::list<Large> copy", n, n, [&] {
+        std::list<Large> copy( reference );
+        Benchmark::keep( copy.size() );
+    } );
+
+    // A move and a move back per operation, so the list is in place for the next repetition.
+    long const moves = bench.size( 1000000 );
+
+    bench.measure( "Double_linked_list<Large> move", n, 2*moves, [&] {
+        for ( long i = 0; i < moves; ++i ) {
+            Double_linked_list<Large> moved( std::move( large ) );
+            large = std::move( moved );
+        }
+    } );
+
+    bench.measure( "Double_linked_list<Large> walk", n, n, [&] {
+        Benchmark::keep( sum_first_words( large ) );
+    } );
+
+    Double_linked_list<std::string> strings;
+    std::list<std::string> reference_strings;
+
+    for ( long i = 0; i < n; ++i ) {
+        strings.emplace_back( 200, static_cast<char>( 'a' + i%26 ) );
+        reference_strings.emplace_back( 200, static_cast<char>( 'a' + i%26 ) );
+    }
+
+    bench.measure( "Double_linked_list<string> copy", n, n, [&] {
+        Double_linked_list<std::string> copy( strings );
+        Benchmark::keep( copy.size() );
+    } );
+
+    bench.measure( "std::list<string> copy", n, n, [&] {
+        std::list<std::string> copy( reference_strings );
+        Benchmark::keep( copy.size() );
+    } );
+}
+
+/* Push, find and pop under every key distribution and size, against std::list. The lists
+ * hold 0, 1, ..., n - 1 in order, so a find scans as many nodes as the key's value: the
+ * sequential keys are searched in list order, and the adversarial keys are all missing and
+ * scan the whole list. The finds are capped so that a run scans at most about 10^8 nodes. */
+BENCHMARK( double_linked_list_distributions ) {
+    std::vector<long> sizes = bench.sizes( 100000000 );
+
+    for ( std::size_t i = 0; i < sizes.size(); ++i ) {
+        long n = sizes[i];
+        long finds = std::max( 1L, std::min( n, 100000000/n ) );
+
+        Double_linked_list<int> list;
+        std::list<int> reference;
+
+        bench.measure( "Double_linked_list::push_back", n, n, [&] {
+            while ( !list.empty() ) {
+                list.pop_front();
+            }
+        }, [&] {
+            for ( long j = 0; j < n; ++j ) {
+                list.push_back( static_cast<int>( j ) );
+            }
+        } );
+
+        bench.measure( "std::list::push_back", n, n, [&] {
+            reference.clear();
+        }, [&] {
+            for ( long j = 0; j < n; ++j ) {
+                reference.push_back( static_cast<int>( j ) );
+            }
+        } );
+
+        for ( Key_distribution distribution : KEY_DISTRIBUTIONS ) {
+            std::string suffix = std::string( "/" ) + distribution_name( distribution );
+            std::vector<int> searched;
+
+            switch ( distribution ) {
+                case Key_distribution::UNIFORM:
+                    searched = uniform_keys( finds, n );
+                    break;
+                case Key_distribution::ZIPF:
+                    searched = zipf_keys( finds, n );
+                    break;
+                case Key_distribution::SEQUENTIAL:
+                    searched = sequential_keys( finds );
+                    break;
+                default:
+                    searched = std::vector<int>( finds, static_cast<int>( n ) );
+                    break;
+            }
+
+            bench.measure( "Double_linked_list::find" + suffix, n, finds, [&] {
+                long found = 0;
+
+                for ( long j = 0; j < finds; ++j ) {
+                    found += ( list.find( searched[j] ) != list.end() );
+                }
+
+                Benchmark::keep( found );
+            } );
+
+            bench.measure( "std::list::find" + suffix, n, finds, [&] {
+                long found = 0;
+
+                for ( long j = 0; j < finds; ++j ) {
+                    found += ( std::find( reference.begin(), reference.end(), searched[j] ) != reference.end() );
+                }
+
+                Benchmark::keep( found );
+            } );
+        }
+
+        bench.measure( "Double_linked_list::pop_front", n, n, [&] {
+            while ( static_cast<long>( list.size() ) < n ) {
+                list.push_back( 0 );
+            }
+        }, [&] {
+            for ( long j = 0; j < n; ++j ) {
+                list.pop_front();
+            }
+        } );
+
+        bench.measure( "std::list::pop_front", n, n, [&] {
+            while ( static_cast<long>( reference.size() ) < n ) {
+                reference.push_back( 0 );
+            }
+        }, [&] {
+            for ( long j = 0; j < n; ++j ) {
+                reference.pop_front();
+            }
+        } );
+    }
+}
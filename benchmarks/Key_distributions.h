@@ -0,0 +1,104 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef KEY_DISTRIBUTIONS_H
+#define KEY_DISTRIBUTIONS_H
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+/* The key distributions the containers are measured under. Every generator returns count
+ * keys in [0, n) and is seeded, so that runs are repeatable:
+ *  - UNIFORM: drawn uniformly at random, with repetitions.
+ *  - ZIPF: drawn from a Zipf distribution of exponent 0.99, so that a few hot keys make up
+ *    most of the draws. The hot keys are scattered over [0, n) instead of being the smallest.
+ *  - SEQUENTIAL: 0, 1, 2, ... in order.
+ *  - ADVERSARIAL: the worst case of each container, built by its own benchmark. */
+enum class Key_distribution { UNIFORM, ZIPF, SEQUENTIAL, ADVERSARIAL };
+
+static Key_distribution const KEY_DISTRIBUTIONS[] = {
+    Key_distribution::UNIFORM, Key_distribution::ZIPF,
+    Key_distribution::SEQUENTIAL, Key_distribution::ADVERSARIAL
+};
+
+inline char const *distribution_name( Key_distribution distribution ) {
+    switch ( distribution ) {
+        case Key_distribution::UNIFORM:
+            return "uniform";
+        case Key_distribution::ZIPF:
+            return "zipf";
+        case Key_distribution::SEQUENTIAL:
+            return "sequential";
+        default:
+            return "adversarial";
+    }
+}
+
+inline std::vector<int> uniform_keys( long count, long n, unsigned seed = 42 ) {
+    std::mt19937_64 generator( seed );
+    std::uniform_int_distribution<long> key( 0, n - 1 );
+    std::vector<int> keys( count );
+
+    for ( long i = 0; i < count; ++i ) {
+        keys[i] = static_cast<int>( key( generator ) );
+    }
+
+    return keys;
+}
+
+/* Draws the ranks with the method of Gray et al., "Quickly generating billion-record
+ * synthetic databases", which takes O(1) per key after an O(n) sum, so that n can reach
+ * 10^8 without a table of probabilities. Rank r is then mapped to key r*2654435761 mod n,
+ * a bijection whenever n is not a multiple of that (prime) factor. */
+inline std::vector<int> zipf_keys( long count, long n, unsigned seed = 42 ) {
+    double const theta = 0.99;
+    double zeta_n = 0;
+
+    for ( long i = 1; i <= n; ++i ) {
+        zeta_n += 1/std::pow( static_cast<double>( i ), theta );
+    }
+
+    double zeta_2 = 1 + 1/std::pow( 2.0, theta );
+    double alpha = 1/( 1 - theta );
+    double eta = ( 1 - std::pow( 2.0/n, 1 - theta ) )/( 1 - zeta_2/zeta_n );
+
+    std::mt19937_64 generator( seed );
+    std::uniform_real_distribution<double> uniform( 0, 1 );
+    std::vector<int> keys( count );
+
+    for ( long i = 0; i < count; ++i ) {
+        double u = uniform( generator );
+        double scaled = u*zeta_n;
+        long rank;
+
+        if ( scaled < 1 ) {
+            rank = 0;
+        } else if ( scaled < zeta_2 ) {
+            rank = 1;
+        } else {
+            rank = static_cast<long>( n*std::pow( eta*u - eta + 1, alpha ) );
+        }
+
+        if ( rank >= n ) {
+            rank = n - 1;
+        }
+
+        keys[i] = static_cast<int>( ( static_cast<unsigned long long>( rank )*2654435761ULL ) % n );
+    }
+
+    return keys;
+}
+
+inline std::vector<int> sequential_keys( long count ) {
+    std::vector<int> keys( count );
+
+    for ( long i = 0; i < count; ++i ) {
+        keys[i] = static_cast<int>( i );
+    }
+
+    return keys;
+}
+
+#endif
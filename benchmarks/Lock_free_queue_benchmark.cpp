@@ -0,0 +1,219 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "Lock_free_queue.h"
+#include "Work_stealing_deque.h"
+
+namespace {
+    // A std::queue behind a std::mutex, with the same interface as Lock_free_queue.
+    class Locked_queue {
+        private:
+            std::mutex lock;
+            std::queue<long> values;
+
+        public:
+            void push_back( long value ) {
+                std::lock_guard<std::mutex> guard( lock );
+                values.push( value );
+            }
+
+            bool pop_front( long &value ) {
+                std::lock_guard<std::mutex> guard( lock );
+
+                if ( values.empty() ) {
+                    return false;
+                }
+
+                value = values.front();
+                values.pop();
+                return true;
+            }
+    };
+
+    // A std::deque behind a std::mutex, with the same interface as Work_stealing_deque.
+    class Locked_deque {
+        private:
+            std::mutex lock;
+            std::deque<long> values;
+
+        public:
+            void push_back( long value ) {
+                std::lock_guard<std::mutex> guard( lock );
+                values.push_back( value );
+            }
+
+            bool pop_back( long &value ) {
+                std::lock_guard<std::mutex> guard( lock );
+
+                if ( values.empty() ) {
+                    return false;
+                }
+
+                value = values.back();
+                values.pop_back();
+                return true;
+            }
+
+            bool pop_front( long &value ) {
+                std::lock_guard<std::mutex> guard( lock );
+
+                if ( values.empty() ) {
+                    return false;
+                }
+
+                value = values.front();
+                values.pop_front();
+                return true;
+            }
+    };
+
+    /* The owner pushes n values and pops one back after every other push, as a scheduler
+     * running its own tasks would, while the thieves steal from the front. Every value is
+     * taken once, by one side or the other. */
+    template <typename Deque>
+    void steal( Deque &deque, long n, int thieves ) {
+        std::atomic<long> taken( 0 );
+        std::vector<std::thread> threads;
+
+        for ( int t = 0; t < thieves; ++t ) {
+            threads.emplace_back( [&] {
+                long value;
+                long sum = 0;
+
+                while ( taken.load( std::memory_order_relaxed ) < n ) {
+                    if ( deque.pop_front( value ) ) {
+                        sum += value;
+                        taken.fetch_add( 1, std::memory_order_relaxed );
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+
+                Benchmark::keep( sum );
+            } );
+        }
+
+        long value;
+        long sum = 0;
+
+        for ( long i = 0; i < n; ++i ) {
+            deque.push_back( i );
+
+            if ( i%2 == 1 && deque.pop_back( value ) ) {
+                sum += value;
+                taken.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+
+        while ( deque.pop_back( value ) ) {
+            sum += value;
+            taken.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        Benchmark::keep( sum );
+
+        for ( std::size_t i = 0; i < threads.size(); ++i ) {
+            threads[i].join();
+        }
+    }
+
+    // The producer threads push n values in all while the consumer threads pop them all.
+    template <typename Queue>
+    void transfer( Queue &queue, long n, int producers, int consumers ) {
+        std::atomic<long> popped( 0 );
+        std::vector<std::thread> threads;
+
+        for ( int p = 0; p < producers; ++p ) {
+            threads.emplace_back( [&, p] {
+                for ( long i = p; i < n; i += producers ) {
+                    queue.push_back( i );
+                }
+            } );
+        }
+
+        for ( int c = 0; c < consumers; ++c ) {
+            threads.emplace_back( [&] {
+                long value;
+                long sum = 0;
+
+                while ( popped.load( std::memory_order_relaxed ) < n ) {
+                    if ( queue.pop_front( value ) ) {
+                        sum += value;
+                        popped.fetch_add( 1, std::memory_order_relaxed );
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+
+                Benchmark::keep( sum );
+            } );
+        }
+
+        for ( std::size_t i = 0; i < threads.size(); ++i ) {
+            threads[i].join();
+        }
+    }
+}
+
+/* 1 to 32 producers and as many consumers moving values through a Lock_free_queue, against
+ * a std::queue behind a std::mutex, and with a single consumer to load the pop side. One
+ * operation is a push or a pop. */
+BENCHMARK( lock_free_queue_threads ) {
+    long const n = bench.size( 1000000 );
+    std::vector<int> counts = bench.thread_counts( 32 );
+
+    for ( std::size_t c = 0; c < counts.size(); ++c ) {
+        int threads = counts[c];
+        std::string suffix = " " + std::to_string( threads ) + "P";
+
+        bench.measure( "Lock_free_queue" + suffix + std::to_string( threads ) + "C", n, 2*n, [&] {
+            Lock_free_queue<long> queue;
+            transfer( queue, n, threads, threads );
+        }, 2*threads );
+
+        bench.measure( "mutex+std::queue" + suffix + std::to_string( threads ) + "C", n, 2*n, [&] {
+            Locked_queue queue;
+            transfer( queue, n, threads, threads );
+        }, 2*threads );
+
+        if ( threads > 1 ) {
+            bench.measure( "Lock_free_queue" + suffix + "1C", n, 2*n, [&] {
+                Lock_free_queue<long> queue;
+                transfer( queue, n, threads, 1 );
+            }, threads + 1 );
+        }
+    }
+}
+
+/* One owner and 1 to 32 thieves sharing a Work_stealing_deque that starts with room for 64
+ * values and grows as it needs to, against a std::deque behind a std::mutex. One operation
+ * is a push or a pop. */
+BENCHMARK( work_stealing_deque_threads ) {
+    long const n = bench.size( 1000000 );
+    std::vector<int> counts = bench.thread_counts( 32 );
+
+    for ( std::size_t c = 0; c < counts.size(); ++c ) {
+        int thieves = counts[c];
+        std::string suffix = " 1 owner " + std::to_string( thieves ) + "T";
+
+        bench.measure( "Work_stealing_deque" + suffix, n, 2*n, [&] {
+            Work_stealing_deque<long> deque;
+            steal( deque, n, thieves );
+        }, thieves + 1 );
+
+        bench.measure( "mutex+std::deque" + suffix, n, 2*n, [&] {
+            Locked_deque deque;
+            steal( deque, n, thieves );
+        }, thieves + 1 );
+    }
+}
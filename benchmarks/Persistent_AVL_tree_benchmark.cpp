@@ -0,0 +1,91 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "AVL_tree.h"
+#include "Persistent_AVL_tree.h"
+
+/* Lookups by 1 to 16 reader threads while one writer keeps inserting and erasing: lock-free
+ * snapshots of a Persistent_AVL_tree against an AVL_tree behind a std::mutex. Each reader
+ * takes a snapshot (or the lock) per batch of 64 lookups. */
+BENCHMARK( persistent_avl_tree_readers ) {
+    int const n = static_cast<int>( bench.size( 100000 ) );
+    long const lookups = bench.size( 400000 );
+    int const batch = 64;
+
+    Persistent_AVL_tree<int> persistent;
+    AVL_tree<int> locked;
+    std::mutex lock;
+
+    for ( int i = 0; i < n; i += 2 ) {
+        persistent.insert( i );
+        locked.insert( i );
+    }
+
+    std::vector<int> counts = bench.thread_counts( 16 );
+
+    for ( std::size_t c = 0; c < counts.size(); ++c ) {
+        int readers = counts[c];
+
+        // Runs the readers against the given lookup while a writer toggles odd values.
+        auto run = [&]( bool use_snapshots ) {
+            std::atomic<bool> reading( true );
+            std::thread writer( [&] {
+                for ( int value = 1; reading.load(); value = ( value + 2 )%n ) {
+                    if ( use_snapshots ) {
+                        persistent.insert( value );
+                        persistent.erase( value );
+                    } else {
+                        std::lock_guard<std::mutex> guard( lock );
+                        locked.insert( value );
+                        locked.erase( value );
+                    }
+                }
+            } );
+
+            std::vector<std::thread> threads;
+
+            for ( int r = 0; r < readers; ++r ) {
+                threads.emplace_back( [&, r] {
+                    long found = 0;
+                    unsigned int key = 2654435761u*( r + 1 );
+
+                    for ( long i = 0; i < lookups/readers; i += batch ) {
+                        if ( use_snapshots ) {
+                            Persistent_AVL_tree<int>::Snapshot snapshot = persistent.snapshot();
+
+                            for ( int j = 0; j < batch; ++j, key = key*1664525u + 1013904223u ) {
+                                found += snapshot.member( static_cast<int>( key%n ) );
+                            }
+                        } else {
+                            std::lock_guard<std::mutex> guard( lock );
+
+                            for ( int j = 0; j < batch; ++j, key = key*1664525u + 1013904223u ) {
+                                found += ( locked.find( static_cast<int>( key%n ) ) != locked.end() );
+                            }
+                        }
+                    }
+
+                    Benchmark::keep( found );
+                } );
+            }
+
+            for ( std::size_t r = 0; r < threads.size(); ++r ) {
+                threads[r].join();
+            }
+
+            reading.store( false );
+            writer.join();
+        };
+
+        bench.measure( "Persistent_AVL_tree::Snapshot::member", n, lookups, [&] { run( true ); }, readers );
+        bench.measure( "AVL_tree::find under std::mutex", n, lookups, [&] { run( false ); }, readers );
+    }
+}
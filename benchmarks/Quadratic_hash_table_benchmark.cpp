@@ -0,0 +1,113 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "Key_distributions.h"
+#include "Quadratic_hash_table.h"
+
+namespace {
+    // The number of bins is the smallest power of 2 that keeps the load factor at most 1/2.
+    int table_power( long n ) {
+        int power = 1;
+
+        while ( ( 1L << power ) < 2*n ) {
+            ++power;
+        }
+
+        return power;
+    }
+
+    /* The adversarial keys are multiples of the number of bins, which all hash to bin 0, so
+     * that the i-th insert probes the i - 1 keys before it. std::unordered_set hashes modulo a
+     * prime and spreads them. */
+    std::vector<int> table_keys( Key_distribution distribution, long n, unsigned seed ) {
+        switch ( distribution ) {
+            case Key_distribution::UNIFORM:
+                return uniform_keys( n, n, seed );
+            case Key_distribution::ZIPF:
+                return zipf_keys( n, n, seed );
+            case Key_distribution::SEQUENTIAL:
+                return sequential_keys( n );
+            default: {
+                std::vector<int> keys( n );
+                int power = table_power( n );
+
+                for ( long i = 0; i < n; ++i ) {
+                    keys[i] = static_cast<int>( i << power );
+                }
+
+                return keys;
+            }
+        }
+    }
+}
+
+/* Insert and member under every key distribution and size, against std::unordered_set.
+ * Colliding keys take O(n^2) probes, so the adversarial runs stop at 10^4 keys. */
+BENCHMARK( quadratic_hash_table_distributions ) {
+    std::vector<long> sizes = bench.sizes( 100000000 );
+
+    for ( std::size_t i = 0; i < sizes.size(); ++i ) {
+        long n = sizes[i];
+
+        for ( Key_distribution distribution : KEY_DISTRIBUTIONS ) {
+            if ( distribution == Key_distribution::ADVERSARIAL && n > 10000 ) {
+                continue;
+            }
+
+            std::string suffix = std::string( "/" ) + distribution_name( distribution );
+            std::vector<int> inserted = table_keys( distribution, n, 42 );
+            std::vector<int> searched = table_keys( distribution, n, 43 );
+
+            {
+                Quadratic_hash_table<int> table( table_power( n ) );
+
+                bench.measure( "Quadratic_hash_table::insert" + suffix, n, n, [&] {
+                    table.clear();
+                }, [&] {
+                    for ( long j = 0; j < n; ++j ) {
+                        table.insert( inserted[j] );
+                    }
+                } );
+
+                bench.measure( "Quadratic_hash_table::member" + suffix, n, n, [&] {
+                    long found = 0;
+
+                    for ( long j = 0; j < n; ++j ) {
+                        found += table.member( searched[j] );
+                    }
+
+                    Benchmark::keep( found );
+                } );
+            }
+
+            {
+                std::unordered_set<int> reference;
+
+                bench.measure( "std::unordered_set::insert" + suffix, n, n, [&] {
+                    reference.clear();
+                    reference.reserve( n );
+                }, [&] {
+                    for ( long j = 0; j < n; ++j ) {
+                        reference.insert( inserted[j] );
+                    }
+                } );
+
+                bench.measure( "std::unordered_set::count" + suffix, n, n, [&] {
+                    long found = 0;
+
+                    for ( long j = 0; j < n; ++j ) {
+                        found += reference.count( searched[j] );
+                    }
+
+                    Benchmark::keep( found );
+                } );
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "AVL_tree.h"
+
+/* AVL against WAVL balancing on write-only workloads. Besides the time per insert or
+ * erase, each result gives the rotations per operation and the height the tree reached.
+ * The rotations are counted because the target defines TREE_BALANCE_STATISTICS. */
+namespace {
+    // Inserts every key and erases them again in the given orders.
+    template <typename Balance>
+    void insert_then_erase( Benchmark &bench, std::string const &name,
+                            std::vector<int> const &inserts, std::vector<int> const &erases ) {
+        long n = static_cast<long>( inserts.size() );
+        long rotations = 0;
+        int height = 0;
+
+        bench.measure( name, n, 2*n, [&] {
+            AVL_tree<int, std::less<int>, Node_pool, Balance> tree;
+            long start = Balance_statistics::rotations();
+
+            for ( long i = 0; i < n; ++i ) {
+                tree.insert( inserts[i] );
+            }
+
+            height = tree.height();
+
+            for ( long i = 0; i < n; ++i ) {
+                tree.erase( erases[i] );
+            }
+
+            rotations = Balance_statistics::rotations() - start;
+        } );
+
+        bench.annotate( "rotations_per_op", static_cast<double>( rotations )/( 2*n ) );
+        bench.annotate( "height", height );
+    }
+
+    // Inserts increasing keys and erases each one once window newer keys are in.
+    template <typename Balance>
+    void sliding_window( Benchmark &bench, std::string const &name, long n, long window ) {
+        long rotations = 0;
+        int height = 0;
+
+        bench.measure( name, n, 2*n - window, [&] {
+            AVL_tree<int, std::less<int>, Node_pool, Balance> tree;
+            long start = Balance_statistics::rotations();
+
+            for ( long i = 0; i < n; ++i ) {
+                tree.insert( static_cast<int>( i ) );
+
+                if ( i >= window ) {
+                    tree.erase( static_cast<int>( i - window ) );
+                }
+            }
+
+            height = tree.height();
+            rotations = Balance_statistics::rotations() - start;
+        } );
+
+        bench.annotate( "rotations_per_op", static_cast<double>( rotations )/( 2*n - window ) );
+        bench.annotate( "height", height );
+    }
+}
+
+BENCHMARK( tree_balance_policies ) {
+    long n = bench.size( 1000000 );
+    std::vector<int> sorted( n );
+
+    for ( long i = 0; i < n; ++i ) {
+        sorted[i] = static_cast<int>( i );
+    }
+
+    std::vector<int> random_inserts = sorted;
+    std::vector<int> random_erases = sorted;
+    std::shuffle( random_inserts.begin(), random_inserts.end(), std::mt19937( 37 ) );
+    std::shuffle( random_erases.begin(), random_erases.end(), std::mt19937( 73 ) );
+
+    insert_then_erase<AVL_balance>( bench, "AVL random", random_inserts, random_erases );
+    insert_then_erase<WAVL_balance>( bench, "WAVL random", random_inserts, random_erases );
+    insert_then_erase<AVL_balance>( bench, "AVL sequential", sorted, sorted );
+    insert_then_erase<WAVL_balance>( bench, "WAVL sequential", sorted, sorted );
+    sliding_window<AVL_balance>( bench, "AVL sliding window", n, n/100 );
+    sliding_window<WAVL_balance>( bench, "WAVL sliding window", n, n/100 );
+}
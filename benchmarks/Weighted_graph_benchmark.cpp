@@ -0,0 +1,189 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Exception.h"
+#include "Benchmark.h"
+#include "Key_distributions.h"
+#include "Weighted_graph.h"
+
+#ifdef CONTAINER_BENCHMARK_BOOST
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#endif
+
+namespace {
+    // About one vertex pair in two is an edge, so the adjacency matrix is not mostly empty.
+    int vertex_count( long edges ) {
+        return static_cast<int>( std::ceil( std::sqrt( 4.0*edges ) ) );
+    }
+
+    /* n distinct edges between vertex_count( n ) vertices, with weights in (0, 1] unless noted:
+     *  - UNIFORM: both ends drawn uniformly.
+     *  - ZIPF: one end drawn from a Zipf distribution, so that a few hubs have most edges.
+     *  - SEQUENTIAL: a band, each vertex joined to the next few, so shortest paths are long.
+     *  - ADVERSARIAL: a path 0, 1, 2, ... of weight 1 plus random edges {i, j} of weight
+     *    2V - 2i for i < j, so that every vertex settled in order lowers the tentative
+     *    distance of all its later neighbours (the most decrease-keys for a heap). */
+    std::vector<Weighted_graph::Edge> graph_edges( Key_distribution distribution, long n ) {
+        int vertices = vertex_count( n );
+        std::vector<char> used( static_cast<std::size_t>( vertices )*vertices, 0 );
+        std::vector<Weighted_graph::Edge> edges;
+        std::mt19937_64 generator( 42 );
+        std::uniform_int_distribution<int> vertex( 0, vertices - 1 );
+        std::uniform_real_distribution<double> weight( 0.001, 1 );
+        std::vector<int> hubs;
+
+        edges.reserve( n );
+
+        if ( distribution == Key_distribution::ZIPF ) {
+            hubs = zipf_keys( 4*n, vertices );
+        }
+
+        // Adds edge {a, b} unless it is a loop or already there.
+        auto add = [&]( int a, int b, double w ) {
+            int m = ( a < b ) ? a : b;
+            int k = ( a < b ) ? b : a;
+
+            if ( m != k && !used[static_cast<std::size_t>( m )*vertices + k] ) {
+                used[static_cast<std::size_t>( m )*vertices + k] = 1;
+                Weighted_graph::Edge edge = {m, k, w};
+                edges.push_back( edge );
+            }
+        };
+
+        if ( distribution == Key_distribution::SEQUENTIAL ) {
+            for ( int gap = 1; static_cast<long>( edges.size() ) < n; ++gap ) {
+                for ( int m = 0; m + gap < vertices && static_cast<long>( edges.size() ) < n; ++m ) {
+                    add( m, m + gap, weight( generator ) );
+                }
+            }
+        } else if ( distribution == Key_distribution::ADVERSARIAL ) {
+            for ( int m = 0; m + 1 < vertices; ++m ) {
+                add( m, m + 1, 1 );
+            }
+        }
+
+        for ( std::size_t i = 0; static_cast<long>( edges.size() ) < n; ++i ) {
+            int a = ( i < hubs.size() ) ? hubs[i] : vertex( generator );
+            int b = vertex( generator );
+
+            if ( distribution == Key_distribution::ADVERSARIAL ) {
+                int m = ( a < b ) ? a : b;
+
+                if ( a - b != 1 && b - a != 1 ) {
+                    add( a, b, 2.0*vertices - 2.0*m );
+                }
+            } else {
+                add( a, b, weight( generator ) );
+            }
+        }
+
+        return edges;
+    }
+}
+
+/* Building the graph and finding the distances from vertex 0 under every edge distribution,
+ * against Boost Graph's Dijkstra when Boost is found (see CMakeLists.txt). n is the number of
+ * edges; the adjacency matrix takes 16V^2 = 64n bytes, so the sizes stop at 10^7 edges. */
+BENCHMARK( weighted_graph_distributions ) {
+    std::vector<long> sizes = bench.sizes( 10000000 );
+
+    for ( std::size_t i = 0; i < sizes.size(); ++i ) {
+        long n = sizes[i];
+        int vertices = vertex_count( n );
+
+        for ( Key_distribution distribution : KEY_DISTRIBUTIONS ) {
+            std::string suffix = std::string( "/" ) + distribution_name( distribution );
+            std::vector<Weighted_graph::Edge> edges = graph_edges( distribution, n );
+            std::unique_ptr<Weighted_graph> graph;
+
+            bench.measure( "Weighted_graph::insert" + suffix, n, n, [&] {
+                graph.reset();
+                graph.reset( new Weighted_graph( vertices ) );
+            }, [&] {
+                for ( long j = 0; j < n; ++j ) {
+                    graph->insert( edges[j].m, edges[j].n, edges[j].w );
+                }
+            } );
+
+            // Re-weighting an edge back and forth drops the cached distances.
+            Weighted_graph::Edge const &first = edges[0];
+
+            bench.measure( "Weighted_graph::distance" + suffix, n, 1, [&] {
+                graph->insert( first.m, first.n, 2*first.w );
+                graph->insert( first.m, first.n, first.w );
+            }, [&] {
+                Benchmark::keep( graph->distance( 0, vertices - 1 ) );
+            } );
+
+            bench.measure( "Weighted_graph::distances" + suffix, n, 1, [&] {
+                std::vector<double> distances = graph->distances( 0, 1 );
+                Benchmark::keep( distances[vertices - 1] );
+            } );
+
+#ifdef CONTAINER_BENCHMARK_BOOST
+            typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS, boost::no_property,
+                                          boost::property<boost::edge_weight_t, double> > Boost_graph;
+            std::unique_ptr<Boost_graph> reference;
+
+            bench.measure( "boost::adjacency_list::add_edge" + suffix, n, n, [&] {
+                reference.reset();
+                reference.reset( new Boost_graph( vertices ) );
+            }, [&] {
+                for ( long j = 0; j < n; ++j ) {
+                    boost::add_edge( edges[j].m, edges[j].n, edges[j].w, *reference );
+                }
+            } );
+
+            std::vector<double> distances( vertices );
+
+            bench.measure( "boost::dijkstra_shortest_paths" + suffix, n, 1, [&] {
+                boost::dijkstra_shortest_paths( *reference, 0, boost::distance_map( &distances[0] ) );
+                Benchmark::keep( distances[vertices - 1] );
+            } );
+#endif
+        }
+    }
+}
+
+/* Strong scaling of the delta-stepping distances: one query on a fixed graph of 4096
+ * vertices and about 2*10^6 edges, from 1 to 64 threads (capped by --max-threads), with the
+ * speedup over one thread. */
+BENCHMARK( weighted_graph_strong_scaling ) {
+    int vertices = static_cast<int>( bench.size( 4096 ) );
+    Weighted_graph graph( vertices );
+    std::mt19937_64 generator( 42 );
+    std::uniform_int_distribution<int> vertex( 0, vertices - 1 );
+    std::uniform_real_distribution<double> weight( 0.001, 1 );
+
+    for ( long i = 0; i < static_cast<long>( vertices )*vertices/8; ++i ) {
+        int m = vertex( generator );
+        int n = vertex( generator );
+
+        if ( m != n ) {
+            graph.insert( m, n, weight( generator ) );
+        }
+    }
+
+    std::vector<int> counts = bench.thread_counts( 64 );
+    double one_thread = 0;
+
+    for ( std::size_t i = 0; i < counts.size(); ++i ) {
+        int threads = counts[i];
+
+        bench.measure( "Weighted_graph::distances(scaling)", vertices, 1, [&] {
+            std::vector<double> distances = graph.distances( 0, threads );
+            Benchmark::keep( distances[vertices - 1] );
+        }, threads );
+
+        double seconds = bench.results().back().seconds;
+        one_thread = ( threads == 1 ) ? seconds : one_thread;
+        bench.annotate( "speedup", ( seconds > 0 ) ? one_thread/seconds : 0 );
+    }
+}
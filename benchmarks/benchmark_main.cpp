@@ -0,0 +1,74 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "Exception.h"
+#include "Benchmark.h"
+
+/* Runs every registered benchmark whose name contains the filter and prints the results
+ * as a JSON array:
+ *     container_benchmarks [--quick] [--max-threads N] [--max-size N] [--json FILE] [filter]
+ * The sizes swept by the distribution benchmarks stop at --max-size, 10^6 by default; going
+ * up to 10^8 needs several gigabytes of memory. */
+int main( int argc, char *argv[] ) {
+    bool quick = false;
+    int max_threads = 64;
+    long max_size = 1000000;
+    char const *json_path = nullptr;
+    char const *filter = "";
+
+    for ( int i = 1; i < argc; ++i ) {
+        if ( std::strcmp( argv[i], "--quick" ) == 0 ) {
+            quick = true;
+        } else if ( std::strcmp( argv[i], "--max-threads" ) == 0 && i + 1 < argc ) {
+            max_threads = std::atoi( argv[++i] );
+        } else if ( std::strcmp( argv[i], "--max-size" ) == 0 && i + 1 < argc ) {
+            max_size = std::atol( argv[++i] );
+        } else if ( std::strcmp( argv[i], "--json" ) == 0 && i + 1 < argc ) {
+            json_path = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    Benchmark bench( quick, ( max_threads > 0 ) ? max_threads : 1, max_size );
+
+    for ( std::size_t i = 0; i < Benchmark::registry().size(); ++i ) {
+        if ( std::strstr( Benchmark::registry()[i].first, filter ) != nullptr ) {
+            std::cerr << "running " << Benchmark::registry()[i].first << std::endl;
+            Benchmark::registry()[i].second( bench );
+        }
+    }
+
+    std::ofstream file;
+
+    if ( json_path != nullptr ) {
+        file.open( json_path );
+    }
+
+    std::ostream &out = ( json_path != nullptr ) ? file : std::cout;
+    out << "{\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"results\": [";
+
+    for ( std::size_t i = 0; i < bench.results().size(); ++i ) {
+        Benchmark::Result const &result = bench.results()[i];
+        out << ( ( i == 0 ) ? "\n" : ",\n" )
+            << "    {\"name\": \"" << result.name << "\", \"n\": " << result.n
+            << ", \"threads\": " << result.threads << ", \"ns_per_op\": " << result.ns_per_operation
+            << ", \"seconds\": " << result.seconds;
+
+        for ( std::size_t j = 0; j < result.metrics.size(); ++j ) {
+            out << ", \"" << result.metrics[j].first << "\": " << result.metrics[j].second;
+        }
+
+        out << "}";
+    }
+
+    out << "\n  ]\n}" << std::endl;
+
+    return 0;
+}
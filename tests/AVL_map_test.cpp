@@ -0,0 +1,89 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include "Exception.h"
+#include "Test.h"
+#include "AVL_map.h"
+
+// Counts the key comparisons made through it.
+class Counting_less {
+    public:
+        static long &comparisons() {
+            static long count = 0;
+            return count;
+        }
+
+        bool operator()( int lhs, int rhs ) const {
+            ++comparisons();
+            return lhs < rhs;
+        }
+};
+
+// operator[], insert, erase and find against std::map.
+void test_map_operations() {
+    AVL_map<int, std::string> map;
+    std::map<int, std::string> expected;
+    std::srand( 35 );
+
+    for ( int i = 0; i < 10000; ++i ) {
+        int key = std::rand()%2000;
+
+        switch ( std::rand()%4 ) {
+            case 0:
+                map[key] += "x";
+                expected[key] += "x";
+                break;
+            case 1:
+                CHECK( map.insert( key, "y" ) == expected.insert( std::make_pair( key, std::string( "y" ) ) ).second );
+                break;
+            case 2:
+                CHECK( map.erase( key ) == ( expected.erase( key ) == 1 ) );
+                break;
+            default:
+                CHECK( map.member( key ) == ( expected.count( key ) == 1 ) );
+                break;
+        }
+    }
+
+    CHECK( map.size() == static_cast<int>( expected.size() ) );
+
+    std::map<int, std::string>::iterator entry = expected.begin();
+
+    for ( AVL_map<int, std::string>::Iterator itr = map.begin(); itr != map.end(); ++itr, ++entry ) {
+        CHECK( itr->key == entry->first && itr->value == entry->second );
+    }
+}
+
+/* A miss in operator[] descends the tree once: at most two comparisons per level, plus the
+ * check of the new entry. Looking the key up again after inserting it would double that. */
+void test_single_descent() {
+    AVL_map<int, int, Counting_less> map;
+
+    for ( int key = 0; key < 4096; key += 2 ) {
+        map[key] = key;
+    }
+
+    int const levels = 13;      // 1.44 log2( 2048 ) rounded up.
+
+    for ( int key = 1; key < 4096; key += 64 ) {
+        Counting_less::comparisons() = 0;
+        map[key] = key;
+        CHECK( Counting_less::comparisons() <= 2*levels + 2 );
+
+        // A hit costs one descent too.
+        Counting_less::comparisons() = 0;
+        CHECK( map[key] == key );
+        CHECK( Counting_less::comparisons() <= 2*levels );
+    }
+}
+
+int main() {
+    test_map_operations();
+    test_single_descent();
+
+    return test_result();
+}
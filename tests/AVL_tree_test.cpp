@@ -0,0 +1,770 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "AVL_tree.h"
+
+// Returns true if tree holds exactly the values of expected, in order.
+template <typename Tree>
+bool same_values( Tree &tree, std::set<int> const &expected ) {
+    if ( tree.size() != static_cast<int>( expected.size() ) ) {
+        return false;
+    }
+
+    std::set<int>::const_iterator value = expected.begin();
+
+    for ( typename Tree::Iterator itr = tree.begin(); itr != tree.end(); ++itr, ++value ) {
+        if ( value == expected.end() || *itr != *value ) {
+            return false;
+        }
+    }
+
+    return ( value == expected.end() );
+}
+
+// An AVL tree of n nodes is at most about 1.44 log2( n + 2 ) high.
+bool balanced_height( int height, int n ) {
+    return height <= 1.4405*std::log2( n + 2.0 );
+}
+
+// A WAVL tree with erasures is only kept within 2 log2( n + 1 ).
+template <typename Balance>
+bool policy_height( int height, int n ) {
+    return Balance::HEIGHT_BALANCED ? balanced_height( height, n ) : height <= 2*std::log2( n + 1.0 );
+}
+
+/* Returns true if tree holds the values of expected in order along the threaded links in
+ * both directions, and select( k ) and rank( value ) agree with that order, which they only
+ * do if every sub-tree size is right. */
+template <typename Tree>
+bool consistent_order( Tree &tree, std::set<int> const &expected ) {
+    if ( !same_values( tree, expected ) ) {
+        return false;
+    }
+
+    std::set<int>::const_reverse_iterator value = expected.rbegin();
+
+    for ( typename Tree::Iterator itr = tree.rbegin(); itr != tree.rend(); --itr, ++value ) {
+        if ( value == expected.rend() || *itr != *value ) {
+            return false;
+        }
+    }
+
+    if ( value != expected.rend() || tree.select( -1 ) != tree.end() || tree.select( tree.size() ) != tree.end() ) {
+        return false;
+    }
+
+    int k = 0;
+
+    for ( std::set<int>::const_iterator itr = expected.begin(); itr != expected.end(); ++itr, ++k ) {
+        if ( *tree.select( k ) != *itr || tree.rank( *itr ) != k ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Random inserts, erases and finds through the iterative paths, checked against std::set.
+template <typename Tree>
+void test_iterative_operations() {
+    Tree tree;
+    std::set<int> expected;
+    std::srand( 31 );
+
+    for ( int i = 0; i < 20000; ++i ) {
+        int value = std::rand()%4000;
+
+        switch ( std::rand()%3 ) {
+            case 0:
+                CHECK( tree.insert( value ) == expected.insert( value ).second );
+                break;
+            case 1:
+                CHECK( tree.erase( value ) == ( expected.erase( value ) == 1 ) );
+                break;
+            default:
+                CHECK( ( tree.find( value ) != tree.end() ) == ( expected.count( value ) == 1 ) );
+                break;
+        }
+    }
+
+    CHECK( same_values( tree, expected ) );
+    CHECK( balanced_height( tree.height(), tree.size() ) );
+
+    tree.clear();
+    CHECK( tree.empty() );
+    CHECK( tree.height() == -1 );
+    CHECK_THROWS( tree.front(), underflow );
+}
+
+// Sorted input is the worst case for the rebalancing path; the tree must stay balanced.
+void test_sorted_input() {
+    AVL_tree<int> tree;
+    int const n = 200000;
+
+    for ( int i = 0; i < n; ++i ) {
+        tree.insert( i );
+    }
+
+    CHECK( tree.size() == n );
+    CHECK( balanced_height( tree.height(), n ) );
+    CHECK( tree.front() == 0 && tree.back() == n - 1 );
+
+    for ( int i = 0; i < n; i += 2 ) {
+        CHECK( tree.erase( i ) );
+    }
+
+    CHECK( tree.size() == n/2 );
+    CHECK( balanced_height( tree.height(), n/2 ) );
+    CHECK( tree.find( 2 ) == tree.end() && *tree.find( 3 ) == 3 );
+}
+
+/* Random inserts, erases (which relink the successor of a node with two children in its
+ * place) and node handles taken out and put back, with select and rank checked against
+ * std::set along the way, so that the sub-tree sizes stay right through every rotation of
+ * the balancing policy. rank is also checked for values not in the tree. */
+template <typename Balance>
+void test_order_statistics() {
+    AVL_tree<int, std::less<int>, Node_pool, Balance> tree;
+    std::set<int> expected;
+    std::srand( 28 );
+
+    for ( int i = 1; i <= 30000; ++i ) {
+        int value = std::rand()%2000;
+
+        switch ( std::rand()%4 ) {
+            case 0:
+            case 1:
+                CHECK( tree.insert( value ) == expected.insert( value ).second );
+                break;
+            case 2:
+                CHECK( tree.erase( value ) == ( expected.erase( value ) == 1 ) );
+                break;
+            default:
+                if ( expected.count( value ) == 1 ) {
+                    CHECK( tree.insert( tree.extract( value ) ) );
+                }
+                break;
+        }
+
+        if ( i%2000 == 0 ) {
+            CHECK( consistent_order( tree, expected ) );
+            CHECK( policy_height<Balance>( tree.height(), tree.size() ) );
+
+            std::set<int>::const_iterator lower = expected.begin();
+            int lower_count = 0;
+
+            for ( int x = -1; x <= 2000; ++x ) {
+                for ( ; lower != expected.end() && *lower < x; ++lower ) {
+                    ++lower_count;
+                }
+
+                CHECK( tree.rank( x ) == lower_count );
+            }
+        }
+    }
+
+    // Erasing everything in random order takes every size back to zero.
+    while ( !expected.empty() ) {
+        int value = *tree.select( std::rand()%tree.size() );
+        CHECK( tree.erase( value ) && expected.erase( value ) == 1 );
+    }
+
+    CHECK( tree.empty() && tree.select( 0 ) == tree.end() && tree.rank( 5 ) == 0 );
+}
+
+// Returns true if itr is end() and bound is expected.end(), or both are the same value.
+template <typename Tree>
+bool same_bound( Tree &tree, typename Tree::Iterator itr, std::set<int> const &expected, std::set<int>::const_iterator bound ) {
+    return ( itr == tree.end() ) ? ( bound == expected.end() ) : ( bound != expected.end() && *itr == *bound );
+}
+
+/* lower_bound, upper_bound, range and count_range against std::set after random inserts
+ * and erases, for values in the tree and between them, and for intervals with lo > hi,
+ * which are empty. The transparent overloads are checked with long keys. */
+template <typename Balance>
+void test_range_queries() {
+    AVL_tree<int, std::less<>, Node_pool, Balance> tree;
+    std::set<int> expected;
+    std::srand( 29 );
+
+    for ( int i = 1; i <= 20000; ++i ) {
+        int value = std::rand()%1000;
+
+        if ( std::rand()%3 == 0 ) {
+            CHECK( tree.erase( value ) == ( expected.erase( value ) == 1 ) );
+        } else {
+            CHECK( tree.insert( value ) == expected.insert( value ).second );
+        }
+
+        if ( i%2000 != 0 ) {
+            continue;
+        }
+
+        for ( int x = -2; x <= 1001; ++x ) {
+            CHECK( same_bound( tree, tree.lower_bound( x ), expected, expected.lower_bound( x ) ) );
+            CHECK( same_bound( tree, tree.upper_bound( x ), expected, expected.upper_bound( x ) ) );
+            CHECK( same_bound( tree, tree.lower_bound( static_cast<long>( x ) ), expected, expected.lower_bound( x ) ) );
+            CHECK( same_bound( tree, tree.upper_bound( static_cast<long>( x ) ), expected, expected.upper_bound( x ) ) );
+            CHECK( tree.rank( static_cast<long>( x ) ) == tree.rank( x ) );
+            CHECK( ( tree.find( static_cast<long>( x ) ) != tree.end() ) == ( expected.count( x ) == 1 ) );
+        }
+
+        for ( int j = 0; j < 200; ++j ) {
+            int lo = std::rand()%1100 - 50;
+            int hi = std::rand()%1100 - 50;
+            std::set<int>::const_iterator first = expected.lower_bound( lo );
+            std::set<int>::const_iterator last = expected.upper_bound( hi );
+            std::set<int> inside;
+
+            if ( lo <= hi ) {
+                inside.insert( first, last );
+            }
+
+            bool in_order = true;
+            std::set<int>::const_iterator next = inside.begin();
+            int visited = tree.range( lo, hi, [&]( int value ) {
+                in_order = in_order && next != inside.end() && value == *next++;
+            } );
+
+            CHECK( in_order && next == inside.end() );
+            CHECK( visited == static_cast<int>( inside.size() ) );
+            CHECK( tree.count_range( lo, hi ) == static_cast<int>( inside.size() ) );
+        }
+
+        CHECK( tree.count_range( 600, 400 ) == 0 && tree.range( 600, 400, []( int ) {} ) == 0 );
+    }
+
+    tree.clear();
+    CHECK( tree.lower_bound( 0 ) == tree.end() && tree.upper_bound( -5 ) == tree.end() );
+    CHECK( tree.count_range( -5, 5 ) == 0 );
+}
+
+// A heap allocator whose nodes never move to another tree, so join has to merge and merge has to copy.
+template <typename Node_type>
+class Unshared_allocator {
+    public:
+        Node_type *allocate() {
+            return static_cast<Node_type *>( ::operator new( sizeof( Node_type ) ) );
+        }
+
+        void deallocate( Node_type *node ) {
+            ::operator delete( node );
+        }
+
+        bool release() {
+            return false;
+        }
+
+        bool shares( Unshared_allocator const & ) const {
+            return false;
+        }
+
+        bool absorb( Unshared_allocator & ) {
+            return false;
+        }
+
+        void reserve( int ) {
+            // does nothing
+        }
+};
+
+// Checks a tree made by a bulk operation, and that it is still usable afterwards.
+template <typename Tree>
+bool bulk_result( Tree &tree, std::set<int> const &expected, bool height_balanced ) {
+    bool valid = consistent_order( tree, expected ) &&
+                 ( height_balanced ? balanced_height( tree.height(), tree.size() )
+                                   : tree.height() <= 2*std::log2( tree.size() + 1.0 ) );
+
+    return valid && tree.insert( -1000 ) && tree.erase( -1000 ) && consistent_order( tree, expected );
+}
+
+// Every length up to 300 is built perfectly balanced, and over whatever the tree held before.
+template <typename Balance>
+void test_build_from_sorted() {
+    AVL_tree<int, std::less<int>, Node_pool, Balance> tree;
+    std::vector<int> values;
+    std::set<int> expected;
+
+    for ( int n = 0; n <= 300; ++n ) {
+        if ( n > 0 ) {
+            values.push_back( 3*n );
+            expected.insert( 3*n );
+        }
+
+        tree.build_from_sorted( values.begin(), values.end() );
+        CHECK( tree.height() == ( ( n == 0 ) ? -1 : static_cast<int>( std::log2( n ) ) ) );
+        CHECK( bulk_result( tree, expected, Balance::HEIGHT_BALANCED ) );
+    }
+
+    // Inserts and erases rebalance a built tree as usual.
+    for ( int i = 0; i < 900; i += 2 ) {
+        tree.insert( i );
+        expected.insert( i );
+    }
+
+    for ( int i = 0; i < 900; i += 5 ) {
+        CHECK( tree.erase( i ) == ( expected.erase( i ) == 1 ) );
+    }
+
+    CHECK( bulk_result( tree, expected, Balance::HEIGHT_BALANCED ) );
+}
+
+/* Splits a tree of the even values 0, ..., 398 (inserted in random order, so its shape is
+ * not a built one) at every key from -1 to 400, in and between the values and beyond
+ * either end, into a tree with its own pool that held other values. The halves are then
+ * joined back, the lower into the higher or the other way round. */
+template <typename Balance, template <typename> class Allocator>
+void test_split_and_join() {
+    typedef AVL_tree<int, std::less<int>, Allocator, Balance> Tree;
+    bool height_balanced = Balance::HEIGHT_BALANCED;
+    std::vector<int> values;
+
+    for ( int i = 0; i < 200; ++i ) {
+        values.push_back( 2*i );
+    }
+
+    std::srand( 30 );
+
+    for ( int key = -1; key <= 400; ++key ) {
+        Tree lower;
+        Tree higher;
+        std::set<int> expected_lower;
+        std::set<int> expected_higher;
+
+        for ( int i = 199; i > 0; --i ) {
+            std::swap( values[i], values[std::rand()%( i + 1 )] );
+        }
+
+        for ( int i = 0; i < 200; ++i ) {
+            lower.insert( values[i] );
+            ( ( values[i] < key ) ? expected_lower : expected_higher ).insert( values[i] );
+        }
+
+        for ( int i = 1000; i < 1010; ++i ) {
+            higher.insert( i );
+        }
+
+        lower.split( key, higher );
+        CHECK( bulk_result( lower, expected_lower, height_balanced ) );
+        CHECK( bulk_result( higher, expected_higher, height_balanced ) );
+
+        std::set<int> expected( expected_lower );
+        expected.insert( expected_higher.begin(), expected_higher.end() );
+
+        if ( key%2 == 0 ) {
+            lower.join( higher );
+            CHECK( bulk_result( lower, expected, height_balanced ) );
+            CHECK( bulk_result( higher, std::set<int>(), true ) );
+        } else {
+            higher.join( lower );
+            CHECK( bulk_result( higher, expected, height_balanced ) );
+            CHECK( bulk_result( lower, std::set<int>(), true ) );
+        }
+    }
+
+    // The nodes split off stay valid after the tree they came from is destroyed.
+    Tree *source = new Tree;
+    Tree split_off;
+
+    for ( int i = 0; i < 100; ++i ) {
+        source->insert( i );
+    }
+
+    source->split( 50, split_off );
+    delete source;
+
+    for ( int i = 50; i < 100; ++i ) {
+        CHECK( split_off.erase( i ) );
+        CHECK( split_off.insert( i + 100 ) );
+    }
+
+    CHECK( split_off.size() == 50 && split_off.front() == 150 );
+}
+
+// join refuses trees whose values interleave or meet, and leaves both as they were.
+void test_join_overlap() {
+    AVL_tree<int> tree;
+    AVL_tree<int> other;
+    std::set<int> expected;
+    std::set<int> expected_other;
+
+    for ( int i = 0; i < 10; ++i ) {
+        tree.insert( i );
+        expected.insert( i );
+    }
+
+    other.insert( 9 );
+    other.insert( 20 );
+    expected_other.insert( 9 );
+    expected_other.insert( 20 );
+
+    CHECK_THROWS( tree.join( other ), illegal_argument );
+    CHECK_THROWS( other.join( tree ), illegal_argument );
+    CHECK( consistent_order( tree, expected ) && consistent_order( other, expected_other ) );
+
+    other.erase( 9 );
+    other.insert( 5 );
+    expected_other.erase( 9 );
+    expected_other.insert( 5 );
+    CHECK_THROWS( other.join( tree ), illegal_argument );
+    CHECK( consistent_order( tree, expected ) && consistent_order( other, expected_other ) );
+
+    // Joining a tree with itself or with an empty tree changes nothing; joining into an empty tree moves everything.
+    AVL_tree<int> empty;
+    tree.join( tree );
+    tree.join( empty );
+    CHECK( consistent_order( tree, expected ) && empty.empty() );
+
+    empty.join( tree );
+    CHECK( consistent_order( empty, expected ) && tree.empty() );
+}
+
+// merge takes the union of overlapping trees and leaves the other tree empty and usable.
+template <typename Balance, template <typename> class Allocator>
+void test_merge() {
+    typedef AVL_tree<int, std::less<int>, Allocator, Balance> Tree;
+    std::srand( 300 );
+
+    for ( int round = 0; round < 20; ++round ) {
+        Tree tree;
+        Tree other;
+        std::set<int> expected;
+
+        for ( int i = 0; i < 50*round; ++i ) {
+            int value = std::rand()%2000;
+            tree.insert( value );
+            expected.insert( value );
+        }
+
+        for ( int i = 0; i < 1000 - 50*round; ++i ) {
+            int value = std::rand()%2000;
+            other.insert( value );
+            expected.insert( value );
+        }
+
+        tree.merge( other );
+        CHECK( bulk_result( tree, expected, Balance::HEIGHT_BALANCED ) );
+        CHECK( bulk_result( other, std::set<int>(), true ) );
+
+        tree.merge( tree );
+        CHECK( consistent_order( tree, expected ) );
+    }
+}
+
+// A value with a tag that is not part of its order, to tell which tree an equal value came from.
+typedef std::pair<int, int> Tagged;
+
+// Orders by the first member only, and counts the comparisons made.
+class By_key {
+    public:
+        static long &comparisons() {
+            static long count = 0;
+            return count;
+        }
+
+        bool operator()( Tagged const &lhs, Tagged const &rhs ) const {
+            ++comparisons();
+            return lhs.first < rhs.first;
+        }
+};
+
+typedef AVL_tree<Tagged, By_key> Tagged_tree;
+
+// Inserts n random values below limit into tree and values, all with the same tag.
+void fill_tagged( Tagged_tree &tree, std::vector<Tagged> &values, int n, int limit, int tag ) {
+    for ( int i = 0; i < n; ++i ) {
+        tree.insert( Tagged( std::rand()%limit, tag ) );
+    }
+
+    values.clear();
+
+    for ( Tagged_tree::Iterator itr = tree.begin(); itr != tree.end(); ++itr ) {
+        values.push_back( *itr );
+    }
+}
+
+// Returns true if tree holds exactly values, tags included.
+bool holds_tagged( Tagged_tree &tree, std::vector<Tagged> const &values ) {
+    if ( tree.size() != static_cast<int>( values.size() ) ) {
+        return false;
+    }
+
+    std::vector<Tagged>::const_iterator value = values.begin();
+
+    for ( Tagged_tree::Iterator itr = tree.begin(); itr != tree.end(); ++itr, ++value ) {
+        if ( *itr != *value || tree.rank( *itr ) != value - values.begin() ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The result of a set operation also has to be built perfectly balanced.
+bool same_tagged( Tagged_tree &tree, std::vector<Tagged> const &values ) {
+    return holds_tagged( tree, values ) &&
+           tree.height() == ( values.empty() ? -1 : static_cast<int>( std::log2( values.size() ) ) );
+}
+
+/* set_union, set_intersection and set_difference against the std:: algorithms, which also
+ * take an equal value from the first range. The sizes go from equal, where both trees are
+ * walked, to very different either way round, where the smaller tree searches the larger
+ * one (swapping them for an intersection whose lhs is the larger). Empty trees are included,
+ * and the result always held other values before. */
+void test_set_operations() {
+    int const sizes[][3] = {
+        {1000, 1000, 1500}, {3000, 2000, 100000}, {10, 20000, 40000}, {20000, 10, 40000},
+        {1, 5000, 5000}, {0, 500, 1000}, {500, 0, 1000}, {0, 0, 1}
+    };
+    std::srand( 46 );
+
+    for ( int i = 0; i < 8; ++i ) {
+        Tagged_tree lhs;
+        Tagged_tree rhs;
+        Tagged_tree result;
+        std::vector<Tagged> lhs_values;
+        std::vector<Tagged> rhs_values;
+        std::vector<Tagged> expected;
+
+        fill_tagged( lhs, lhs_values, sizes[i][0], sizes[i][2], 1 );
+        fill_tagged( rhs, rhs_values, sizes[i][1], sizes[i][2], 2 );
+        result.insert( Tagged( -1, 3 ) );
+
+        set_union( lhs, rhs, result );
+        expected.clear();
+        std::set_union( lhs_values.begin(), lhs_values.end(), rhs_values.begin(), rhs_values.end(),
+                        std::back_inserter( expected ), By_key() );
+        CHECK( same_tagged( result, expected ) );
+
+        By_key::comparisons() = 0;
+        set_intersection( lhs, rhs, result );
+        long comparisons = By_key::comparisons();
+        expected.clear();
+        std::set_intersection( lhs_values.begin(), lhs_values.end(), rhs_values.begin(), rhs_values.end(),
+                               std::back_inserter( expected ), By_key() );
+        CHECK( same_tagged( result, expected ) );
+
+        // Searching the larger tree takes about 2 log2 n comparisons per value of the smaller one.
+        if ( sizes[i][0] == 10 || sizes[i][1] == 10 ) {
+            CHECK( comparisons < 1000 );
+        }
+
+        set_difference( lhs, rhs, result );
+        expected.clear();
+        std::set_difference( lhs_values.begin(), lhs_values.end(), rhs_values.begin(), rhs_values.end(),
+                             std::back_inserter( expected ), By_key() );
+        CHECK( same_tagged( result, expected ) );
+
+        // The inputs are left as they were.
+        CHECK( holds_tagged( lhs, lhs_values ) && holds_tagged( rhs, rhs_values ) );
+    }
+}
+
+// The same tree may be both inputs, but the result must be a third tree.
+void test_set_operation_aliasing() {
+    Tagged_tree tree;
+    Tagged_tree other;
+    Tagged_tree result;
+    std::vector<Tagged> values;
+    std::vector<Tagged> other_values;
+
+    fill_tagged( tree, values, 300, 1000, 1 );
+    fill_tagged( other, other_values, 300, 1000, 2 );
+
+    set_union( tree, tree, result );
+    CHECK( same_tagged( result, values ) );
+    set_intersection( tree, tree, result );
+    CHECK( same_tagged( result, values ) );
+    set_difference( tree, tree, result );
+    CHECK( result.empty() );
+
+    CHECK_THROWS( set_union( tree, other, tree ), illegal_argument );
+    CHECK_THROWS( set_intersection( tree, other, other ), illegal_argument );
+    CHECK_THROWS( set_difference( tree, tree, tree ), illegal_argument );
+    CHECK( holds_tagged( tree, values ) && holds_tagged( other, other_values ) );
+}
+
+// Counts the copies and moves of its value; relinking and node handles must make none.
+class Tracked {
+    private:
+        int key;
+
+    public:
+        static int &copies() {
+            static int count = 0;
+            return count;
+        }
+
+        static int &moves() {
+            static int count = 0;
+            return count;
+        }
+
+        explicit Tracked( int value = 0 ):key( value ) {
+            // does nothing
+        }
+
+        Tracked( Tracked const &obj ):key( obj.key ) {
+            ++copies();
+        }
+
+        Tracked( Tracked &&obj ):key( obj.key ) {
+            ++moves();
+        }
+
+        int get() const {
+            return key;
+        }
+
+        bool operator<( Tracked const &rhs ) const {
+            return key < rhs.key;
+        }
+
+        bool operator>( Tracked const &rhs ) const {
+            return key > rhs.key;
+        }
+
+        bool operator==( Tracked const &rhs ) const {
+            return key == rhs.key;
+        }
+};
+
+// emplace constructs in place, insert(Type &&) moves, and neither copies.
+void test_move_and_emplace() {
+    AVL_tree<Tracked> tree;
+    Tracked::copies() = Tracked::moves() = 0;
+
+    for ( int i = 0; i < 100; ++i ) {
+        CHECK( tree.emplace( i ) );
+    }
+
+    CHECK( !tree.emplace( 50 ) );
+    CHECK( Tracked::copies() == 0 && Tracked::moves() == 0 );
+
+    CHECK( tree.insert( Tracked( 100 ) ) );
+    CHECK( Tracked::copies() == 0 && Tracked::moves() == 1 );
+
+    AVL_tree<std::string> strings;
+    std::string value( 100, 'x' );
+
+    CHECK( strings.insert( std::move( value ) ) );
+    CHECK( value.empty() && strings.front().size() == 100 );
+}
+
+/* Erasing a node with two children relinks its successor in its place, so values are
+ * neither copied nor moved and pointers to the other values stay valid. */
+void test_relinking_erase() {
+    AVL_tree<Tracked> tree;
+
+    for ( int i = 0; i < 1000; ++i ) {
+        tree.emplace( i );
+    }
+
+    Tracked const *addresses[1000];
+
+    for ( int i = 0; i < 1000; ++i ) {
+        addresses[i] = &*tree.find( Tracked( i ) );
+    }
+
+    Tracked::copies() = Tracked::moves() = 0;
+
+    for ( int i = 0; i < 1000; i += 3 ) {
+        CHECK( tree.erase( Tracked( i ) ) );
+    }
+
+    CHECK( Tracked::copies() == 0 && Tracked::moves() == 0 );
+    CHECK( balanced_height( tree.height(), tree.size() ) );
+
+    for ( int i = 0; i < 1000; ++i ) {
+        if ( i%3 != 0 ) {
+            CHECK( &*tree.find( Tracked( i ) ) == addresses[i] );
+        }
+    }
+}
+
+// A node taken out by extract() goes into another tree without touching its value.
+template <template <typename> class Allocator>
+void test_node_handles( bool shared_nodes ) {
+    typedef AVL_tree<Tracked, std::less<Tracked>, Allocator> Tree;
+    Tree source;
+    Tree target;
+
+    for ( int i = 0; i < 100; ++i ) {
+        source.emplace( i );
+    }
+
+    target.emplace( 7 );
+    Tracked::copies() = Tracked::moves() = 0;
+
+    for ( int i = 0; i < 100; i += 2 ) {
+        typename Tree::Node_handle handle = source.extract( Tracked( i ) );
+        CHECK( !handle.empty() && handle.value().get() == i );
+
+        if ( i == 6 ) {
+            // An equivalent value is already there: the handle keeps its node.
+            typename Tree::Node_handle duplicate = target.extract( Tracked( 7 ) );
+            CHECK( target.insert( std::move( duplicate ) ) );
+        }
+
+        CHECK( target.insert( std::move( handle ) ) );
+        CHECK( handle.empty() );
+    }
+
+    CHECK( source.extract( Tracked( 0 ) ).empty() );
+    CHECK( source.size() == 50 && target.size() == 51 );
+    CHECK( *target.begin() == Tracked( 0 ) && target.back() == Tracked( 98 ) );
+
+    typename Tree::Node_handle kept = source.extract( Tracked( 1 ) );
+    source.emplace( 1 );
+    CHECK( !source.insert( std::move( kept ) ) && !kept.empty() );
+
+    /* The values are never copied. Heap allocators share their nodes, which are relinked
+     * as they are; separate pools do not, and each value is moved once into a new node. */
+    CHECK( Tracked::copies() == 0 );
+    CHECK( Tracked::moves() == ( shared_nodes ? 0 : 50 ) );
+
+    // Within one tree the node always comes back as it is.
+    Tracked::moves() = 0;
+    typename Tree::Node_handle handle = target.extract( Tracked( 50 ) );
+    Tracked const *address = &handle.value();
+    CHECK( target.insert( std::move( handle ) ) );
+    CHECK( &*target.find( Tracked( 50 ) ) == address && Tracked::moves() == 0 );
+}
+
+int main() {
+    test_iterative_operations<AVL_tree<int> >();
+    test_iterative_operations<AVL_tree<int, std::less<int>, Heap_allocator> >();
+    test_sorted_input();
+    test_order_statistics<AVL_balance>();
+    test_order_statistics<WAVL_balance>();
+    test_range_queries<AVL_balance>();
+    test_range_queries<WAVL_balance>();
+    test_build_from_sorted<AVL_balance>();
+    test_build_from_sorted<WAVL_balance>();
+    test_split_and_join<AVL_balance, Node_pool>();
+    test_split_and_join<WAVL_balance, Node_pool>();
+    test_split_and_join<AVL_balance, Unshared_allocator>();
+    test_join_overlap();
+    test_merge<AVL_balance, Node_pool>();
+    test_merge<WAVL_balance, Node_pool>();
+    test_merge<AVL_balance, Unshared_allocator>();
+    test_set_operations();
+    test_set_operation_aliasing();
+    test_move_and_emplace();
+    test_relinking_erase();
+    test_node_handles<Node_pool>( false );
+    test_node_handles<Heap_allocator>( true );
+
+    return test_result();
+}
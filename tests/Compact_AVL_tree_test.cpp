@@ -0,0 +1,322 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include "Exception.h"
+#include "Test.h"
+#include "Compact_AVL_tree.h"
+
+// Befriended by Compact_AVL_tree so that a test can check the nodes that height() trusts.
+class Compact_AVL_tree_tester {
+public:
+    /* Returns the height of the sub-tree at n and adds its nodes to count, or returns -2 if
+     * a balance factor in it is not the difference of the heights of its sub-trees. */
+    template <typename Type>
+    static int checked_height( Compact_AVL_tree<Type> const &tree, std::uint32_t n, int &count ) {
+        if ( n == Compact_AVL_tree<Type>::NIL ) {
+            return -1;
+        }
+
+        if ( n >= tree.node_pool.size() ) {
+            return -2;
+        }
+
+        int left = checked_height( tree, tree.left( n ), count );
+        int right = checked_height( tree, tree.right( n ), count );
+        ++count;
+
+        if ( left == -2 || right == -2 || tree.balance( n ) != right - left + 1 ) {
+            return -2;
+        }
+
+        return 1 + ( ( left > right ) ? left : right );
+    }
+
+    // The balance factors are right, height() agrees with them, and every node of the pool
+    // is either in the tree or on the free list.
+    template <typename Type>
+    static bool valid( Compact_AVL_tree<Type> const &tree ) {
+        int count = 0;
+        int height = checked_height( tree, tree.root_node, count );
+
+        return ( height != -2 && height == tree.height() && count == tree.size() &&
+                 count + free_nodes( tree ) == pool_size( tree ) );
+    }
+
+    template <typename Type>
+    static int pool_size( Compact_AVL_tree<Type> const &tree ) {
+        return static_cast<int>( tree.node_pool.size() );
+    }
+
+    template <typename Type>
+    static int free_nodes( Compact_AVL_tree<Type> const &tree ) {
+        int count = 0;
+
+        for ( std::uint32_t n = tree.free_list; n != Compact_AVL_tree<Type>::NIL; n = tree.node_pool[n].right_tree ) {
+            ++count;
+        }
+
+        return count;
+    }
+};
+
+namespace {
+    // The greatest height of an AVL tree of n nodes is below 1.4405 log2( n + 2 ) - 0.3277.
+    bool within_avl_bound( int height, int n ) {
+        return height <= 1.4405*std::log2( n + 2.0 ) - 0.3277;
+    }
+
+    // Walks the tree forward with ++ and backward with -- from end(), against expected.
+    bool same_order( Compact_AVL_tree<int> const &tree, std::set<int> const &expected ) {
+        if ( tree.size() != static_cast<int>( expected.size() ) || tree.empty() != expected.empty() ) {
+            return false;
+        }
+
+        Compact_AVL_tree<int>::Iterator itr = tree.begin();
+
+        for ( std::set<int>::const_iterator e = expected.begin(); e != expected.end(); ++e, ++itr ) {
+            if ( itr == tree.end() || *itr != *e ) {
+                return false;
+            }
+        }
+
+        if ( itr != tree.end() ) {
+            return false;
+        }
+
+        for ( std::set<int>::const_reverse_iterator e = expected.rbegin(); e != expected.rend(); ++e ) {
+            if ( --itr == tree.end() || *itr != *e ) {
+                return false;
+            }
+        }
+
+        return ( itr == tree.begin() );
+    }
+
+    /* Checks find for every key up to keys, and steps once each way from what it finds
+     * (or from end()) against the neighbours in expected. */
+    bool same_finds( Compact_AVL_tree<int> const &tree, std::set<int> const &expected, int keys ) {
+        for ( int key = 0; key < keys; ++key ) {
+            Compact_AVL_tree<int>::Iterator itr = tree.find( key );
+            std::set<int>::const_iterator e = expected.find( key );
+
+            if ( e == expected.end() ) {
+                if ( itr != tree.end() ) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            if ( itr == tree.end() || *itr != key ) {
+                return false;
+            }
+
+            Compact_AVL_tree<int>::Iterator next = itr;
+            std::set<int>::const_iterator e_next = e;
+            ++next;
+            ++e_next;
+
+            if ( ( e_next == expected.end() ) ? ( next != tree.end() ) : ( next == tree.end() || *next != *e_next ) ) {
+                return false;
+            }
+
+            Compact_AVL_tree<int>::Iterator previous = itr;
+            --previous;
+
+            if ( e != expected.begin() && ( previous == tree.end() || *previous != *--e ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Checks the whole tree against expected: structure, height, order and finds.
+    void check_tree( Compact_AVL_tree<int> const &tree, std::set<int> const &expected, int keys ) {
+        CHECK( Compact_AVL_tree_tester::valid( tree ) );
+        CHECK( within_avl_bound( tree.height(), tree.size() ) );
+        CHECK( same_order( tree, expected ) );
+        CHECK( same_finds( tree, expected, keys ) );
+
+        if ( !expected.empty() ) {
+            CHECK( tree.front() == *expected.begin() && tree.back() == *expected.rbegin() );
+        }
+    }
+}
+
+/* Batches of random inserts and erases against std::set, biased towards inserts and then
+ * towards erases so that the tree grows and empties again. The whole tree is checked after
+ * every batch. */
+void test_random_operations() {
+    int const keys = 2000;
+    Compact_AVL_tree<int> tree;
+    std::set<int> expected;
+    std::srand( 32 );
+
+    for ( int batch = 0; batch < 60; ++batch ) {
+        int insert_percent = ( batch%20 < 10 ) ? 75 : 25;
+
+        for ( int i = 0; i < 500; ++i ) {
+            int key = std::rand()%keys;
+
+            if ( std::rand()%100 < insert_percent ) {
+                CHECK( tree.insert( key ) == expected.insert( key ).second );
+            } else {
+                CHECK( tree.erase( key ) == ( expected.erase( key ) == 1 ) );
+            }
+        }
+
+        check_tree( tree, expected, keys );
+    }
+}
+
+/* Sorted keys make every insert land at the bottom of the right spine. Erasing from the
+ * front, from the back and then every other key rebalances the tree the other ways. */
+void test_sorted_keys() {
+    int const n = 4096;
+    Compact_AVL_tree<int> tree;
+    std::set<int> expected;
+
+    for ( int i = 0; i < n; ++i ) {
+        CHECK( tree.insert( i ) && !tree.insert( i ) );
+        expected.insert( i );
+
+        if ( i%512 == 511 ) {
+            check_tree( tree, expected, n );
+        }
+    }
+
+    // A full tree of 2^12 nodes built in order is perfectly balanced.
+    CHECK( tree.height() == 12 );
+
+    for ( int i = 0; i < n/4; ++i ) {
+        CHECK( tree.erase( i ) && !tree.erase( i ) );
+        CHECK( tree.erase( n - 1 - i ) );
+        expected.erase( i );
+        expected.erase( n - 1 - i );
+
+        if ( i%256 == 255 ) {
+            check_tree( tree, expected, n );
+        }
+    }
+
+    for ( int i = n/4; i < 3*n/4; i += 2 ) {
+        CHECK( tree.erase( i ) );
+        expected.erase( i );
+    }
+
+    check_tree( tree, expected, n );
+
+    for ( int i = 3*n/4 - 1; i >= n/4; i -= 2 ) {
+        CHECK( tree.erase( i ) );
+        expected.erase( i );
+
+        if ( i%128 == 1 ) {
+            check_tree( tree, expected, n );
+        }
+    }
+
+    CHECK( tree.empty() && tree.height() == -1 && tree.begin() == tree.end() );
+    CHECK_THROWS( tree.front(), underflow );
+    CHECK_THROWS( tree.back(), underflow );
+}
+
+/* Erased nodes go on the free list and inserts take them back before the pool grows, so the
+ * pool never holds more nodes than the tree has ever held at once. */
+void test_free_list_reuse() {
+    Compact_AVL_tree<int> tree;
+    std::set<int> expected;
+
+    for ( int i = 0; i < 1000; ++i ) {
+        tree.insert( i );
+        expected.insert( i );
+    }
+
+    CHECK( Compact_AVL_tree_tester::pool_size( tree ) == 1000 );
+
+    for ( int i = 0; i < 1000; i += 2 ) {
+        CHECK( tree.erase( i ) );
+        expected.erase( i );
+    }
+
+    CHECK( Compact_AVL_tree_tester::free_nodes( tree ) == 500 );
+    check_tree( tree, expected, 3000 );
+
+    // The reused nodes hold the new values, not the erased ones.
+    for ( int i = 1000; i < 1500; ++i ) {
+        tree.insert( i );
+        expected.insert( i );
+    }
+
+    CHECK( Compact_AVL_tree_tester::pool_size( tree ) == 1000 );
+    CHECK( Compact_AVL_tree_tester::free_nodes( tree ) == 0 );
+    check_tree( tree, expected, 3000 );
+
+    tree.insert( 1500 );
+    expected.insert( 1500 );
+    CHECK( Compact_AVL_tree_tester::pool_size( tree ) == 1001 );
+
+    // Churn at a steady size does not grow the pool either.
+    std::srand( 320 );
+
+    for ( int i = 0; i < 20000; ++i ) {
+        int key = std::rand()%3000;
+
+        if ( expected.erase( key ) == 1 ) {
+            CHECK( tree.erase( key ) );
+
+            int other;
+            do {
+                other = std::rand()%3000;
+            } while ( expected.count( other ) == 1 );
+
+            CHECK( tree.insert( other ) );
+            expected.insert( other );
+        }
+    }
+
+    CHECK( Compact_AVL_tree_tester::pool_size( tree ) == 1001 );
+    check_tree( tree, expected, 3000 );
+
+    tree.clear();
+    CHECK( tree.empty() && Compact_AVL_tree_tester::pool_size( tree ) == 0 );
+    CHECK( Compact_AVL_tree_tester::valid( tree ) );
+}
+
+// A freed node releases its value, and a reused one is constructed from the new value.
+void test_free_list_values() {
+    Compact_AVL_tree<std::string> tree;
+
+    for ( int i = 0; i < 100; ++i ) {
+        tree.insert( std::to_string( 1000 + i ) + std::string( 100, 'v' ) );
+    }
+
+    for ( int i = 0; i < 100; ++i ) {
+        CHECK( tree.erase( std::to_string( 1000 + i ) + std::string( 100, 'v' ) ) );
+    }
+
+    CHECK( tree.empty() && Compact_AVL_tree_tester::free_nodes( tree ) == 100 );
+
+    for ( int i = 0; i < 100; ++i ) {
+        tree.insert( std::to_string( 2000 + i ) );
+    }
+
+    CHECK( Compact_AVL_tree_tester::pool_size( tree ) == 100 && Compact_AVL_tree_tester::valid( tree ) );
+    CHECK( tree.front() == "2000" && tree.back() == "2099" );
+    CHECK( tree.find( "1000" + std::string( 100, 'v' ) ) == tree.end() );
+}
+
+int main() {
+    test_random_operations();
+    test_sorted_keys();
+    test_free_list_reuse();
+    test_free_list_values();
+
+    return test_result();
+}
@@ -0,0 +1,249 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <string>
+#include <utility>
+#include "Exception.h"
+#include "Test.h"
+#include "Double_linked_list.h"
+
+// Counts the calls to the global operator new, to check that moves allocate nothing.
+static long allocations = 0;
+
+void *operator new( std::size_t size ) {
+    ++allocations;
+    void *memory = std::malloc( size ? size : 1 );
+
+    if ( memory == nullptr ) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete( void *memory ) noexcept {
+    std::free( memory );
+}
+
+void operator delete( void *memory, std::size_t ) noexcept {
+    std::free( memory );
+}
+
+// A Node_pool that counts how many times release() dropped its slabs at once.
+template <typename Node_type>
+class Tracking_pool : public Node_pool<Node_type> {
+    public:
+        static int &releases() {
+            static int count = 0;
+            return count;
+        }
+
+        bool release() {
+            bool released = Node_pool<Node_type>::release();
+            releases() += released;
+            return released;
+        }
+};
+
+// Returns true if list holds exactly the values of expected, in order.
+template <typename Type>
+bool same_values( Double_linked_list<Type> const &list, std::list<Type> const &expected ) {
+    if ( list.size() != static_cast<int>( expected.size() ) ) {
+        return false;
+    }
+
+    typename std::list<Type>::const_iterator value = expected.begin();
+
+    for ( typename Double_linked_list<Type>::Double_node *node = list.begin(); node != list.end(); node = node->next() ) {
+        if ( !( node->value() == *value++ ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Pools sharing slabs through copies can still be absorbed, and whole groups of pools
+ * merge transitively: afterwards every pool shares with every other one. */
+void test_pool_absorb_chains() {
+    Node_pool<long> first;
+    Node_pool<long> second;
+    Node_pool<long> third;
+    Node_pool<long> third_copy( third );
+
+    long *node = third.allocate();
+    CHECK( first.absorb( third ) );
+    CHECK( third_copy.shares( first ) && third.shares( first ) );
+
+    CHECK( second.absorb( third_copy ) );
+    CHECK( first.shares( second ) && third.shares( second ) && third_copy.shares( second ) );
+    CHECK( !first.release() );
+
+    // A node from any of them can be freed through any other.
+    second.deallocate( node );
+    CHECK( first.allocate() == node );
+    first.deallocate( node );
+
+    Node_pool<long> other;
+    other.allocate();
+    CHECK( third.absorb( other ) && other.shares( first ) );
+}
+
+// a.splice( b ), then c.splice( a ) and c.merge( b ): each list keeps working afterwards.
+void test_chained_splices() {
+    Double_linked_list<int> a;
+    Double_linked_list<int> b;
+    Double_linked_list<int> c;
+
+    for ( int i = 0; i < 10; ++i ) {
+        a.push_back( 2*i );
+        b.push_back( 2*i + 1 );
+        c.push_back( 100 + i );
+    }
+
+    a.splice( a.end(), b );
+    c.splice( c.end(), a );
+    CHECK( a.empty() && b.empty() && c.size() == 30 );
+
+    for ( int i = 0; i < 10; ++i ) {
+        b.push_back( 200 + i );
+    }
+
+    c.merge( b );
+    a.merge( c );
+    CHECK( a.size() == 40 && b.empty() && c.empty() );
+
+    a.sort();
+    CHECK( a.front() == 0 && a.back() == 209 );
+    b.splice( b.end(), a, a.begin(), a.begin()->next()->next() );
+    CHECK( b.size() == 2 && b.front() == 0 && a.front() == 2 );
+}
+
+/* Random splices and merges between three lists of strings, against std::list. The
+ * lists are destroyed in different orders, so under ASan this also checks that every
+ * node and every slab is freed once. */
+void test_random_splices( int seed ) {
+    std::list<std::string> expected[3];
+    std::srand( seed );
+
+    {
+        Double_linked_list<std::string> lists[3];
+
+        for ( int i = 0; i < 3000; ++i ) {
+            int to = std::rand()%3;
+            int from = std::rand()%3;
+            std::string value = std::to_string( std::rand()%1000 );
+
+            switch ( std::rand()%5 ) {
+                case 0:
+                case 1:
+                    lists[to].push_back( value );
+                    expected[to].push_back( value );
+                    break;
+                case 2:
+                    if ( to != from ) {
+                        lists[to].splice( lists[to].begin(), lists[from] );
+                        expected[to].splice( expected[to].begin(), expected[from] );
+                    }
+                    break;
+                case 3:
+                    if ( to != from && !expected[from].empty() ) {
+                        lists[to].splice( lists[to].end(), lists[from], lists[from].begin() );
+                        expected[to].splice( expected[to].end(), expected[from], expected[from].begin() );
+                    }
+                    break;
+                default:
+                    if ( to != from ) {
+                        lists[to].sort();
+                        lists[from].sort();
+                        lists[to].merge( lists[from] );
+                        expected[to].sort();
+                        expected[from].sort();
+                        expected[to].merge( expected[from] );
+                    }
+                    break;
+            }
+        }
+
+        for ( int i = 0; i < 3; ++i ) {
+            CHECK( same_values( lists[i], expected[i] ) );
+        }
+
+        // The middle list goes first instead of between the others.
+        if ( seed%2 == 0 ) {
+            Double_linked_list<std::string> early;
+            early.swap( lists[1] );
+        }
+    }
+}
+
+/* A move allocates nothing and leaves the new list as the only user of its pool, so its
+ * destructor drops the slabs at once. The moved-from list gets a pool of its own. */
+void test_move_constructor() {
+    typedef Double_linked_list<int, Tracking_pool> List;
+    Tracking_pool<List::Double_node>::releases() = 0;
+
+    {
+        List source;
+
+        for ( int i = 0; i < 1000; ++i ) {
+            source.push_back( i );
+        }
+
+        long before = allocations;
+        List moved( std::move( source ) );
+        CHECK( allocations == before );
+        CHECK( source.empty() && moved.size() == 1000 && moved.back() == 999 );
+
+        List other;
+        other.push_back( -1 );
+        other.splice( other.end(), moved, moved.begin() );
+        moved.splice( moved.begin(), other );
+        CHECK( moved.size() == 1001 && moved.front() == -1 && other.empty() );
+
+        source.push_back( 7 );
+        CHECK( source.size() == 1 && source.front() == 7 );
+
+        List assigned;
+        assigned = std::move( source );
+        CHECK( assigned.front() == 7 && source.empty() );
+    }
+
+    // source, assigned and the moved/other pair each drop their slabs at once.
+    CHECK( Tracking_pool<List::Double_node>::releases() == 3 );
+}
+
+// Copies take their nodes from one block; accessors hand out references.
+void test_copy_and_references() {
+    Double_linked_list<std::string> list;
+
+    for ( int i = 0; i < 100; ++i ) {
+        list.emplace_back( 40, static_cast<char>( 'a' + i%26 ) );
+    }
+
+    list.emplace_front( "first" );
+    list.front() += "!";
+    list.back().clear();
+
+    Double_linked_list<std::string> copy( list );
+    CHECK( copy.size() == 101 && copy.front() == "first!" && copy.back().empty() );
+    CHECK( &list.begin()->value() == &list.front() );
+
+    list.pop_front();
+    CHECK( copy.front() == "first!" && list.front() == std::string( 40, 'a' ) );
+}
+
+int main() {
+    test_pool_absorb_chains();
+    test_chained_splices();
+    test_random_splices( 40 );
+    test_random_splices( 41 );
+    test_move_constructor();
+    test_copy_and_references();
+
+    return test_result();
+}
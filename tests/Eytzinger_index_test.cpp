@@ -0,0 +1,72 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cstdlib>
+#include <set>
+#include "Exception.h"
+#include "Test.h"
+#include "AVL_tree.h"
+
+// A stateful comparison: ascending or descending depending on how it was constructed.
+class Directed_less {
+    private:
+        bool descending;
+
+    public:
+        explicit Directed_less( bool reverse = false ):
+        descending( reverse ) {
+            // does nothing
+        }
+
+        bool operator()( int lhs, int rhs ) const {
+            return descending ? rhs < lhs : lhs < rhs;
+        }
+};
+
+// Every lookup on the frozen index agrees with a std::set searched in the same order.
+void test_freeze_order( bool descending ) {
+    Directed_less order( descending );
+    AVL_tree<int, Directed_less> tree( order );
+    std::set<int, Directed_less> expected( order );
+    std::srand( 33 );
+
+    for ( int i = 0; i < 5000; ++i ) {
+        int value = std::rand()%20000;
+        tree.insert( value );
+        expected.insert( value );
+    }
+
+    // The index starts with the default (ascending) order; freeze must hand it the tree's.
+    Eytzinger_index<int, Directed_less> index;
+    tree.freeze( index );
+    CHECK( index.size() == static_cast<int>( expected.size() ) );
+
+    for ( int key = -1; key <= 20001; ++key ) {
+        std::set<int, Directed_less>::iterator bound = expected.lower_bound( key );
+        int const *found = index.lower_bound( key );
+
+        CHECK( ( found == nullptr ) == ( bound == expected.end() ) );
+        CHECK( found == nullptr || *found == *bound );
+        CHECK( index.member( key ) == ( expected.count( key ) == 1 ) );
+    }
+}
+
+void test_comparator_constructor() {
+    Eytzinger_index<int, Directed_less> index( Directed_less( true ) );
+    int values[] = {9, 7, 5, 3, 1};
+    index.assign( values, 5 );
+
+    CHECK( index.member( 7 ) );
+    CHECK( !index.member( 4 ) );
+    CHECK( *index.lower_bound( 4 ) == 3 );
+    CHECK( index.lower_bound( 0 ) == nullptr );
+}
+
+int main() {
+    test_freeze_order( false );
+    test_freeze_order( true );
+    test_comparator_constructor();
+
+    return test_result();
+}
@@ -0,0 +1,134 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "Intrusive_list.h"
+
+// Two hooks at different offsets, neither of them first, and no default constructor.
+struct Task {
+    std::string name;
+    Intrusive_hook ready_hook;
+    long priority;
+    Intrusive_hook all_hook;
+
+    Task( std::string const &task_name, long task_priority ):
+    name( task_name ),
+    priority( task_priority ) {
+        // does nothing
+    }
+
+    bool operator==( Task const &rhs ) const {
+        return name == rhs.name;
+    }
+};
+
+// A hook at offset 0.
+struct Item {
+    Intrusive_hook hook;
+    int value;
+
+    bool operator==( Item const &rhs ) const {
+        return value == rhs.value;
+    }
+};
+
+typedef Intrusive_list<Task, &Task::ready_hook> Ready_list;
+typedef Intrusive_list<Task, &Task::all_hook> Task_list;
+
+// element() recovers the object from either hook, and each list only sees its own hook.
+void test_two_hooks() {
+    std::vector<Task> tasks;
+
+    for ( int i = 0; i < 10; ++i ) {
+        tasks.push_back( Task( "task " + std::to_string( i ), i ) );
+    }
+
+    Ready_list ready;
+    Task_list all;
+
+    for ( int i = 0; i < 10; ++i ) {
+        all.push_back( tasks[i] );
+
+        if ( i%2 == 0 ) {
+            ready.push_front( tasks[i] );
+        }
+    }
+
+    CHECK( all.size() == 10 && ready.size() == 5 );
+    CHECK( &all.front() == &tasks[0] && &ready.front() == &tasks[8] );
+    CHECK( &Task_list::element( all.begin()->next() ) == &tasks[1] );
+    CHECK( &Ready_list::element( ready.rbegin() ) == &tasks[0] );
+    CHECK( ready.find( tasks[4] ) == &tasks[4].ready_hook && ready.find( tasks[3] ) == ready.end() );
+
+    CHECK( ready.erase( tasks[4] ) == 1 && !tasks[4].ready_hook.linked() && tasks[4].all_hook.linked() );
+    CHECK( all.count( tasks[4] ) == 1 );
+
+    CHECK_THROWS( all.push_back( tasks[2] ), illegal_argument );
+
+    ready.clear();
+    all.clear();
+    CHECK( ready.empty() && all.empty() );
+}
+
+void test_first_member_hook() {
+    Item items[5];
+    Intrusive_list<Item, &Item::hook> list;
+
+    for ( int i = 0; i < 5; ++i ) {
+        items[i].value = i;
+        list.push_back( items[i] );
+    }
+
+    CHECK( list.back().value == 4 && list.front().value == 0 );
+    CHECK( list.find( items[2] ) == &items[2].hook );
+
+    list.erase( &items[2].hook );
+    CHECK( list.size() == 4 && list.count( items[2] ) == 0 );
+    list.clear();
+}
+
+// Only linked by test_concurrent_lists, so its threads race to record the offset.
+struct Job {
+    long id;
+    Intrusive_hook hook;
+};
+
+// Lists of the same type filled by several threads at once agree on the offset.
+void test_concurrent_lists() {
+    std::vector<std::thread> threads;
+    bool correct[4];
+
+    for ( int t = 0; t < 4; ++t ) {
+        threads.emplace_back( [&correct, t] {
+            std::vector<Job> jobs( 1000 );
+            Intrusive_list<Job, &Job::hook> list;
+            correct[t] = true;
+
+            for ( int i = 0; i < 1000; ++i ) {
+                jobs[i].id = i;
+                list.push_back( jobs[i] );
+                correct[t] = correct[t] && ( list.back().id == i );
+            }
+
+            list.clear();
+        } );
+    }
+
+    for ( int t = 0; t < 4; ++t ) {
+        threads[t].join();
+        CHECK( correct[t] );
+    }
+}
+
+int main() {
+    test_two_hooks();
+    test_first_member_hook();
+    test_concurrent_lists();
+
+    return test_result();
+}
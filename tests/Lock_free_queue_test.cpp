@@ -0,0 +1,167 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "Lock_free_queue.h"
+
+// Counts the live copies of the values, so that leaked or twice-deleted nodes show up.
+class Counted {
+    private:
+        long key;
+
+    public:
+        static std::atomic<long> &live() {
+            static std::atomic<long> count( 0 );
+            return count;
+        }
+
+        Counted( long value = -1 ):key( value ) {
+            ++live();
+        }
+
+        Counted( Counted const &obj ):key( obj.key ) {
+            ++live();
+        }
+
+        Counted &operator=( Counted const & ) = default;
+
+        ~Counted() {
+            --live();
+        }
+
+        long get() const {
+            return key;
+        }
+};
+
+/* Every value pushed by the producer threads is popped exactly once by the consumer threads,
+ * and each consumer sees the values of a producer in the order they were pushed. */
+void test_producers_consumers( int producers, int consumers ) {
+    long const per_producer = 2000;
+    long const total = per_producer*producers;
+    std::vector<std::atomic<int> > seen( total );
+    std::atomic<long> popped( 0 );
+    std::atomic<bool> in_order( true );
+
+    for ( long i = 0; i < total; ++i ) {
+        seen[i].store( 0 );
+    }
+
+    {
+        Lock_free_queue<Counted> queue;
+        std::vector<std::thread> threads;
+
+        for ( int p = 0; p < producers; ++p ) {
+            threads.emplace_back( [&, p] {
+                for ( long i = 0; i < per_producer; ++i ) {
+                    queue.push_back( Counted( p*per_producer + i ) );
+                }
+            } );
+        }
+
+        for ( int c = 0; c < consumers; ++c ) {
+            threads.emplace_back( [&] {
+                std::vector<long> last( producers, -1 );
+                Counted value;
+
+                while ( popped.load() < total ) {
+                    if ( queue.pop_front( value ) ) {
+                        long producer = value.get()/per_producer;
+
+                        if ( value.get() <= last[producer] ) {
+                            in_order.store( false );
+                        }
+
+                        last[producer] = value.get();
+                        seen[value.get()].fetch_add( 1 );
+                        popped.fetch_add( 1 );
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            } );
+        }
+
+        for ( std::size_t i = 0; i < threads.size(); ++i ) {
+            threads[i].join();
+        }
+
+        Counted value;
+        CHECK( queue.empty() && !queue.pop_front( value ) );
+    }
+
+    bool exactly_once = true;
+
+    for ( long i = 0; i < total; ++i ) {
+        exactly_once &= ( seen[i].load() == 1 );
+    }
+
+    CHECK( exactly_once );
+    CHECK( in_order.load() );
+    CHECK( Counted::live().load() == 0 );
+}
+
+/* Objects retired by many threads while others collect are each deleted exactly once,
+ * and never while a guard pinned before they were retired is alive. */
+void test_concurrent_retire() {
+    static std::atomic<long> deleted( 0 );
+    int const threads_count = 8;
+    int const per_thread = 5000;
+
+    {
+        Epoch_manager epochs;
+        Epoch_manager::Guard pinned = epochs.pin();
+        std::atomic<int> *watched = new std::atomic<int>( 0 );
+
+        epochs.retire( watched, [] ( void *object ) {
+            delete static_cast<std::atomic<int> *>( object );
+            ++deleted;
+        } );
+
+        std::vector<std::thread> threads;
+
+        for ( int t = 0; t < threads_count; ++t ) {
+            threads.emplace_back( [&] {
+                for ( int i = 0; i < per_thread; ++i ) {
+                    epochs.retire( new int( i ), [] ( void *object ) {
+                        delete static_cast<int *>( object );
+                        ++deleted;
+                    } );
+
+                    if ( i%16 == 0 ) {
+                        epochs.advance();
+                        epochs.collect();
+                    }
+                }
+            } );
+        }
+
+        for ( std::size_t i = 0; i < threads.size(); ++i ) {
+            threads[i].join();
+        }
+
+        // The object retired under the guard must still be there (ASan reports it otherwise).
+        CHECK( watched->load() == 0 && deleted.load() <= threads_count*per_thread );
+    }
+
+    CHECK( deleted.load() == threads_count*per_thread + 1 );
+}
+
+int main() {
+    // Every count from 1 to 32 on one side against 1 and 32 on the other.
+    for ( int threads = 1; threads <= 32; threads *= 2 ) {
+        test_producers_consumers( threads, 1 );
+        test_producers_consumers( 1, threads );
+        test_producers_consumers( threads, 32 );
+        test_producers_consumers( 32, threads );
+    }
+
+    test_concurrent_retire();
+
+    return test_result();
+}
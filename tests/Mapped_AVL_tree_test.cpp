@@ -0,0 +1,175 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Exception.h"
+#include "Test.h"
+#include "Mapped_AVL_tree.h"
+
+/* Crash recovery. A child process makes transactions and dies with _exit, so no destructor
+ * runs and nothing is checkpointed. The parent then puts back a copy of the file taken at
+ * the last checkpoint, as if none of the child's writes to the mapping had reached the disk
+ * (only the log, flushed by every commit, is durable), and reopens the tree. */
+namespace {
+    std::string read_file( std::string const &path ) {
+        std::ifstream in( path.c_str(), std::ios::binary );
+        return std::string( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+    }
+
+    void write_file( std::string const &path, std::string const &bytes ) {
+        std::ofstream out( path.c_str(), std::ios::binary | std::ios::trunc );
+        out.write( bytes.data(), static_cast<std::streamsize>( bytes.size() ) );
+    }
+
+    // Runs the transactions in a child that exits without closing the tree.
+    template <typename Transactions>
+    bool crash_after( std::string const &path, Transactions transactions ) {
+        pid_t child = fork();
+
+        if ( child == 0 ) {
+            // _exit is called before the tree goes out of scope.
+            try {
+                Mapped_AVL_tree<int> tree( path.c_str() );
+                transactions( tree );
+                _exit( 0 );
+            } catch ( ... ) {
+                _exit( 1 );
+            }
+        }
+
+        int status = 0;
+        waitpid( child, &status, 0 );
+        return ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+    }
+
+    bool holds( std::string const &path, std::set<int> const &model ) {
+        Mapped_AVL_tree<int> tree( path.c_str() );
+        std::set<int>::const_iterator expected = model.begin();
+
+        for ( Mapped_AVL_tree<int>::Iterator itr = tree.begin(); itr != tree.end(); ++itr, ++expected ) {
+            if ( expected == model.end() || *itr != *expected ) {
+                return false;
+            }
+        }
+
+        return ( expected == model.end() && tree.size() == static_cast<int>( model.size() ) );
+    }
+}
+
+/* Committed transactions are replayed from the log, including the ones that grew the file
+ * (5300 nodes nearly fill its first 256 KiB). The child's log stays well under the 1 MiB
+ * that triggers a checkpoint. */
+void test_replay_after_crash( std::string const &path ) {
+    std::set<int> model;
+
+    {
+        Mapped_AVL_tree<int> tree( path.c_str() );
+
+        for ( int i = 0; i < 5300; ++i ) {
+            tree.insert( i );
+            model.insert( i );
+        }
+    }
+
+    CHECK( read_file( path + ".wal" ).empty() );
+    std::string checkpointed = read_file( path );
+
+    CHECK( crash_after( path, [] ( Mapped_AVL_tree<int> &tree ) {
+        for ( int i = 5300; i < 5700; ++i ) {
+            tree.insert( i );
+        }
+
+        for ( int i = 0; i < 300; i += 2 ) {
+            tree.erase( i );
+        }
+    } ) );
+
+    for ( int i = 5300; i < 5700; ++i ) {
+        model.insert( i );
+    }
+
+    for ( int i = 0; i < 300; i += 2 ) {
+        model.erase( i );
+    }
+
+    CHECK( !read_file( path + ".wal" ).empty() );
+    CHECK( read_file( path ).size() > checkpointed.size() );
+    write_file( path, checkpointed );
+
+    CHECK( holds( path, model ) );
+    CHECK( read_file( path + ".wal" ).empty() );
+}
+
+// A last record cut short or corrupted was never committed, and is dropped.
+void test_torn_record( std::string const &path ) {
+    std::set<int> model;
+
+    {
+        Mapped_AVL_tree<int> tree( path.c_str() );
+        tree.clear();
+    }
+
+    for ( int damage = 0; damage < 2; ++damage ) {
+        std::string checkpointed = read_file( path );
+
+        CHECK( crash_after( path, [damage] ( Mapped_AVL_tree<int> &tree ) {
+            for ( int i = 0; i < 10; ++i ) {
+                tree.insert( 100*damage + i );
+            }
+        } ) );
+
+        for ( int i = 0; i < 9; ++i ) {
+            model.insert( 100*damage + i );
+        }
+
+        std::string log = read_file( path + ".wal" );
+
+        if ( damage == 0 ) {
+            log.resize( log.size() - 5 );
+        } else {
+            log[log.size() - 1] ^= 1;
+        }
+
+        write_file( path + ".wal", log );
+        write_file( path, checkpointed );
+
+        CHECK( holds( path, model ) );
+    }
+
+    // The tree goes on from the last committed transaction.
+    {
+        Mapped_AVL_tree<int> tree( path.c_str() );
+        CHECK( tree.insert( 9 ) );
+        model.insert( 9 );
+    }
+
+    CHECK( holds( path, model ) );
+}
+
+int main() {
+    char directory[] = "/tmp/mapped_avl_tree_XXXXXX";
+
+    if ( mkdtemp( directory ) == nullptr ) {
+        return 1;
+    }
+
+    std::string path = std::string( directory ) + "/tree";
+
+    test_replay_after_crash( path );
+    unlink( path.c_str() );
+    unlink( ( path + ".wal" ).c_str() );
+
+    test_torn_record( path );
+    unlink( path.c_str() );
+    unlink( ( path + ".wal" ).c_str() );
+    rmdir( directory );
+
+    return test_result();
+}
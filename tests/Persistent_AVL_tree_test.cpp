@@ -0,0 +1,159 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "Persistent_AVL_tree.h"
+
+// A value that counts its live instances, to see when replaced nodes are reclaimed.
+class Counted {
+    private:
+        int counted_value;
+
+    public:
+        static std::atomic<long> &live() {
+            static std::atomic<long> instances( 0 );
+            return instances;
+        }
+
+        Counted( int value = 0 ):
+        counted_value( value ) {
+            ++live();
+        }
+
+        Counted( Counted const &other ):
+        counted_value( other.counted_value ) {
+            ++live();
+        }
+
+        ~Counted() {
+            --live();
+        }
+
+        int value() const {
+            return counted_value;
+        }
+
+        bool operator<( Counted const &rhs ) const {
+            return counted_value < rhs.counted_value;
+        }
+
+        bool operator>( Counted const &rhs ) const {
+            return counted_value > rhs.counted_value;
+        }
+
+        bool operator==( Counted const &rhs ) const {
+            return counted_value == rhs.counted_value;
+        }
+};
+
+std::vector<int> contents( Persistent_AVL_tree<Counted>::Snapshot const &snapshot ) {
+    std::vector<int> values;
+
+    for ( Persistent_AVL_tree<Counted>::Iterator itr = snapshot.begin(); itr != snapshot.end(); ++itr ) {
+        values.push_back( ( *itr ).value() );
+    }
+
+    return values;
+}
+
+// Writes against std::set; an older snapshot keeps its version while the tree moves on.
+void test_versions() {
+    Persistent_AVL_tree<Counted> tree;
+    std::set<int> expected;
+    std::srand( 34 );
+
+    for ( int i = 0; i < 3000; ++i ) {
+        int value = std::rand()%1000;
+        CHECK( tree.insert( value ) == expected.insert( value ).second );
+    }
+
+    Persistent_AVL_tree<Counted>::Snapshot before = tree.snapshot();
+    std::vector<int> frozen( expected.begin(), expected.end() );
+
+    for ( int i = 0; i < 3000; ++i ) {
+        int value = std::rand()%1000;
+
+        if ( std::rand()%2 == 0 ) {
+            CHECK( tree.insert( value ) == expected.insert( value ).second );
+        } else {
+            CHECK( tree.erase( value ) == ( expected.erase( value ) == 1 ) );
+        }
+    }
+
+    CHECK( contents( before ) == frozen );
+    CHECK( before.size() == static_cast<int>( frozen.size() ) );
+
+    Persistent_AVL_tree<Counted>::Snapshot after = tree.snapshot();
+    CHECK( contents( after ) == std::vector<int>( expected.begin(), expected.end() ) );
+    CHECK( after.height() <= 1.4405*std::log2( after.size() + 2.0 ) );
+}
+
+/* Readers iterate snapshots while a writer replaces nodes under them. A node reclaimed too
+ * early shows up as a broken order or size here, and as a use after free under ASan. Once
+ * the snapshots are gone, the next write reclaims everything but the current version. */
+void test_concurrent_reclamation() {
+    {
+        Persistent_AVL_tree<Counted> tree;
+        std::atomic<bool> writing( true );
+        std::atomic<int> broken( 0 );
+        std::vector<std::thread> readers;
+
+        for ( int r = 0; r < 3; ++r ) {
+            readers.emplace_back( [&] {
+                while ( writing.load() ) {
+                    Persistent_AVL_tree<Counted>::Snapshot snapshot = tree.snapshot();
+                    std::vector<int> values = contents( snapshot );
+                    bool sorted = true;
+
+                    for ( std::size_t i = 1; i < values.size(); ++i ) {
+                        sorted = sorted && values[i - 1] < values[i];
+                    }
+
+                    if ( !sorted || static_cast<int>( values.size() ) != snapshot.size() ||
+                         ( !values.empty() && !snapshot.member( values[values.size()/2] ) ) ) {
+                        ++broken;
+                    }
+                }
+            } );
+        }
+
+        std::srand( 340 );
+
+        for ( int i = 0; i < 20000; ++i ) {
+            if ( std::rand()%2 == 0 ) {
+                tree.insert( std::rand()%500 );
+            } else {
+                tree.erase( std::rand()%500 );
+            }
+        }
+
+        writing.store( false );
+
+        for ( std::size_t r = 0; r < readers.size(); ++r ) {
+            readers[r].join();
+        }
+
+        CHECK( broken.load() == 0 );
+
+        // With no snapshot pinned, one more write collects every replaced node.
+        tree.insert( 1000 );
+        CHECK( Counted::live().load() == tree.snapshot().size() );
+    }
+
+    CHECK( Counted::live().load() == 0 );
+}
+
+int main() {
+    test_versions();
+    test_concurrent_reclamation();
+
+    return test_result();
+}
@@ -0,0 +1,97 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#define CONTAINER_PROFILING
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include "Exception.h"
+#include "Test.h"
+#include "AVL_tree.h"
+#include "Quadratic_hash_table.h"
+#include "Weighted_graph.h"
+
+// The operations are enumerators of Profiler, so their names are free out here.
+int const AVL_INSERT = -1;
+int const OPERATIONS = -1;
+
+typedef AVL_tree<int, std::less<int>, Heap_allocator> Heap_tree;
+
+// Constructors allocate outside any operation; those allocations get a line of their own.
+void test_constructor_allocations() {
+    Profiler::reset();
+
+    {
+        Heap_tree tree;
+    }
+
+    CHECK( Profiler::allocations_outside_operations() == 2 );
+
+    {
+        Quadratic_hash_table<int> table( 4 );
+    }
+
+    CHECK( Profiler::allocations_outside_operations() == 5 );
+
+    {
+        Weighted_graph graph( 8 );
+    }
+
+    CHECK( Profiler::allocations_outside_operations() == 12 );
+
+    std::ostringstream out;
+    Profiler::report( out );
+    CHECK( out.str().find( "allocations outside operations: 12" ) != std::string::npos );
+}
+
+// Only outermost operations are counted, with the allocations they make.
+void test_operation_counts() {
+    Profiler::reset();
+
+    Heap_tree tree;
+
+    for ( int i = 0; i < 100; ++i ) {
+        tree.insert( i );
+    }
+
+    for ( int i = 0; i < 50; ++i ) {
+        tree.find( i );
+    }
+
+    CHECK( Profiler::calls( Profiler::AVL_INSERT ) == 100 );
+    CHECK( Profiler::allocations( Profiler::AVL_INSERT ) == 100 );
+    CHECK( Profiler::calls( Profiler::AVL_FIND ) == 50 );
+    CHECK( Profiler::allocations( Profiler::AVL_FIND ) == 0 );
+
+    Quadratic_hash_table<int> table( 6 );
+
+    for ( int i = 0; i < 10; ++i ) {
+        table.insert( i );
+    }
+
+    // Each insert calls member(), which is not counted on its own.
+    CHECK( Profiler::calls( Profiler::HASH_INSERT ) == 10 );
+    CHECK( Profiler::calls( Profiler::HASH_MEMBER ) == 0 );
+
+    for ( int i = 0; i < 10; ++i ) {
+        table.member( i );
+    }
+
+    CHECK( Profiler::calls( Profiler::HASH_MEMBER ) == 10 );
+
+    Weighted_graph graph( 4 );
+    graph.insert( 0, 1, 1 );
+    graph.insert( 1, 2, 1 );
+    CHECK( graph.distance( 0, 2 ) == 2 );
+    CHECK( Profiler::calls( Profiler::GRAPH_DISTANCE ) == 1 );
+    CHECK( Profiler::allocations_outside_operations() == 2 + 3 + 7 );
+}
+
+int main() {
+    test_constructor_allocations();
+    test_operation_counts();
+
+    return test_result();
+}
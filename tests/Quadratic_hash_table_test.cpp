@@ -0,0 +1,160 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <climits>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <string>
+#include "Exception.h"
+#include "Test.h"
+#include "Quadratic_hash_table.h"
+
+// Befriended by Quadratic_hash_table so that a test does not need 2^32 clears to wrap around.
+class Quadratic_hash_table_tester {
+public:
+    template <typename Type>
+    static unsigned int &generation( Quadratic_hash_table<Type> &table ) {
+        return table.current_generation;
+    }
+};
+
+namespace {
+    // Returns true if table holds exactly the values of expected.
+    bool same_members( Quadratic_hash_table<int> const &table, std::set<int> const &expected, int keys ) {
+        if ( table.size() != static_cast<int>( expected.size() ) ) {
+            return false;
+        }
+
+        for ( int key = 0; key < keys; ++key ) {
+            if ( table.member( key ) != ( expected.count( key ) == 1 ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Every bin of a cleared table prints as UNOCCUPIED.
+    bool all_unoccupied( Quadratic_hash_table<int> const &table ) {
+        std::ostringstream out;
+        out << table;
+
+        std::string expected;
+
+        for ( int i = 0; i < table.capacity(); ++i ) {
+            expected += "- ";
+        }
+
+        return ( out.str() == expected );
+    }
+}
+
+/* Fills a table of 32 bins with random inserts and erases (which leave ERASED bins behind)
+ * and clears it, many times over. Nothing from an older generation may show through: not as
+ * a member, in size() or load_factor(), or as an ERASED bin that a new insert or probe sees. */
+void test_clear_cycles() {
+    Quadratic_hash_table<int> table( 5 );
+    std::srand( 26 );
+
+    for ( int cycle = 0; cycle < 500; ++cycle ) {
+        std::set<int> expected;
+
+        for ( int i = 0; i < 60; ++i ) {
+            int key = std::rand()%128;
+
+            if ( std::rand()%3 == 0 ) {
+                CHECK( table.erase( key ) == ( expected.erase( key ) == 1 ) );
+            } else if ( static_cast<int>( expected.size() ) < 24 ) {
+                table.insert( key );
+                expected.insert( key );
+            }
+        }
+
+        CHECK( same_members( table, expected, 128 ) );
+        CHECK( table.load_factor() >= static_cast<double>( expected.size() )/table.capacity() );
+
+        table.clear();
+
+        CHECK( table.empty() );
+        CHECK( table.size() == 0 );
+        CHECK( table.load_factor() == 0 );
+        CHECK( same_members( table, std::set<int>(), 128 ) );
+        CHECK( all_unoccupied( table ) );
+    }
+}
+
+// Bins that all hash to 0 are probed past the ERASED bins of the previous generation.
+void test_clear_after_erase() {
+    Quadratic_hash_table<int> table( 4 );
+
+    for ( int i = 0; i < 8; ++i ) {
+        table.insert( 16*i );
+    }
+
+    for ( int i = 0; i < 8; ++i ) {
+        CHECK( table.erase( 16*i ) );
+    }
+
+    CHECK( table.size() == 0 );
+    CHECK( table.load_factor() == 0.5 );
+
+    table.clear();
+    CHECK( table.load_factor() == 0 );
+
+    // After the clear the first probe of 16 finds bin 0 UNOCCUPIED, not ERASED.
+    table.insert( 16 );
+    CHECK( table.member( 16 ) && !table.member( 0 ) );
+    CHECK( table.size() == 1 );
+    CHECK( table.load_factor() == 1.0/16 );
+    CHECK( table.erase( 16 ) && !table.erase( 16 ) );
+}
+
+/* The values written in generation 1 are stale once the table is cleared. When the
+ * generation wraps around to 1 again, the stamps must have been swept, otherwise the
+ * stale values would come back. */
+void test_generation_wraparound() {
+    Quadratic_hash_table<int> table( 3 );
+    unsigned int &generation = Quadratic_hash_table_tester::generation( table );
+
+    for ( int i = 0; i < 6; ++i ) {
+        table.insert( i );
+    }
+
+    CHECK( generation == 1 );
+
+    // As if UINT_MAX - 1 clears had been made.
+    table.clear();
+    generation = UINT_MAX - 1;
+
+    table.insert( 3 );
+    table.insert( 11 );
+    CHECK( table.erase( 3 ) );
+    table.clear();
+    CHECK( generation == UINT_MAX );
+    CHECK( same_members( table, std::set<int>(), 16 ) );
+
+    table.insert( 5 );
+    table.clear();
+    CHECK( generation == 1 );
+
+    CHECK( table.size() == 0 && table.load_factor() == 0 );
+    CHECK( same_members( table, std::set<int>(), 16 ) );
+    CHECK( all_unoccupied( table ) );
+
+    table.insert( 7 );
+    table.insert( 15 );
+    std::set<int> expected;
+    expected.insert( 7 );
+    expected.insert( 15 );
+    CHECK( same_members( table, expected, 16 ) );
+}
+
+int main() {
+    test_clear_cycles();
+    test_clear_after_erase();
+    test_generation_wraparound();
+
+    return test_result();
+}
@@ -0,0 +1,52 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <iostream>
+
+/* Minimal test driver. CHECK reports a failed condition and carries on, so one run shows
+ * every failure; main returns test_result(), which ctest reads as pass or fail.
+ *
+ *     CHECK( tree.size() == 3 );
+ *     CHECK_THROWS( tree.front(), underflow );
+ *     return test_result(); */
+inline int &test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK( condition ) \
+    do { \
+        if ( !( condition ) ) { \
+            ++test_failures(); \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK( " #condition " ) failed" << std::endl; \
+        } \
+    } while ( false )
+
+#define CHECK_THROWS( expression, exception ) \
+    do { \
+        bool thrown = false; \
+        try { \
+            expression; \
+        } catch ( exception const & ) { \
+            thrown = true; \
+        } \
+        if ( !thrown ) { \
+            ++test_failures(); \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #expression " did not throw " #exception << std::endl; \
+        } \
+    } while ( false )
+
+inline int test_result() {
+    if ( test_failures() != 0 ) {
+        std::cerr << test_failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
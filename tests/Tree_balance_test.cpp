@@ -0,0 +1,153 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#define TREE_BALANCE_STATISTICS
+
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include "Exception.h"
+#include "Test.h"
+#include "AVL_tree.h"
+
+/* Runs the Base policy and then checks the whole tree (reached through the root link,
+ * path[0]) against the rules of the policy. Rule is AVL_rules or WAVL_rules. */
+template <typename Base, typename Rule>
+struct Checked_balance {
+    static const bool HEIGHT_BALANCED = Base::HEIGHT_BALANCED;
+
+    static bool &valid() {
+        static bool all_valid = true;
+        return all_valid;
+    }
+
+    template <typename Node>
+    static void after_insert( Node **path[], int depth ) {
+        Base::after_insert( path, depth );
+        check( path, depth );
+    }
+
+    template <typename Node>
+    static void after_erase( Node **path[], int depth ) {
+        Base::after_erase( path, depth );
+        check( path, depth );
+    }
+
+    template <typename Node>
+    static void check( Node **path[], int depth ) {
+        if ( depth > 0 && Rule::size_of( *path[0] ) < 0 ) {
+            valid() = false;
+        }
+    }
+};
+
+// Sub-tree heights are exact and sibling heights differ by at most 1. Returns the size, or -1.
+struct AVL_rules {
+    template <typename Node>
+    static int size_of( Node const *node ) {
+        if ( node == nullptr ) {
+            return 0;
+        }
+
+        int left = size_of( node->left_tree );
+        int right = size_of( node->right_tree );
+        int left_height = Node::height( node->left_tree );
+        int right_height = Node::height( node->right_tree );
+
+        if ( left < 0 || right < 0 || std::abs( left_height - right_height ) > 1 ||
+             node->tree_height != 1 + std::max( left_height, right_height ) ||
+             node->subtree_size != left + right + 1 ) {
+            return -1;
+        }
+
+        return left + right + 1;
+    }
+};
+
+// Rank differences are 1 or 2 and leaves have rank 0. Returns the size, or -1.
+struct WAVL_rules {
+    template <typename Node>
+    static int size_of( Node const *node ) {
+        if ( node == nullptr ) {
+            return 0;
+        }
+
+        int left = size_of( node->left_tree );
+        int right = size_of( node->right_tree );
+        int left_difference = node->tree_height - Node::height( node->left_tree );
+        int right_difference = node->tree_height - Node::height( node->right_tree );
+
+        if ( left < 0 || right < 0 || left_difference < 1 || left_difference > 2 ||
+             right_difference < 1 || right_difference > 2 ||
+             ( node->is_leaf() && node->tree_height != 0 ) ||
+             node->subtree_size != left + right + 1 ) {
+            return -1;
+        }
+
+        return left + right + 1;
+    }
+};
+
+typedef Checked_balance<AVL_balance, AVL_rules> Checked_AVL;
+typedef Checked_balance<WAVL_balance, WAVL_rules> Checked_WAVL;
+
+/* Random inserts and erases, with the rules checked after every change. A WAVL erase does
+ * at most two rotations, and the height stays within 2 log2 n. */
+template <typename Balance>
+void test_random_operations( bool wavl ) {
+    AVL_tree<int, std::less<int>, Node_pool, Balance> tree;
+    std::set<int> expected;
+    std::srand( 37 );
+
+    for ( int i = 0; i < 20000; ++i ) {
+        int value = std::rand()%3000;
+
+        if ( std::rand()%2 == 0 ) {
+            CHECK( tree.insert( value ) == expected.insert( value ).second );
+        } else {
+            long before = Balance_statistics::rotations();
+            CHECK( tree.erase( value ) == ( expected.erase( value ) == 1 ) );
+
+            if ( wavl ) {
+                CHECK( Balance_statistics::rotations() - before <= 2 );
+            }
+        }
+
+        CHECK( tree.size() == static_cast<int>( expected.size() ) );
+    }
+
+    CHECK( Balance::valid() );
+    CHECK( tree.height() <= 2*std::log2( tree.size() + 1.0 ) );
+    CHECK( *tree.begin() == *expected.begin() && tree.back() == *expected.rbegin() );
+}
+
+// With insertions only, WAVL builds exactly the trees that AVL builds.
+void test_insert_only_shapes() {
+    AVL_tree<int, std::less<int>, Node_pool, Checked_AVL> avl;
+    AVL_tree<int, std::less<int>, Node_pool, Checked_WAVL> wavl;
+    std::srand( 370 );
+
+    for ( int i = 0; i < 5000; ++i ) {
+        int value = std::rand();
+        avl.insert( value );
+        wavl.insert( value );
+        CHECK( avl.height() == wavl.height() );
+    }
+
+    for ( int i = 0; i < 5000; ++i ) {
+        avl.insert( -i );
+        wavl.insert( -i );
+    }
+
+    CHECK( avl.height() == wavl.height() );
+    CHECK( Checked_AVL::valid() && Checked_WAVL::valid() );
+}
+
+int main() {
+    test_random_operations<Checked_AVL>( false );
+    test_random_operations<Checked_WAVL>( true );
+    test_insert_only_shapes();
+
+    return test_result();
+}
@@ -0,0 +1,144 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include "Exception.h"
+#include "Test.h"
+#include "Unrolled_linked_list.h"
+
+// Returns true if list holds exactly the values of expected, in order.
+template <typename Type>
+bool same_values( Unrolled_linked_list<Type> const &list, std::deque<Type> const &expected ) {
+    if ( list.size() != static_cast<int>( expected.size() ) ) {
+        return false;
+    }
+
+    std::size_t index = 0;
+
+    for ( typename Unrolled_linked_list<Type>::Chunk *chunk = list.begin(); chunk != list.end(); chunk = chunk->next() ) {
+        for ( int i = 0; i < chunk->size(); ++i, ++index ) {
+            if ( index == expected.size() || !( chunk->value( i ) == expected[index] ) ) {
+                return false;
+            }
+        }
+    }
+
+    return ( index == expected.size() );
+}
+
+// After an erase, no two neighbouring chunks fit in one.
+template <typename Type>
+bool chunks_merged( Unrolled_linked_list<Type> const &list ) {
+    typedef typename Unrolled_linked_list<Type>::Chunk Chunk;
+
+    for ( Chunk *chunk = list.begin(); chunk != list.end() && chunk->next() != nullptr; chunk = chunk->next() ) {
+        if ( chunk->size() + chunk->next()->size() <= Unrolled_linked_list<Type>::CHUNK_CAPACITY ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Pushes and pops at both ends and erases values, against std::deque.
+void test_random_operations() {
+    Unrolled_linked_list<int> list;
+    std::deque<int> expected;
+    std::srand( 39 );
+
+    for ( int i = 0; i < 20000; ++i ) {
+        int value = std::rand()%50;
+
+        switch ( std::rand()%6 ) {
+            case 0:
+            case 1:
+                list.push_back( value );
+                expected.push_back( value );
+                break;
+            case 2:
+                list.push_front( value );
+                expected.push_front( value );
+                break;
+            case 3:
+                if ( !expected.empty() ) {
+                    list.pop_front();
+                    expected.pop_front();
+                }
+                break;
+            case 4:
+                if ( !expected.empty() ) {
+                    list.pop_back();
+                    expected.pop_back();
+                }
+                break;
+            default: {
+                int erased = 0;
+
+                for ( std::deque<int>::iterator itr = expected.begin(); itr != expected.end(); ) {
+                    if ( *itr == value ) {
+                        itr = expected.erase( itr );
+                        ++erased;
+                    } else {
+                        ++itr;
+                    }
+                }
+
+                CHECK( list.erase( value ) == erased );
+                CHECK( chunks_merged( list ) );
+                break;
+            }
+        }
+    }
+
+    CHECK( same_values( list, expected ) );
+    CHECK( list.count( 7 ) == static_cast<int>( std::count( expected.begin(), expected.end(), 7 ) ) );
+}
+
+/* Erasing most values leaves the chunks at least half full on average, so the list
+ * takes no more chunks than about twice the minimum. Strings check that merging moves
+ * and destroys the values properly. */
+void test_merge_after_erase() {
+    Unrolled_linked_list<std::string> list;
+    std::deque<std::string> expected;
+    int const capacity = Unrolled_linked_list<std::string>::CHUNK_CAPACITY;
+
+    for ( int i = 0; i < 4000; ++i ) {
+        std::string value = std::to_string( i%5 ) + std::string( 30, 'v' );
+        list.push_back( value );
+        expected.push_back( value );
+    }
+
+    for ( int k = 0; k < 4; ++k ) {
+        std::string value = std::to_string( k ) + std::string( 30, 'v' );
+        CHECK( list.erase( value ) == 800 );
+
+        for ( std::deque<std::string>::iterator itr = expected.begin(); itr != expected.end(); ) {
+            itr = ( *itr == value ) ? expected.erase( itr ) : itr + 1;
+        }
+
+        CHECK( chunks_merged( list ) );
+        CHECK( same_values( list, expected ) );
+    }
+
+    CHECK( list.size() == 800 );
+    CHECK( list.chunks() <= 2*( 800 + capacity - 1 )/capacity );
+
+    list.push_front( "front" );
+    list.push_back( "back" );
+    CHECK( list.front() == "front" && list.back() == "back" );
+
+    list.clear();
+    CHECK( list.empty() && list.chunks() == 0 );
+    CHECK_THROWS( list.pop_front(), underflow );
+}
+
+int main() {
+    test_random_operations();
+    test_merge_after_erase();
+
+    return test_result();
+}
@@ -0,0 +1,340 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "Weighted_graph.h"
+
+namespace {
+    // About one pair in eight is an edge, with weights from 0.01 to 1.
+    void fill( Weighted_graph &graph, int vertices ) {
+        std::mt19937 generator( 7 );
+        std::uniform_int_distribution<int> vertex( 0, vertices - 1 );
+        std::uniform_real_distribution<double> weight( 0.01, 1 );
+
+        for ( int i = 0; i < vertices*vertices/16; ++i ) {
+            int m = vertex( generator );
+            int n = vertex( generator );
+
+            if ( m != n ) {
+                graph.insert( m, n, weight( generator ) );
+            }
+        }
+    }
+}
+
+/* The parallel distances are identical to the sequential ones for any number of threads and
+ * any delta. 512 vertices make the phases of a large delta big enough for several threads
+ * (see PARALLEL_GRAIN), and 10^-300 would overflow the bucket numbers if it were not raised. */
+void test_distances_match_dijkstra() {
+    int const vertices = 512;
+    Weighted_graph graph( vertices );
+    fill( graph, vertices );
+
+    std::vector<double> expected( vertices );
+
+    for ( int n = 0; n < vertices; ++n ) {
+        expected[n] = graph.distance( 0, n );
+    }
+
+    double const deltas[] = {0, 1e-300, 0.05, 1e9};
+
+    for ( double delta : deltas ) {
+        for ( int threads = 1; threads <= 8; threads *= 2 ) {
+            CHECK( graph.distances( 0, threads, delta ) == expected );
+        }
+    }
+}
+
+// Unreachable vertices are INF, and the distances are cached for distance().
+void test_disconnected() {
+    Weighted_graph graph( 6 );
+    graph.insert( 0, 1, 2 );
+    graph.insert( 1, 2, 3 );
+    graph.insert( 3, 4, 1 );
+
+    std::vector<double> result = graph.distances( 0, 4, 1e-300 );
+    double const INF = std::numeric_limits<double>::infinity();
+
+    CHECK( result[2] == 5 );
+    CHECK( result[3] == INF );
+    CHECK( result[5] == INF );
+    CHECK( graph.distance( 2, 0 ) == 5 );
+}
+
+void test_rejected_arguments() {
+    Weighted_graph graph( 4 );
+    graph.insert( 0, 1, 1 );
+
+    CHECK_THROWS( graph.distances( 0, 1, -1 ), illegal_argument );
+    CHECK_THROWS( graph.distances( 0, 1, std::numeric_limits<double>::infinity() ), illegal_argument );
+    CHECK_THROWS( graph.distances( 0, 1, std::nan( "" ) ), illegal_argument );
+    CHECK_THROWS( graph.distances( 0, -1, 1 ), illegal_argument );
+    CHECK_THROWS( graph.distances( 4, 1, 1 ), illegal_argument );
+}
+
+// Staged updates change nothing until apply_epoch(), which applies them in arrival order.
+void test_staged_updates() {
+    Weighted_graph graph( 5 );
+    double const INF = std::numeric_limits<double>::infinity();
+
+    graph.insert( 0, 1, 1 );
+    graph.insert( 1, 2, 1 );
+    CHECK( graph.distance( 0, 2 ) == 2 );
+    CHECK( graph.apply_epoch() == 0 );
+
+    graph.stage( 0, 2, 0.5 );
+    graph.stage( 3, 4, 7 );
+    graph.stage( 3, 4, 2 );
+    graph.stage( 1, 2, 9 );
+    graph.stage( 1, 2, 3 );
+
+    // The queries still see the graph, and the cached distances, from before.
+    CHECK( graph.staged() == 5 );
+    CHECK( graph.adjacent( 0, 2 ) == INF && graph.adjacent( 3, 4 ) == INF && graph.adjacent( 1, 2 ) == 1 );
+    CHECK( graph.distance( 0, 2 ) == 2 && graph.distance( 2, 0 ) == 2 );
+    CHECK( graph.distance( 3, 4 ) == INF );
+    CHECK( graph.edge_count() == 2 && graph.degree( 3 ) == 0 );
+
+    CHECK( graph.apply_epoch() == 5 );
+    CHECK( graph.staged() == 0 && graph.apply_epoch() == 0 );
+
+    // The last weight staged for an edge wins, and the distances are computed again.
+    CHECK( graph.adjacent( 3, 4 ) == 2 && graph.adjacent( 4, 3 ) == 2 );
+    CHECK( graph.adjacent( 1, 2 ) == 3 );
+    CHECK( graph.edge_count() == 4 && graph.degree( 3 ) == 1 && graph.degree( 2 ) == 2 );
+    CHECK( graph.distance( 0, 2 ) == 0.5 && graph.distance( 2, 0 ) == 0.5 );
+    CHECK( graph.distance( 1, 2 ) == 1.5 );
+    CHECK( graph.distance( 3, 4 ) == 2 );
+
+    // Raising a weight lengthens the cached paths as well.
+    graph.stage( 0, 2, 10 );
+    CHECK( graph.distance( 1, 2 ) == 1.5 );
+    CHECK( graph.apply_epoch() == 1 );
+    CHECK( graph.distance( 1, 2 ) == 3 && graph.distance( 0, 2 ) == 4 );
+
+    CHECK_THROWS( graph.stage( 0, 0, 1 ), illegal_argument );
+    CHECK_THROWS( graph.stage( 0, 1, 0 ), illegal_argument );
+    CHECK_THROWS( graph.stage( 0, 5, 1 ), illegal_argument );
+    CHECK( graph.staged() == 0 );
+}
+
+// Any number of threads may stage at once; every update lands in the next epoch.
+void test_concurrent_staging() {
+    int const vertices = 64;
+    Weighted_graph graph( vertices );
+    std::vector<std::thread> producers;
+
+    for ( int t = 0; t < 4; ++t ) {
+        producers.emplace_back( [&graph, t] {
+            for ( int i = 0; i < 1000; ++i ) {
+                graph.stage( t, 4 + i%( vertices - 4 ), 1 + t );
+            }
+        } );
+    }
+
+    for ( std::thread &producer : producers ) {
+        producer.join();
+    }
+
+    CHECK( graph.apply_epoch() == 4000 );
+    CHECK( graph.edge_count() == 4*( vertices - 4 ) );
+    CHECK( graph.adjacent( 2, 10 ) == 3 && graph.distance( 0, 1 ) == 3 );
+}
+
+namespace {
+    double total_weight( std::vector<Weighted_graph::Edge> const &forest ) {
+        double total = 0;
+
+        for ( Weighted_graph::Edge const &edge : forest ) {
+            total += edge.w;
+        }
+
+        return total;
+    }
+
+    // The weight of a minimum spanning forest by Prim's algorithm, from every unreached vertex.
+    double prim_weight( Weighted_graph const &graph, int vertices ) {
+        double const INF = std::numeric_limits<double>::infinity();
+        std::vector<double> cost( vertices, INF );
+        std::vector<bool> reached( vertices, false );
+        double total = 0;
+
+        for ( int i = 0; i < vertices; ++i ) {
+            int next = -1;
+
+            for ( int v = 0; v < vertices; ++v ) {
+                if ( !reached[v] && ( next == -1 || cost[v] < cost[next] ) ) {
+                    next = v;
+                }
+            }
+
+            reached[next] = true;
+            total += ( cost[next] == INF ) ? 0 : cost[next];
+
+            for ( int v = 0; v < vertices; ++v ) {
+                if ( !reached[v] && graph.adjacent( next, v ) < cost[v] ) {
+                    cost[v] = graph.adjacent( next, v );
+                }
+            }
+        }
+
+        return total;
+    }
+
+    /* Returns true if labels are the connected components of the graph: found by a search
+     * from every unlabelled vertex, and numbered in the order of their smallest vertices. */
+    bool right_components( Weighted_graph const &graph, int vertices, std::vector<int> const &labels, int count ) {
+        double const INF = std::numeric_limits<double>::infinity();
+        std::vector<int> expected( vertices, -1 );
+        int next_label = 0;
+
+        for ( int i = 0; i < vertices; ++i ) {
+            if ( expected[i] != -1 ) {
+                continue;
+            }
+
+            std::vector<int> stack( 1, i );
+            expected[i] = next_label;
+
+            while ( !stack.empty() ) {
+                int u = stack.back();
+                stack.pop_back();
+
+                for ( int v = 0; v < vertices; ++v ) {
+                    if ( expected[v] == -1 && graph.adjacent( u, v ) != INF ) {
+                        expected[v] = next_label;
+                        stack.push_back( v );
+                    }
+                }
+            }
+
+            ++next_label;
+        }
+
+        return ( labels == expected && count == next_label );
+    }
+}
+
+/* Kruskal's and Borůvka's forests are the same, edge for edge, with 1, 2 and 8 threads (1024
+ * vertices give 8 threads enough of the matrix each, see PARALLEL_GRAIN), and weigh what Prim's
+ * algorithm finds. The weights are small integers, so many edges tie. The vertices are split
+ * into three groups with no edges between them, plus isolated vertices, so the result is a
+ * forest of V - component_count() edges. */
+void test_spanning_forest() {
+    int const vertices = 1024;
+    Weighted_graph graph( vertices );
+    std::mt19937 generator( 50 );
+    std::uniform_int_distribution<int> vertex( 0, vertices - 1 );
+    std::uniform_int_distribution<int> weight( 1, 8 );
+
+    for ( int i = 0; i < 40000; ++i ) {
+        int m = vertex( generator );
+        int n = vertex( generator );
+
+        if ( m != n && m/300 == n/300 && m < 900 && n < 900 ) {
+            graph.insert( m, n, weight( generator ) );
+        }
+    }
+
+    CHECK( graph.component_count() == 3 + ( vertices - 900 ) );
+
+    std::vector<Weighted_graph::Edge> kruskal = graph.minimum_spanning_tree();
+    CHECK( static_cast<int>( kruskal.size() ) == vertices - graph.component_count() );
+    CHECK( total_weight( kruskal ) == prim_weight( graph, vertices ) );
+
+    int const thread_counts[] = {1, 2, 8};
+
+    for ( int threads : thread_counts ) {
+        std::vector<Weighted_graph::Edge> boruvka = graph.parallel_minimum_spanning_tree( threads );
+        bool same = ( boruvka.size() == kruskal.size() );
+
+        for ( std::size_t i = 0; same && i < kruskal.size(); ++i ) {
+            same = ( boruvka[i].m == kruskal[i].m && boruvka[i].n == kruskal[i].n && boruvka[i].w == kruskal[i].w );
+        }
+
+        CHECK( same );
+        CHECK( total_weight( boruvka ) == total_weight( kruskal ) );
+    }
+
+    // Without edges the forest is empty.
+    Weighted_graph isolated( 7 );
+    CHECK( isolated.minimum_spanning_tree().empty() );
+    CHECK( isolated.parallel_minimum_spanning_tree( 8 ).empty() );
+    CHECK_THROWS( isolated.parallel_minimum_spanning_tree( -1 ), illegal_argument );
+}
+
+/* The components follow every insertion and every epoch, and distance() between two of them
+ * is INF without a search. Re-weighting an edge does not change them. */
+void test_components() {
+    int const vertices = 40;
+    Weighted_graph graph( vertices );
+    double const INF = std::numeric_limits<double>::infinity();
+    std::mt19937 generator( 500 );
+    std::uniform_int_distribution<int> vertex( 0, vertices - 1 );
+
+    CHECK( graph.component_count() == vertices );
+    CHECK( right_components( graph, vertices, graph.connected_components(), graph.component_count() ) );
+
+    for ( int i = 0; i < 60; ++i ) {
+        int m = vertex( generator );
+        int n = vertex( generator );
+
+        if ( m == n ) {
+            continue;
+        }
+
+        if ( i%2 == 0 ) {
+            graph.insert( m, n, 1 + i );
+        } else {
+            graph.stage( m, n, 1 + i );
+            graph.stage( m, n, 2 + i );
+            CHECK( graph.apply_epoch() == 2 );
+        }
+
+        std::vector<int> labels = graph.connected_components();
+        CHECK( right_components( graph, vertices, labels, graph.component_count() ) );
+
+        for ( int v = 0; v < vertices; ++v ) {
+            CHECK( ( graph.distance( 0, v ) == INF ) == ( labels[v] != labels[0] ) );
+        }
+    }
+
+    // A staged edge joins two components only once its epoch is applied.
+    std::vector<int> labels = graph.connected_components();
+    int other = 0;
+
+    while ( other < vertices - 1 && labels[other] == labels[0] ) {
+        ++other;
+    }
+
+    CHECK( labels[other] != labels[0] );
+    int count = graph.component_count();
+    graph.stage( 0, other, 5 );
+    CHECK( graph.component_count() == count && graph.distance( 0, other ) == INF );
+
+    graph.apply_epoch();
+    CHECK( graph.component_count() == count - 1 && graph.distance( 0, other ) == 5 );
+    CHECK( right_components( graph, vertices, graph.connected_components(), graph.component_count() ) );
+
+    graph.insert( 0, other, 3 );
+    CHECK( graph.component_count() == count - 1 && graph.distance( 0, other ) == 3 );
+}
+
+int main() {
+    test_distances_match_dijkstra();
+    test_disconnected();
+    test_rejected_arguments();
+    test_staged_updates();
+    test_concurrent_staging();
+    test_spanning_forest();
+    test_components();
+
+    return test_result();
+}
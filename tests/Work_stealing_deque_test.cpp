@@ -0,0 +1,193 @@
+/****************************************
+ *  Copyright © 2018 Arnoldo Rodriguez  *
+ ****************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Test.h"
+#include "Work_stealing_deque.h"
+
+/* The owner pushes n values in bursts, popping some of them back as it goes, while the
+ * thieves take values from the front. The deque starts with room for 2 values, so it grows
+ * (and retires the smaller rings) again and again while thieves read them. Every value is
+ * taken exactly once, by the owner or by a thief, and the owner pops its own values newest
+ * first. */
+void test_owner_and_thieves( int thieves ) {
+    long const n = 50000;
+    std::vector<std::atomic<int> > seen( n );
+    std::atomic<long> taken( 0 );
+    std::atomic<bool> newest_first( true );
+
+    for ( long i = 0; i < n; ++i ) {
+        seen[i].store( 0 );
+    }
+
+    Work_stealing_deque<long> deque( 2 );
+    std::vector<std::thread> threads;
+
+    for ( int t = 0; t < thieves; ++t ) {
+        threads.emplace_back( [&] {
+            long value;
+
+            while ( taken.load() < n ) {
+                if ( deque.pop_front( value ) ) {
+                    seen[value].fetch_add( 1 );
+                    taken.fetch_add( 1 );
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        } );
+    }
+
+    long next = 0;
+    long value;
+
+    while ( next < n ) {
+        // A burst of up to 64 values, then a few popped back. Yielding in the middle lets
+        // the thieves in even on a single core.
+        for ( long end = next + 1 + next%64; next < end && next < n; ++next ) {
+            deque.push_back( next );
+
+            if ( next%16 == 0 ) {
+                std::this_thread::yield();
+            }
+        }
+
+        long last = next;
+
+        for ( int i = 0; i < 3 && deque.pop_back( value ); ++i ) {
+            if ( value >= last ) {
+                newest_first.store( false );
+            }
+
+            last = value;
+            seen[value].fetch_add( 1 );
+            taken.fetch_add( 1 );
+        }
+    }
+
+    while ( deque.pop_back( value ) ) {
+        seen[value].fetch_add( 1 );
+        taken.fetch_add( 1 );
+    }
+
+    for ( std::size_t i = 0; i < threads.size(); ++i ) {
+        threads[i].join();
+    }
+
+    bool exactly_once = true;
+
+    for ( long i = 0; i < n; ++i ) {
+        exactly_once &= ( seen[i].load() == 1 );
+    }
+
+    CHECK( exactly_once );
+    CHECK( taken.load() == n );
+    CHECK( newest_first.load() );
+    CHECK( deque.empty() && !deque.pop_front( value ) && !deque.pop_back( value ) );
+}
+
+/* The owner pushes one value at a time and pops it back (yielding first every other round)
+ * while the thieves keep trying to steal it, so every round is a race for the last value.
+ * Exactly one side gets it. */
+void test_last_value_race( int thieves ) {
+    long const rounds = 20000;
+    std::vector<std::atomic<int> > seen( rounds );
+    std::atomic<bool> done( false );
+    std::atomic<long> stolen( 0 );
+
+    for ( long i = 0; i < rounds; ++i ) {
+        seen[i].store( 0 );
+    }
+
+    Work_stealing_deque<long> deque( 1 );
+    std::vector<std::thread> threads;
+
+    for ( int t = 0; t < thieves; ++t ) {
+        threads.emplace_back( [&] {
+            long value;
+
+            while ( !done.load() ) {
+                if ( deque.pop_front( value ) ) {
+                    seen[value].fetch_add( 1 );
+                    stolen.fetch_add( 1 );
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        } );
+    }
+
+    long kept = 0;
+
+    for ( long round = 0; round < rounds; ++round ) {
+        long value = -1;
+        deque.push_back( round );
+
+        if ( round%2 == 1 ) {
+            std::this_thread::yield();
+        }
+
+        if ( deque.pop_back( value ) ) {
+            CHECK( value == round );
+            seen[value].fetch_add( 1 );
+            ++kept;
+        }
+
+        // The value is gone either way before the next round starts.
+        while ( seen[round].load() == 0 ) {
+            std::this_thread::yield();
+        }
+    }
+
+    done.store( true );
+
+    for ( std::size_t i = 0; i < threads.size(); ++i ) {
+        threads[i].join();
+    }
+
+    bool exactly_once = true;
+
+    for ( long i = 0; i < rounds; ++i ) {
+        exactly_once &= ( seen[i].load() == 1 );
+    }
+
+    CHECK( exactly_once );
+    CHECK( kept + stolen.load() == rounds );
+}
+
+// Alone, the owner sees a stack and the front end sees a queue, across many doublings.
+void test_single_thread() {
+    Work_stealing_deque<int> deque( 3 );
+    int value = -1;
+
+    CHECK( deque.empty() && !deque.pop_back( value ) && !deque.pop_front( value ) && value == -1 );
+
+    for ( int i = 0; i < 10000; ++i ) {
+        deque.push_back( i );
+    }
+
+    CHECK( deque.size() == 10000 );
+
+    for ( int i = 0; i < 5000; ++i ) {
+        CHECK( deque.pop_front( value ) && value == i );
+        CHECK( deque.pop_back( value ) && value == 9999 - i );
+    }
+
+    CHECK( deque.empty() );
+    CHECK_THROWS( Work_stealing_deque<int>( 0 ), illegal_argument );
+}
+
+int main() {
+    test_single_thread();
+
+    for ( int thieves = 1; thieves <= 32; thieves *= 2 ) {
+        test_owner_and_thieves( thieves );
+        test_last_value_race( thieves );
+    }
+
+    return test_result();
+}